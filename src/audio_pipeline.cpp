@@ -1,6 +1,7 @@
 #include "audio_pipeline.h"
 #include "ffmpeg_context.h"
 #include "logger.h"
+#include "codec_compat.h"
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -8,6 +9,12 @@ extern "C" {
 #include <libavutil/opt.h>
 }
 
+#include <algorithm>
+
+namespace {
+    constexpr int CONVERT_MARGIN_SAMPLES = 256;  // Headroom over in->nb_samples for samples the resampler buffered
+}
+
 AudioPipeline::AudioPipeline(std::shared_ptr<FFmpegContext> ctx)
     : ffmpeg_(std::move(ctx)) {
 }
@@ -15,7 +22,8 @@ AudioPipeline::AudioPipeline(std::shared_ptr<FFmpegContext> ctx)
 AudioPipeline::~AudioPipeline() = default;
 
 bool AudioPipeline::setupEncoder(AVStream* inStream, AVStream* outStream,
-                                  int audioStreamIndex, AVFormatContext* inputFormatCtx) {
+                                  int audioStreamIndex, AVFormatContext* inputFormatCtx,
+                                  SegmentFormat format) {
     if (!ffmpeg_ || !ffmpeg_->isInitialized()) {
         Logger::error("FFmpegContext not initialized");
         return false;
@@ -25,9 +33,9 @@ bool AudioPipeline::setupEncoder(AVStream* inStream, AVStream* outStream,
     inputFormatCtx_ = inputFormatCtx;
     inputCodecId_ = inStream->codecpar->codec_id;
 
-    // Decide strategy: Remux AAC or Transcode to AAC
-    if (inputCodecId_ == AV_CODEC_ID_AAC) {
-        Logger::info("Audio is AAC - will REMUX (copy without transcoding)");
+    // Decide strategy: Remux HLS-compatible audio or Transcode to AAC
+    if (CodecCompat::canCopyAudio(inputCodecId_, format)) {
+        Logger::info("Audio codec ID " + std::to_string(inputCodecId_) + " is HLS-compatible - will REMUX (copy without transcoding)");
         needsTranscoding_ = false;
 
         // Copy codec parameters for remux
@@ -39,8 +47,8 @@ bool AudioPipeline::setupEncoder(AVStream* inStream, AVStream* outStream,
         return true;
     }
 
-    // Non-AAC audio: TRANSCODE to AAC
-    Logger::warn("Audio codec ID " + std::to_string(inputCodecId_) + " (non-AAC) - will TRANSCODE to AAC");
+    // Other audio: TRANSCODE to AAC
+    Logger::warn("Audio codec ID " + std::to_string(inputCodecId_) + " is not HLS-compatible - will TRANSCODE to AAC");
     needsTranscoding_ = true;
 
     // FIRST: Open audio decoder
@@ -62,6 +70,9 @@ bool AudioPipeline::setupEncoder(AVStream* inStream, AVStream* outStream,
         return false;
     }
 
+    // Audio decodes far faster than real time: no thread pool per channel
+    inputCodecCtx_->thread_count = 1;
+
     if (ffmpeg_->avcodec_open2(inputCodecCtx_.get(), audioDecoder, nullptr) < 0) {
         Logger::error("Failed to open audio decoder");
         return false;
@@ -141,13 +152,18 @@ bool AudioPipeline::setupEncoder(AVStream* inStream, AVStream* outStream,
 
     swrCtx_ = std::unique_ptr<SwrContext, SwrContextDeleter>(swrCtxRaw, SwrContextDeleter(ffmpeg_));
 
-    // Allocate cached frame for conversion
+    // Allocate cached frames/packet so steady-state transcoding does not allocate
     convertedFrame_ = std::unique_ptr<AVFrame, AVFrameDeleter>(
         ffmpeg_->av_frame_alloc(), AVFrameDeleter(ffmpeg_));
-    if (!convertedFrame_) {
+    decodedFrame_ = std::unique_ptr<AVFrame, AVFrameDeleter>(
+        ffmpeg_->av_frame_alloc(), AVFrameDeleter(ffmpeg_));
+    encodedPacket_ = std::unique_ptr<AVPacket, AVPacketDeleter>(
+        ffmpeg_->av_packet_alloc(), AVPacketDeleter(ffmpeg_));
+    if (!convertedFrame_ || !decodedFrame_ || !encodedPacket_) {
         Logger::error("Failed to allocate converted audio frame");
         return false;
     }
+    convertedCapacity_ = 0;
 
     Logger::info("Audio resampler initialized successfully");
 
@@ -199,14 +215,33 @@ void AudioPipeline::assignPTS(AVFrame* inputFrame, AVFrame* convertedFrame) {
 bool AudioPipeline::processDecodedFrame(AVFrame* audioFrame,
                                          AVFormatContext* outputFormatCtx,
                                          int outputAudioStreamIndex) {
-    // Convert audio format using SwrContext
-    ffmpeg_->av_frame_unref(convertedFrame_.get());
-
-    // Re-configure convertedFrame with output format
-    convertedFrame_->format = outputCodecCtx_->sample_fmt;
-    convertedFrame_->sample_rate = outputCodecCtx_->sample_rate;
-    convertedFrame_->ch_layout = outputCodecCtx_->ch_layout;
-    convertedFrame_->nb_samples = 0;  // Let swr_convert_frame allocate buffer
+    // Convert audio format using SwrContext, into the cached buffers when they are large enough
+    int inRate = audioFrame->sample_rate > 0 ? audioFrame->sample_rate : outputCodecCtx_->sample_rate;
+    int64_t needed = static_cast<int64_t>(audioFrame->nb_samples) * outputCodecCtx_->sample_rate /
+                     std::max(1, inRate) + CONVERT_MARGIN_SAMPLES;
+    if (!convertedFrame_->buf[0] || needed > convertedCapacity_) {
+        ffmpeg_->av_frame_unref(convertedFrame_.get());
+
+        // Re-configure convertedFrame with output format
+        convertedFrame_->format = outputCodecCtx_->sample_fmt;
+        convertedFrame_->sample_rate = outputCodecCtx_->sample_rate;
+        convertedFrame_->ch_layout = outputCodecCtx_->ch_layout;
+        convertedFrame_->nb_samples = static_cast<int>(needed);
+        if (ffmpeg_->av_frame_get_buffer(convertedFrame_.get(), 0) < 0) {
+            Logger::error("Failed to allocate converted audio buffer");
+            convertedCapacity_ = 0;
+            return false;
+        }
+        convertedCapacity_ = static_cast<int>(needed);
+    } else {
+        // swr_convert_frame treats nb_samples as the buffer capacity
+        convertedFrame_->nb_samples = convertedCapacity_;
+        // Copies only if the encoder still references the previous frame
+        if (ffmpeg_->av_frame_make_writable(convertedFrame_.get()) < 0) {
+            Logger::error("Failed to reuse converted audio buffer");
+            return false;
+        }
+    }
 
     int ret = ffmpeg_->swr_convert_frame(swrCtx_.get(), convertedFrame_.get(), audioFrame);
     if (ret < 0) {
@@ -223,12 +258,7 @@ bool AudioPipeline::processDecodedFrame(AVFrame* audioFrame,
         return false;
     }
 
-    AVPacket* outAudioPacket = ffmpeg_->av_packet_alloc();
-    if (!outAudioPacket) {
-        Logger::error("Failed to allocate output audio packet");
-        return false;
-    }
-
+    AVPacket* outAudioPacket = encodedPacket_.get();
     while (ffmpeg_->avcodec_receive_packet(outputCodecCtx_.get(), outAudioPacket) == 0) {
         outAudioPacket->stream_index = outputAudioStreamIndex;
 
@@ -244,7 +274,6 @@ bool AudioPipeline::processDecodedFrame(AVFrame* audioFrame,
 
         ffmpeg_->av_packet_unref(outAudioPacket);
     }
-    ffmpeg_->av_packet_free(&outAudioPacket);
 
     return true;
 }
@@ -255,7 +284,7 @@ bool AudioPipeline::processPacket(AVPacket* packet,
                                    int audioStreamIndex,
                                    int outputAudioStreamIndex) {
     if (!needsTranscoding_) {
-        // Strategy: REMUX - Copy AAC audio without transcoding
+        // Strategy: REMUX - Copy HLS-compatible audio without transcoding
         packet->stream_index = outputAudioStreamIndex;
 
         // Rescale timestamps from input to output timebase
@@ -277,12 +306,7 @@ bool AudioPipeline::processPacket(AVPacket* packet,
         return false;
     }
 
-    AVFrame* audioFrame = ffmpeg_->av_frame_alloc();
-    if (!audioFrame) {
-        Logger::error("Failed to allocate audio frame");
-        return false;
-    }
-
+    AVFrame* audioFrame = decodedFrame_.get();
     bool success = true;
     while (ffmpeg_->avcodec_receive_frame(inputCodecCtx_.get(), audioFrame) == 0) {
         if (!processDecodedFrame(audioFrame, outputFormatCtx, outputAudioStreamIndex)) {
@@ -290,7 +314,6 @@ bool AudioPipeline::processPacket(AVPacket* packet,
         }
         ffmpeg_->av_frame_unref(audioFrame);
     }
-    ffmpeg_->av_frame_free(&audioFrame);
 
     return success;
 }
@@ -305,26 +328,16 @@ bool AudioPipeline::flush(AVFormatContext* outputFormatCtx, int outputAudioStrea
     // Drain audio decoder
     ffmpeg_->avcodec_send_packet(inputCodecCtx_.get(), nullptr);
 
-    AVFrame* audioFrame = ffmpeg_->av_frame_alloc();
-    if (!audioFrame) {
-        Logger::error("Failed to allocate audio frame for flush");
-        return false;
-    }
-
+    AVFrame* audioFrame = decodedFrame_.get();
     while (ffmpeg_->avcodec_receive_frame(inputCodecCtx_.get(), audioFrame) == 0) {
         processDecodedFrame(audioFrame, outputFormatCtx, outputAudioStreamIndex);
         ffmpeg_->av_frame_unref(audioFrame);
     }
-    ffmpeg_->av_frame_free(&audioFrame);
 
     // Drain audio encoder
     ffmpeg_->avcodec_send_frame(outputCodecCtx_.get(), nullptr);
 
-    AVPacket* outAudioPacket = ffmpeg_->av_packet_alloc();
-    if (!outAudioPacket) {
-        Logger::error("Failed to allocate packet for audio encoder flush");
-        return false;
-    }
+    AVPacket* outAudioPacket = encodedPacket_.get();
 
     while (ffmpeg_->avcodec_receive_packet(outputCodecCtx_.get(), outAudioPacket) == 0) {
         outAudioPacket->stream_index = outputAudioStreamIndex;
@@ -336,7 +349,6 @@ bool AudioPipeline::flush(AVFormatContext* outputFormatCtx, int outputAudioStrea
         ffmpeg_->av_interleaved_write_frame(outputFormatCtx, outAudioPacket);
         ffmpeg_->av_packet_unref(outAudioPacket);
     }
-    ffmpeg_->av_packet_free(&outAudioPacket);
 
     Logger::info("Audio pipeline flushed successfully");
     return true;
@@ -347,6 +359,9 @@ void AudioPipeline::reset() {
     outputCodecCtx_.reset();
     swrCtx_.reset();
     convertedFrame_.reset();
+    convertedCapacity_ = 0;
+    decodedFrame_.reset();
+    encodedPacket_.reset();
 
     needsTranscoding_ = false;
     inputCodecId_ = 0;
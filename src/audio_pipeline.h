@@ -4,6 +4,7 @@
 #include <memory>
 #include <cstdint>
 #include "ffmpeg_deleters.h"
+#include "config.h"
 
 class FFmpegContext;
 struct AVStream;
@@ -16,8 +17,10 @@ struct SwrContext;
 /**
  * AudioPipeline - Handles audio processing (REMUX or TRANSCODE to AAC)
  *
+ * Audio is decided on its own: a REMUX video stream may carry transcoded audio.
+ *
  * Responsibilities:
- *   - Detect if audio needs transcoding (non-AAC → AAC)
+ *   - Detect if audio needs transcoding (not copyable into the segments → AAC)
  *   - Setup audio encoder (AAC) and decoder (for transcode)
  *   - Setup SwrContext for audio resampling
  *   - Process audio packets (remux or transcode path)
@@ -48,10 +51,12 @@ public:
      * @param outStream Output audio stream
      * @param audioStreamIndex Index of audio stream in input format context
      * @param inputFormatCtx Input format context (for timebase info)
+     * @param format Segment container (decides which codecs are copied, see CodecCompat)
      * @return true on success
      */
     bool setupEncoder(AVStream* inStream, AVStream* outStream,
-                      int audioStreamIndex, AVFormatContext* inputFormatCtx);
+                      int audioStreamIndex, AVFormatContext* inputFormatCtx,
+                      SegmentFormat format);
 
     /**
      * Process a single audio packet (remux or transcode)
@@ -102,8 +107,13 @@ private:
     // Audio resampler
     std::unique_ptr<SwrContext, SwrContextDeleter> swrCtx_;
 
-    // Cached frame for conversion
+    // Cached frame for conversion (buffers kept between frames, see convertedCapacity_)
     std::unique_ptr<AVFrame, AVFrameDeleter> convertedFrame_;
+    int convertedCapacity_ = 0;  // Samples convertedFrame_'s buffers hold
+
+    // Reused for every decoded frame / encoded packet (mux thread only)
+    std::unique_ptr<AVFrame, AVFrameDeleter> decodedFrame_;
+    std::unique_ptr<AVPacket, AVPacketDeleter> encodedPacket_;
 
     // State
     bool needsTranscoding_ = false;
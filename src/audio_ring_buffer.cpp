@@ -0,0 +1,83 @@
+#include "audio_ring_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    size_t roundUpToPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+}
+
+AudioRingBuffer::AudioRingBuffer(int channels, size_t capacityFrames)
+    : channels_(channels > 0 ? channels : 1)
+    , capacity_(roundUpToPowerOfTwo(capacityFrames > 0 ? capacityFrames : 1))
+    , mask_(capacity_ - 1)
+    , planes_(channels_, std::vector<float>(capacity_, 0.0f)) {
+}
+
+size_t AudioRingBuffer::write(const float* const* planes, int channels, size_t frames) {
+    if (!planes || channels <= 0 || frames == 0) {
+        return 0;
+    }
+
+    uint64_t writePos = writePos_.load(std::memory_order_relaxed);
+    uint64_t readPos = readPos_.load(std::memory_order_acquire);
+    size_t freeFrames = capacity_ - static_cast<size_t>(writePos - readPos);
+    size_t count = std::min(frames, freeFrames);
+    if (count == 0) {
+        return 0;
+    }
+
+    size_t start = static_cast<size_t>(writePos) & mask_;
+    size_t firstPart = std::min(count, capacity_ - start);
+
+    for (int ch = 0; ch < channels_; ch++) {
+        const float* src = planes[std::min(ch, channels - 1)];
+        float* dst = planes_[ch].data();
+        std::memcpy(dst + start, src, firstPart * sizeof(float));
+        if (count > firstPart) {
+            std::memcpy(dst, src + firstPart, (count - firstPart) * sizeof(float));
+        }
+    }
+
+    writePos_.store(writePos + count, std::memory_order_release);
+    return count;
+}
+
+size_t AudioRingBuffer::available() const {
+    uint64_t writePos = writePos_.load(std::memory_order_acquire);
+    uint64_t readPos = readPos_.load(std::memory_order_relaxed);
+    return static_cast<size_t>(writePos - readPos);
+}
+
+bool AudioRingBuffer::read(float* const* planes, int channels, size_t frames) {
+    if (!planes || channels <= 0 || available() < frames) {
+        return false;
+    }
+
+    uint64_t readPos = readPos_.load(std::memory_order_relaxed);
+    size_t start = static_cast<size_t>(readPos) & mask_;
+    size_t firstPart = std::min(frames, capacity_ - start);
+
+    for (int ch = 0; ch < channels; ch++) {
+        const float* src = planes_[std::min(ch, channels_ - 1)].data();
+        float* dst = planes[ch];
+        std::memcpy(dst, src + start, firstPart * sizeof(float));
+        if (frames > firstPart) {
+            std::memcpy(dst + firstPart, src, (frames - firstPart) * sizeof(float));
+        }
+    }
+
+    readPos_.store(readPos + frames, std::memory_order_release);
+    return true;
+}
+
+void AudioRingBuffer::discard(size_t frames) {
+    size_t count = std::min(frames, available());
+    readPos_.store(readPos_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+}
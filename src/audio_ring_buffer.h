@@ -0,0 +1,93 @@
+#ifndef AUDIO_RING_BUFFER_H
+#define AUDIO_RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * AudioRingBuffer - Preallocated lock-free SPSC ring of planar float samples
+ *
+ * One plane per channel, sized once at construction (capacity rounded up to a
+ * power of two), so steady-state operation never allocates. The producer (CEF
+ * audio thread) copies each incoming plane with at most two memcpy calls; the
+ * consumer (encoder) copies exactly the number of frames it needs straight into
+ * the encoder's planar frame. Samples are never interleaved.
+ *
+ * Channel mapping happens on copy: a source with fewer channels than the ring
+ * is duplicated (mono → both planes), extra source channels are dropped; reads
+ * into fewer planes than the ring has take the first ones.
+ *
+ * Thread-safety: One producer thread (write) and one consumer thread
+ * (available/read/discard/clear)
+ */
+class AudioRingBuffer {
+public:
+    /**
+     * @param channels Number of planes
+     * @param capacityFrames Minimum capacity in samples per channel
+     */
+    AudioRingBuffer(int channels, size_t capacityFrames);
+
+    // No copy, no move (shared between two threads by reference)
+    AudioRingBuffer(const AudioRingBuffer&) = delete;
+    AudioRingBuffer& operator=(const AudioRingBuffer&) = delete;
+
+    // ===== Producer side =====
+
+    /**
+     * Append planar samples; frames that do not fit are dropped
+     * @param planes Source channel planes
+     * @param channels Number of source planes
+     * @param frames Samples per plane
+     * @return Number of frames written
+     */
+    size_t write(const float* const* planes, int channels, size_t frames);
+
+    // ===== Consumer side =====
+
+    /**
+     * Number of frames ready to be read
+     */
+    size_t available() const;
+
+    /**
+     * Copy and consume exactly `frames` samples per plane
+     * @param planes Destination channel planes
+     * @param channels Number of destination planes
+     * @param frames Samples per plane
+     * @return false if fewer than `frames` are available (nothing consumed)
+     */
+    bool read(float* const* planes, int channels, size_t frames);
+
+    /**
+     * Drop up to `frames` samples per plane without copying
+     */
+    void discard(size_t frames);
+
+    /**
+     * Drop everything currently buffered
+     */
+    void clear() { discard(available()); }
+
+    /**
+     * Total frames ever written / consumed (sample positions for timestamping)
+     */
+    uint64_t writePosition() const { return writePos_.load(std::memory_order_acquire); }
+    uint64_t readPosition() const { return readPos_.load(std::memory_order_acquire); }
+
+    int getChannels() const { return channels_; }
+    size_t getCapacity() const { return capacity_; }
+
+private:
+    const int channels_;
+    const size_t capacity_;  // Power of two
+    const size_t mask_;
+    std::vector<std::vector<float>> planes_;
+
+    std::atomic<uint64_t> writePos_{0};  // Total frames written (producer-owned)
+    std::atomic<uint64_t> readPos_{0};   // Total frames read (consumer-owned)
+};
+
+#endif // AUDIO_RING_BUFFER_H
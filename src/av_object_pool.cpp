@@ -0,0 +1,168 @@
+#include "av_object_pool.h"
+#include "ffmpeg_context.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+}
+
+#include <mutex>
+#include <vector>
+
+struct AVObjectPool::Recycler::State {
+    std::shared_ptr<FFmpegContext> ffmpeg;
+    std::mutex mutex;
+    bool closed = false;                 // Pool destroyed: returned objects are freed
+    std::vector<AVPacket*> packets;
+    std::vector<AVFrame*> frames;
+    std::vector<AVFrame*> bufferedFrames;
+    size_t packetsOut = 0;               // Handed out, not yet returned
+    size_t framesOut = 0;
+    size_t bufferedFramesOut = 0;
+    Stats stats;
+};
+
+namespace {
+    /**
+     * Make room for every object that can come back, so release never allocates
+     * @param freeList Free list of the pool
+     * @param outstanding Objects currently handed out
+     */
+    template <typename T>
+    void reserveReturns(std::vector<T*>& freeList, size_t outstanding) {
+        if (freeList.capacity() < freeList.size() + outstanding) {
+            freeList.reserve((freeList.size() + outstanding) * 2);
+        }
+    }
+}
+
+void AVObjectPool::Recycler::operator()(AVPacket* packet) const {
+    if (!packet) {
+        return;
+    }
+    state_->ffmpeg->av_packet_unref(packet);
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->packetsOut--;
+    if (state_->closed) {
+        state_->ffmpeg->av_packet_free(&packet);
+        return;
+    }
+    state_->packets.push_back(packet);
+}
+
+void AVObjectPool::Recycler::operator()(AVFrame* frame) const {
+    if (!frame) {
+        return;
+    }
+    if (!keepBuffers_ || unrefOnReturn_) {
+        state_->ffmpeg->av_frame_unref(frame);
+    }
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (keepBuffers_) {
+        state_->bufferedFramesOut--;
+    } else {
+        state_->framesOut--;
+    }
+    if (state_->closed) {
+        state_->ffmpeg->av_frame_free(&frame);
+        return;
+    }
+    (keepBuffers_ ? state_->bufferedFrames : state_->frames).push_back(frame);
+}
+
+AVObjectPool::AVObjectPool(std::shared_ptr<FFmpegContext> ctx)
+    : state_(std::make_shared<Recycler::State>()) {
+    state_->ffmpeg = std::move(ctx);
+}
+
+AVObjectPool::~AVObjectPool() {
+    if (!state_) {
+        return;  // Moved from
+    }
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->closed = true;
+    for (AVPacket* packet : state_->packets) {
+        state_->ffmpeg->av_packet_free(&packet);
+    }
+    for (AVFrame* frame : state_->frames) {
+        state_->ffmpeg->av_frame_free(&frame);
+    }
+    for (AVFrame* frame : state_->bufferedFrames) {
+        state_->ffmpeg->av_frame_free(&frame);
+    }
+    state_->packets.clear();
+    state_->frames.clear();
+    state_->bufferedFrames.clear();
+}
+
+AVObjectPool::PacketPtr AVObjectPool::acquirePacket() {
+    Recycler::State& state = *state_;
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    AVPacket* packet = nullptr;
+    if (!state.packets.empty()) {
+        packet = state.packets.back();
+        state.packets.pop_back();
+        state.stats.reused++;
+    } else {
+        packet = state.ffmpeg->av_packet_alloc();
+        if (!packet) {
+            return PacketPtr(nullptr, Recycler(state_, false));
+        }
+        state.stats.packetsAllocated++;
+    }
+    state.packetsOut++;
+    reserveReturns(state.packets, state.packetsOut);
+    return PacketPtr(packet, Recycler(state_, false));
+}
+
+AVObjectPool::FramePtr AVObjectPool::acquireFrame() {
+    Recycler::State& state = *state_;
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    AVFrame* frame = nullptr;
+    if (!state.frames.empty()) {
+        frame = state.frames.back();
+        state.frames.pop_back();
+        state.stats.reused++;
+    } else {
+        frame = state.ffmpeg->av_frame_alloc();
+        if (!frame) {
+            return FramePtr(nullptr, Recycler(state_, false));
+        }
+        state.stats.framesAllocated++;
+    }
+    state.framesOut++;
+    reserveReturns(state.frames, state.framesOut);
+    return FramePtr(frame, Recycler(state_, false));
+}
+
+AVObjectPool::FramePtr AVObjectPool::acquireBufferedFrame() {
+    Recycler::State& state = *state_;
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    AVFrame* frame = nullptr;
+    if (!state.bufferedFrames.empty()) {
+        // Oldest returned first: the encoder is least likely to still reference its buffers
+        frame = state.bufferedFrames.front();
+        state.bufferedFrames.erase(state.bufferedFrames.begin());
+        state.stats.reused++;
+    } else {
+        frame = state.ffmpeg->av_frame_alloc();
+        if (!frame) {
+            return FramePtr(nullptr, Recycler(state_, true));
+        }
+        state.stats.framesAllocated++;
+    }
+    state.bufferedFramesOut++;
+    reserveReturns(state.bufferedFrames, state.bufferedFramesOut);
+    return FramePtr(frame, Recycler(state_, true));
+}
+
+AVObjectPool::Stats AVObjectPool::getStats() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->stats;
+}
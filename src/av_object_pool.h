@@ -0,0 +1,98 @@
+#ifndef AV_OBJECT_POOL_H
+#define AV_OBJECT_POOL_H
+
+#include <cstdint>
+#include <memory>
+
+class FFmpegContext;
+struct AVPacket;
+struct AVFrame;
+
+/**
+ * AVObjectPool - Recycles AVPacket/AVFrame objects in the transcode hot loop
+ *
+ * acquirePacket()/acquireFrame() hand out objects that go back to the pool
+ * (instead of av_*_free) when their pointer is released, so once the pipeline
+ * has filled up, no packets or frames are allocated. Referencing data still
+ * allocates a small AVBufferRef per buffer (av_frame_ref/av_packet_ref).
+ * Packets and plain frames are unreferenced on return (their data comes from
+ * the decoder's/encoder's own buffer pools); frames from acquireBufferedFrame()
+ * keep their buffers, which makes them a ring of preallocated output frames
+ * (e.g. scaled frames): the user only re-allocates when the format or size
+ * changed, and calls av_frame_make_writable() in case an encoder still holds
+ * a reference. A buffered frame that borrowed another frame's buffers is
+ * marked with unrefOnReturn(), so the pool does not keep them alive.
+ *
+ * The pool's state is shared with every handed-out object, so objects may
+ * outlive the pool (they are freed on return then).
+ *
+ * Thread-safety: acquire/release from any thread (one mutex per pool)
+ */
+class AVObjectPool {
+public:
+    struct Stats {
+        uint64_t packetsAllocated = 0;  // av_packet_alloc calls (pool growth)
+        uint64_t framesAllocated = 0;   // av_frame_alloc calls (pool growth)
+        uint64_t reused = 0;            // Objects handed out again instead of allocated
+    };
+
+    class Recycler {
+    public:
+        Recycler() = default;
+
+        void operator()(AVPacket* packet) const;
+        void operator()(AVFrame* frame) const;
+
+        /**
+         * Unreference the frame's buffers on return even if the pool keeps buffers
+         * (they belong to someone else, e.g. a decoder frame passed through)
+         */
+        void unrefOnReturn() { unrefOnReturn_ = true; }
+
+    private:
+        friend class AVObjectPool;
+        struct State;
+        Recycler(std::shared_ptr<State> state, bool keepBuffers) : state_(std::move(state)), keepBuffers_(keepBuffers) {}
+
+        std::shared_ptr<State> state_;
+        bool keepBuffers_ = false;
+        bool unrefOnReturn_ = false;
+    };
+
+    using PacketPtr = std::unique_ptr<AVPacket, Recycler>;
+    using FramePtr = std::unique_ptr<AVFrame, Recycler>;
+
+    explicit AVObjectPool(std::shared_ptr<FFmpegContext> ctx);
+    ~AVObjectPool();
+
+    AVObjectPool(AVObjectPool&&) = default;
+    AVObjectPool& operator=(AVObjectPool&&) = default;
+
+    /**
+     * Empty packet (unreferenced when returned)
+     * @return Packet, or nullptr if allocation failed
+     */
+    PacketPtr acquirePacket();
+
+    /**
+     * Empty frame (unreferenced when returned)
+     * @return Frame, or nullptr if allocation failed
+     */
+    FramePtr acquireFrame();
+
+    /**
+     * Frame that kept the buffers of its previous use (empty when new)
+     * @return Frame, or nullptr if allocation failed
+     */
+    FramePtr acquireBufferedFrame();
+
+    /**
+     * Snapshot of the allocation counters
+     */
+    Stats getStats() const;
+
+private:
+    std::shared_ptr<Recycler::State> state_;
+};
+
+#endif // AV_OBJECT_POOL_H
@@ -0,0 +1,80 @@
+#include "av_sync.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr double CORRECTION_START_MS = 10.0;  // Start resampling beyond this drift...
+    constexpr double CORRECTION_STOP_MS = 2.0;    // ...and stop once back within this
+    constexpr double RESYNC_MS = 200.0;           // Larger offsets are fixed at once
+    constexpr int MAX_CORRECTION_DIVISOR = 256;   // At most frameSize / 256 samples per frame
+    constexpr double DRIFT_SMOOTHING = 0.05;      // Weight of a new measurement (~20 frames)
+}
+
+void AVSync::start(int sampleRate, Clock::time_point origin) {
+    sampleRate_ = sampleRate > 0 ? sampleRate : 48000;
+    origin_ = origin;
+    started_ = true;
+    aligned_ = false;
+    correcting_ = false;
+    driftMs_ = 0.0;
+    smoothedDriftMs_ = 0.0;
+    stats_ = Stats();
+    driftSumMs_ = 0.0;
+}
+
+AVSync::Plan AVSync::plan(int64_t stampedSamples, Clock::time_point captureTime, int frameSize) {
+    Plan plan;
+    plan.consume = frameSize;
+    if (!started_) {
+        return plan;
+    }
+
+    double mediaMs = std::chrono::duration<double, std::milli>(captureTime - origin_).count();
+    double stampedMs = static_cast<double>(stampedSamples) * 1000.0 / sampleRate_;
+    driftMs_ = stampedMs - mediaMs;
+
+    if (!aligned_ || std::abs(driftMs_) > RESYNC_MS) {
+        // Place the next sample exactly: drop audio that is late, leave a gap for audio that is early
+        int64_t offset = std::llround(driftMs_ * sampleRate_ / 1000.0);
+        if (offset > 0) {
+            plan.discard = offset;
+        } else {
+            plan.ptsJump = -offset;
+        }
+        if (aligned_) {
+            stats_.resyncs++;
+        }
+        aligned_ = true;
+        correcting_ = false;
+        smoothedDriftMs_ = 0.0;
+        return plan;
+    }
+
+    stats_.frames++;
+    driftSumMs_ += driftMs_;
+    stats_.maxDriftMs = std::max(stats_.maxDriftMs, std::abs(driftMs_));
+
+    smoothedDriftMs_ += DRIFT_SMOOTHING * (driftMs_ - smoothedDriftMs_);
+    if (!correcting_ && std::abs(smoothedDriftMs_) > CORRECTION_START_MS) {
+        correcting_ = true;
+    } else if (correcting_ && std::abs(smoothedDriftMs_) < CORRECTION_STOP_MS) {
+        correcting_ = false;
+    }
+
+    if (correcting_) {
+        // Audio late: squeeze a few extra samples into the frame; early: stretch fewer
+        int step = std::max(1, frameSize / MAX_CORRECTION_DIVISOR);
+        plan.consume = smoothedDriftMs_ > 0 ? frameSize + step : frameSize - step;
+        stats_.correctedSamples += step;
+    }
+    return plan;
+}
+
+AVSync::Stats AVSync::takeStats() {
+    Stats stats = stats_;
+    stats.averageDriftMs = stats.frames > 0 ? driftSumMs_ / stats.frames : 0.0;
+    stats_ = Stats();
+    driftSumMs_ = 0.0;
+    return stats;
+}
@@ -0,0 +1,97 @@
+#ifndef AV_SYNC_H
+#define AV_SYNC_H
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * AVSync - Keeps browser audio locked to the video frame clock
+ *
+ * Video frame N is stamped N / fps and produced at the frame pacer's deadline
+ * start + N / fps, so the pacer's steady_clock origin is media time 0. Audio
+ * is stamped by sample count, which follows the audio device clock instead;
+ * over hours the two drift apart. Each audio frame's first sample has a
+ * capture time (CEF's audio PTS mapped onto steady_clock), so
+ *
+ *   drift = stamped time - (capture time - origin)
+ *
+ * is how late (positive) or early (negative) audio plays against video.
+ *
+ * Small drift is absorbed by resampling: an encoder frame is made from a few
+ * samples more (audio late) or fewer (audio early) than it holds, at most
+ * 1/256 of a frame (a ~0.4% rate change, inaudible), with hysteresis so
+ * measurement jitter does not cause constant correction. Large offsets (the
+ * first frame, a stalled audio thread) are fixed at once by dropping samples
+ * or leaving a gap in the audio timestamps.
+ *
+ * Usage:
+ *   sync.start(sampleRate, pacer.origin());
+ *   AVSync::Plan plan = sync.plan(samplesWritten, captureTimeOfReadHead, frameSize);
+ *   ring.discard(plan.discard); samplesWritten += plan.ptsJump;
+ *   read plan.consume samples, resample to frameSize, stamp samplesWritten
+ */
+class AVSync {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Plan {
+        int64_t ptsJump = 0;   // Advance the audio timestamps by this many samples (gap)
+        int64_t discard = 0;   // Drop this many samples from the ring
+        int consume = 0;       // Ring samples that make up this encoder frame
+    };
+
+    struct Stats {
+        int64_t frames = 0;
+        double averageDriftMs = 0.0;
+        double maxDriftMs = 0.0;          // Largest absolute drift
+        int64_t correctedSamples = 0;     // Samples inserted or dropped by resampling
+        int64_t resyncs = 0;              // Large offsets fixed at once
+    };
+
+    /**
+     * Start a new timeline
+     * @param sampleRate Audio sample rate (stamp units)
+     * @param origin Steady-clock time of media time 0 (the first video frame)
+     */
+    void start(int sampleRate, Clock::time_point origin);
+
+    /**
+     * Stop until the next start()
+     */
+    void stop() { started_ = false; }
+
+    bool isStarted() const { return started_; }
+
+    /**
+     * Plan the next audio frame
+     * @param stampedSamples Timestamp (in samples) the frame would get
+     * @param captureTime Capture time of the next ring sample
+     * @param frameSize Samples per encoder frame
+     * @return What to drop/skip and how many ring samples to use
+     */
+    Plan plan(int64_t stampedSamples, Clock::time_point captureTime, int frameSize);
+
+    /**
+     * Drift measured at the last plan() (milliseconds, positive = audio late)
+     */
+    double driftMs() const { return driftMs_; }
+
+    /**
+     * Statistics since the last call (resets them)
+     */
+    Stats takeStats();
+
+private:
+    bool started_ = false;
+    bool aligned_ = false;   // First frame of the timeline was placed exactly
+    bool correcting_ = false;
+    int sampleRate_ = 48000;
+    Clock::time_point origin_;
+    double driftMs_ = 0.0;
+    double smoothedDriftMs_ = 0.0;
+
+    Stats stats_;
+    double driftSumMs_ = 0.0;
+};
+
+#endif // AV_SYNC_H
@@ -0,0 +1,99 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * BoundedQueue - Blocking FIFO with a fixed capacity, used between pipeline stages
+ *
+ * push() blocks while the queue is full (backpressure towards the producer),
+ * pop() blocks while it is empty. Closing the queue lets consumers drain what is
+ * left and then return false; aborting drops pending items and wakes everyone.
+ *
+ * Thread-safety: Any number of producers and consumers
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity_(capacity > 0 ? capacity : 1) {}
+
+    // No copy, no move (threads block on the internal condition variables)
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * Append an item, waiting for free space
+     * @return false if the queue was closed (item is dropped)
+     */
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        items_.push_back(std::move(item));
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    /**
+     * Remove the oldest item, waiting for one to arrive
+     * @return false once the queue is closed and fully drained
+     */
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+        if (items_.empty()) {
+            return false;
+        }
+        item = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+
+    /**
+     * Stop accepting items; consumers still receive what is already queued
+     */
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
+    /**
+     * Close and discard pending items (error path)
+     */
+    void abort() {
+        std::deque<T> dropped;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+            dropped.swap(items_);
+            notEmpty_.notify_all();
+            notFull_.notify_all();
+        }
+        // dropped items are destroyed here, outside the lock
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return items_.size();
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::deque<T> items_;
+    bool closed_ = false;
+};
+
+#endif // BOUNDED_QUEUE_H
@@ -4,6 +4,17 @@
 #include <string>
 #include <functional>
 #include <cstdint>
+#include <vector>
+
+/**
+ * Area of a painted frame that changed since the previous paint (pixels)
+ */
+struct DirtyRect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
 
 /**
  * Abstract interface for browser rendering backends
@@ -33,16 +44,32 @@ public:
      */
     virtual void setViewportSize(int width, int height) = 0;
 
+    /**
+     * Set the rate at which the browser renders (normally the output frame rate)
+     * @param fps Frames per second
+     */
+    virtual void setFrameRate(int fps) = 0;
+
+    /**
+     * Frame callback: BGRA data, width, height, dirty rectangles
+     * An empty dirty list means the whole frame changed
+     */
+    using FrameCallback = std::function<void(const uint8_t*, int, int, const std::vector<DirtyRect>&)>;
+
     /**
      * Set frame callback - called when a new frame is rendered
-     * @param callback Function to call with frame data (BGRA format, width, height)
+     * The frame data and dirty list are only valid during the call; copy them if needed later
+     * @param callback Function to call with frame data (BGRA format, width, height, changed areas)
      */
-    virtual void setFrameCallback(std::function<void(const uint8_t*, int, int)> callback) = 0;
+    virtual void setFrameCallback(FrameCallback callback) = 0;
 
     /**
-     * Process events (call periodically to pump message loop)
+     * Set wake callback - called from any thread when the consumer has new work:
+     * a frame was painted or audio arrived. Lets the consumer sleep instead of
+     * polling (backends pump their own message loop)
+     * @param callback Function to call (must be cheap and non-blocking)
      */
-    virtual void processEvents() = 0;
+    virtual void setWakeCallback(std::function<void()> callback) = 0;
 
     /**
      * Check if page has finished loading
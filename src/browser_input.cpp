@@ -1,9 +1,12 @@
 #include "browser_input.h"
 #include "browser_backend.h"
 #include "cef_backend.h"
+#include "audio_ring_buffer.h"
+#include "color_convert.h"
 #include "ffmpeg_context.h"
 #include "logger.h"
 
+#include <algorithm>
 #include <chrono>
 #include <thread>
 #include <cstring>
@@ -12,7 +15,6 @@
 namespace {
     // Logging intervals
     constexpr int VIDEO_LOG_INTERVAL_FRAMES = 30;   // Log every 30 frames (1 second at 30fps)
-    constexpr int AUDIO_LOG_INTERVAL_PACKETS = 50;  // Log every 50 audio packets
 
     // Video encoding constants
     constexpr int VIDEO_MAX_B_FRAMES = 0;           // No B-frames for low latency encoding
@@ -24,8 +26,69 @@ namespace {
     // Memory alignment
     constexpr int YUV_FRAME_ALIGNMENT = 32;         // 32-byte alignment for YUV frames (SIMD optimization)
 
-    // Time conversion
-    constexpr int MS_TO_SECONDS_DIVISOR = 1000;     // Milliseconds to seconds conversion
+    // Incremental conversion
+    constexpr int MACROBLOCK_SIZE = 16;             // Dirty rects are widened to the encoder's macroblock grid
+    constexpr size_t MAX_DIRTY_RECTS = 256;         // More pending rects than this: convert the whole frame
+
+    // Change detection (tiles are hashed on every paint they are dirty in)
+    constexpr int CHANGE_TILE_WIDTH = 64;           // Pixels; 4 macroblocks
+    constexpr int CHANGE_TILE_HEIGHT = MACROBLOCK_SIZE;
+
+    // 64-bit multiplicative hash of a tile, four independent lanes per 32 bytes
+    uint64_t hashTile(const uint8_t* data, int stride, int row_bytes, int rows) {
+        constexpr uint64_t PRIME = 0x100000001B3ULL;
+        uint64_t lanes[4] = {0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL, 0x165667B19E3779F9ULL, 0x27D4EB2F165667C5ULL};
+
+        for (int row = 0; row < rows; row++) {
+            const uint8_t* p = data + (size_t)row * stride;
+            int i = 0;
+            for (; i + 32 <= row_bytes; i += 32) {
+                for (int lane = 0; lane < 4; lane++) {
+                    uint64_t word;
+                    std::memcpy(&word, p + i + lane * 8, sizeof(word));
+                    lanes[lane] = (lanes[lane] ^ word) * PRIME;
+                }
+            }
+            for (; i + 4 <= row_bytes; i += 4) {
+                uint32_t word;
+                std::memcpy(&word, p + i, sizeof(word));
+                lanes[0] = (lanes[0] ^ word) * PRIME;
+            }
+        }
+        return lanes[0] ^ (lanes[1] * 3) ^ (lanes[2] * 5) ^ (lanes[3] * 7);
+    }
+
+    // Pacing: longest time readPacket() blocks, so the caller can still poll for Ctrl+C
+    constexpr int MAX_WAIT_MS = 100;
+
+    // Drift correction in place: a plane holds the first min(src_count, dst_count) of src_count
+    // ring samples, `tail` the rest; they are resampled linearly to dst_count samples. Squeezing
+    // only reads at or ahead of the write position and stretching at or behind it, so walking
+    // forwards (squeeze) or backwards (stretch) never reads an overwritten sample
+    void resamplePlaneInPlace(float* plane, const float* tail, int src_count, int dst_count) {
+        if (dst_count <= 1 || src_count <= 1 || src_count == dst_count) {
+            return;
+        }
+        auto sample = [&](int k) { return k < dst_count ? plane[k] : tail[k - dst_count]; };
+        double step = static_cast<double>(src_count - 1) / (dst_count - 1);
+        auto resampleAt = [&](int i) {
+            double pos = i * step;
+            int index = static_cast<int>(pos);
+            int next = std::min(index + 1, src_count - 1);
+            float frac = static_cast<float>(pos - index);
+            float a = sample(index);
+            plane[i] = a + (sample(next) - a) * frac;
+        };
+        if (src_count > dst_count) {
+            for (int i = 0; i < dst_count; i++) {
+                resampleAt(i);
+            }
+        } else {
+            for (int i = dst_count - 1; i >= 0; i--) {
+                resampleAt(i);
+            }
+        }
+    }
 }
 
 // ============================================================================
@@ -37,11 +100,9 @@ BrowserInput::BrowserInput(const AppConfig& config, std::shared_ptr<FFmpegContex
     , config_(config)
     , video_stream_index_(0)
     , audio_stream_index_(-1)
-    , frame_ready_(false)
     , resetting_encoders_(false)
     , received_real_frame_(false)
     , frame_count_(0)
-    , start_time_ms_(0)
     , snapshot_width_(0)
     , snapshot_height_(0)
     , audio_channels_(0)
@@ -83,7 +144,7 @@ bool BrowserInput::open(const std::string& uri) {
 
     initialized_ = true;
     running_ = true;
-    start_time_ms_ = 0;
+    pacer_.stop();
 
     // Initialize CEF immediately
     Logger::info("Browser input opened - initializing CEF directly");
@@ -97,6 +158,7 @@ void BrowserInput::close() {
     }
 
     running_ = false;
+    audio_ring_ = nullptr;
 
     if (backend_) {
         backend_->shutdown();
@@ -119,18 +181,9 @@ bool BrowserInput::readPacket(AVPacket* packet) {
         return false;
     }
 
-    int64_t current_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
-
-    // Initialize timing on first call
-    if (start_time_ms_ == 0) {
-        start_time_ms_ = current_time_ms;
-    }
-
-    // Process CEF backend events and frames
+    // CEF runs on the shared runtime's message-loop thread: only collect its audio and frames here
     bool cef_is_ready = cef_initialized_.load();
     if (cef_is_ready && backend_) {
-        backend_->processEvents();
         pullAudioFromBackend();
 
         CEFBackend* cef = dynamic_cast<CEFBackend*>(backend_.get());
@@ -140,80 +193,90 @@ bool BrowserInput::readPacket(AVPacket* packet) {
         }
 
         if (cef && cef->checkAndClearPageReload()) {
-            Logger::info("Page reload detected - resetting muxer and encoders");
-            if (pageReloadCallback_ && !pageReloadCallback_()) {
-                Logger::error("Failed to reset output muxer on page reload");
-                return false;
-            }
-            if (!resetEncoders()) {
-                Logger::error("Failed to reset encoders on page reload");
-                return false;
-            }
-            Logger::info("Page reload handling complete");
+            handlePageReload();
         }
     }
 
-    bool has_frame = false;
-    if (cef_is_ready) {
-        std::lock_guard<std::mutex> lock(frame_mutex_);
-        has_frame = frame_ready_ && !current_frame_.empty();
+    // Audio is emitted as soon as a full encoder frame has been captured
+    if (audio_codec_ctx_ && hasAudioData() && encodeAudio(packet)) {
+        return true;
     }
 
-    int64_t elapsed_ms = current_time_ms - start_time_ms_;
-    int64_t expected_frame = (elapsed_ms * config_.video.fps) / MS_TO_SECONDS_DIVISOR;
-
-    bool throttle = frame_count_ >= expected_frame;
+    bool has_frame = cef_is_ready && frames_.hasNewData();
 
-    if (throttle) {
-        // Try to emit audio while we wait for the next video frame
-        if (audio_codec_ctx_ && hasAudioData() && encodeAudio(packet)) {
+    if (pacer_.isStarted()) {
+        int64_t frames_due = pacer_.framesDue();
+        if (frame_count_ >= frames_due) {
+            // Next frame not due yet: sleep until its deadline (or until a paint, audio or CEF work)
+            waitForWork(pacer_.deadline(frame_count_));
             return true;
         }
-        if (!has_frame) {
-            // No fresh video frame yet – yield briefly and try again
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        // More than a segment behind the clock (process stalled): catching up would
+        // burst stale frames, so the timeline restarts after a discontinuity instead
+        int64_t lag = frames_due - frame_count_;
+        if (lag > (int64_t)config_.video.fps * config_.hls.segmentDuration) {
+            Logger::warn("Video fell " + std::to_string(lag) + " frames behind the frame clock - "
+                         "restarting the timeline with a discontinuity");
+            if (discontinuityCallback_ && !discontinuityCallback_()) {
+                Logger::error("Failed to restart output after a timing break");
+                return false;
+            }
+            if (!resetEncoders()) {
+                Logger::error("Failed to reset encoders after a timing break");
+                return false;
+            }
             return true;
         }
-        // Otherwise fall through to process the available video frame
-    } else if (audio_codec_ctx_ && hasAudioData() && encodeAudio(packet)) {
-        return true;
     }
 
-    if (!has_frame) {
+    if (!has_frame && !has_converted_frame_) {
+        // Nothing to show yet: ask the browser for a complete frame and wait for its paint
+        force_full_paint_ = true;
         if (cef_is_ready && backend_) {
             CEFBackend* cef = dynamic_cast<CEFBackend*>(backend_.get());
             if (cef && backend_->isPageLoaded()) {
                 cef->invalidate();
+                requestBeginFrame();
             }
         }
-        // Reduced sleep to minimize frame drops (2ms instead of 10ms)
-        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        waitForWork(begin_frame_mode_ ? last_begin_frame_ + std::chrono::nanoseconds(1000000000LL / config_.video.fps)
+                                      : FramePacer::Clock::time_point::max());
         return true;
     }
 
-    std::vector<uint8_t> frame_copy;
-    int snap_width, snap_height;
-    {
-        std::lock_guard<std::mutex> lock(frame_mutex_);
-        frame_copy = current_frame_;
-        snap_width = snapshot_width_;
-        snap_height = snapshot_height_;
-        frame_ready_ = false;
-    }
+    if (has_frame) {
+        // First paint after a page reload: players can join the new page here
+        if (reload_keyframe_pending_) {
+            reload_keyframe_pending_ = false;
+            keyframe_planner_.reset();
+        }
 
-    if (!convertBGRAtoYUVWithCrop(frame_copy.data(), snap_width, snap_height, yuv_frame_.get())) {
-        Logger::error("Failed to convert BGRA to YUV");
-        return false;
-    }
+        // Take the newest painted frame; it stays valid (and unshared) until the next acquire()
+        frames_.acquire();
+        const BrowserFrame& frame = frames_.front();
 
-    if (start_time_ms_ == 0) {
-        start_time_ms_ = std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::system_clock::now().time_since_epoch()).count();
-        if (frame_count_ == 0) {
-            Logger::info("Video & audio clock started: First video frame being generated");
-        } else {
-            Logger::info("Video & audio clock restarted after page reload (video frame #" + std::to_string(frame_count_) + ", audio samples #" + std::to_string(audio_samples_written_) + ")");
+        if (!updateScaler(frame.width, frame.height)) {
+            return false;
+        }
+
+        if (!convertFrame(frame)) {
+            Logger::error("Failed to convert BGRA to YUV");
+            return false;
         }
+        has_converted_frame_ = true;
+    } else {
+        // Static page: nothing changed since the last frame. The previous picture is encoded again
+        // (no conversion, and the encoder codes it as skip blocks) to keep a constant frame rate
+        static_frames_++;
+    }
+
+    if (!pacer_.isStarted()) {
+        // The clock starts with the first frame: frame N is due N / fps seconds later
+        pacer_.start(config_.video.fps);
+        av_sync_.start(audio_sample_rate_ > 0 ? audio_sample_rate_ : config_.audio.sample_rate, pacer_.origin());
+        Logger::info("Video & audio clock started: First video frame being generated (" +
+                     std::to_string(config_.video.fps) + " fps, steady clock)");
     }
 
     // Use frame_count_ for PTS to guarantee monotonically increasing timestamps
@@ -224,8 +287,23 @@ bool BrowserInput::readPacket(AVPacket* packet) {
     if (frame_count_ == 0) {
         Logger::info("Video started: First video frame generated (frame #0)");
     } else if (frame_count_ % VIDEO_LOG_INTERVAL_FRAMES == 0) {
+        int converted_percent = frame_pixels_ > 0 ? static_cast<int>(converted_pixels_ * 100 / frame_pixels_) : 0;
+        FramePacer::Stats pacing = pacer_.takeStats();
+        AVSync::Stats sync = av_sync_.takeStats();
+        std::string drift;
+        if (sync.frames > 0) {
+            drift = ", A/V drift avg " + std::to_string(static_cast<int>(sync.averageDriftMs * 1000)) + "us / max " +
+                    std::to_string(static_cast<int>(sync.maxDriftMs * 1000)) + "us, " +
+                    std::to_string(sync.correctedSamples) + " samples corrected";
+        }
         Logger::info("Video frame #" + std::to_string(frame_count_) +
-                   " generated (1 second of video)");
+                   " generated (1 second of video, " + std::to_string(converted_percent) + "% of pixels converted, " +
+                   std::to_string(static_frames_) + " static frames, pacing jitter avg " +
+                   std::to_string(static_cast<int>(pacing.averageJitterMs * 1000)) + "us / max " +
+                   std::to_string(static_cast<int>(pacing.maxJitterMs * 1000)) + "us" + drift + ")");
+        converted_pixels_ = 0;
+        frame_pixels_ = 0;
+        static_frames_ = 0;
     }
 
     if (!encodeFrame(yuv_frame_.get(), packet)) {
@@ -238,10 +316,57 @@ bool BrowserInput::readPacket(AVPacket* packet) {
         Logger::info("First real video frame encoded successfully");
     }
 
+    pacer_.recordFrame(frame_count_);
     frame_count_++;
+
+    // Render the next frame now, so its paint arrives before its deadline
+    requestBeginFrame();
     return true;
 }
 
+void BrowserInput::requestBeginFrame() {
+    if (!begin_frame_mode_ || !backend_ || !backend_->isPageLoaded()) {
+        return;
+    }
+
+    // At most one BeginFrame per half frame interval (retries while waiting for the first paint)
+    auto now = FramePacer::Clock::now();
+    if (now - last_begin_frame_ < std::chrono::nanoseconds(500000000LL / config_.video.fps)) {
+        return;
+    }
+    last_begin_frame_ = now;
+
+    CEFBackend* cef = dynamic_cast<CEFBackend*>(backend_.get());
+    if (cef) {
+        cef->signalBeginFrame();
+    }
+}
+
+void BrowserInput::handlePageReload() {
+    // The stream continues across reloads (e.g. after cookie consent) with the same
+    // encoders, muxer and timeline; the previous picture is repeated until the new
+    // page paints, and that paint is encoded as an IDR in full
+    reload_keyframe_pending_ = true;
+    force_full_paint_ = true;
+    yuv_valid_ = false;
+
+    // The old page's audio may have stopped before the reload: keep audio from lagging
+    // behind video (a gap in the audio timestamps, never a step back)
+    if (pacer_.isStarted() && audio_sample_rate_ > 0) {
+        int64_t video_samples = frame_count_ * audio_sample_rate_ / config_.video.fps;
+        if (audio_samples_written_ < video_samples) {
+            audio_samples_written_ = video_samples;
+        }
+    }
+
+    Logger::info("Page reload detected - continuing in-stream (IDR on the first new paint, video frame #" +
+                 std::to_string(frame_count_) + ")");
+}
+
+void BrowserInput::waitForWork(FramePacer::Clock::time_point deadline) {
+    pacer_.waitUntil(std::min(deadline, FramePacer::Clock::now() + std::chrono::milliseconds(MAX_WAIT_MS)));
+}
+
 // ============================================================================
 // STREAMINPUT INTERFACE IMPLEMENTATION
 // Public interface methods required by StreamInput base class
@@ -303,17 +428,31 @@ bool BrowserInput::setupEncoder(bool is_reset) {
     codec_ctx_->framerate = AVRational{config_.video.fps, 1};
     codec_ctx_->pix_fmt = AV_PIX_FMT_YUV420P;
     codec_ctx_->bit_rate = config_.video.bitrate;
-    codec_ctx_->gop_size = config_.video.gop_size;
+    codec_ctx_->gop_size = config_.video.gop_size > 0
+        ? config_.video.gop_size
+        : KeyframePlanner::framesPerSegment(config_.video.fps, config_.hls.segmentDuration);
     codec_ctx_->max_b_frames = VIDEO_MAX_B_FRAMES;  // No B-frames for low latency
+    codec_ctx_->color_primaries = AVCOL_PRI_BT709;  // What ColorConverter/the scaler produce
+    codec_ctx_->color_trc = AVCOL_TRC_BT709;
+    codec_ctx_->colorspace = AVCOL_SPC_BT709;
+    codec_ctx_->color_range = AVCOL_RANGE_MPEG;
 
     ffmpeg_->av_opt_set(codec_ctx_->priv_data, "preset", "ultrafast", 0);
     ffmpeg_->av_opt_set(codec_ctx_->priv_data, "tune", "zerolatency", 0);
+    ffmpeg_->av_opt_set(codec_ctx_->priv_data, "forced-idr", "1", 0);  // Forced I-frames become IDR
+
+    if (config_.hls.usesFmp4()) {
+        codec_ctx_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;  // SPS/PPS go to init.mp4
+    }
 
     if (ffmpeg_->avcodec_open2(codec_ctx_.get(), codec, nullptr) < 0) {
         Logger::error("Failed to open codec");
         return false;
     }
 
+    keyframe_planner_.configure(codec_ctx_->time_base.num, codec_ctx_->time_base.den,
+                                config_.hls.segmentDuration);
+
     if (!is_reset) {
         AVStream* stream = ffmpeg_->avformat_new_stream(format_ctx_.get(), nullptr);
         if (!stream) {
@@ -342,26 +481,28 @@ bool BrowserInput::setupEncoder(bool is_reset) {
     yuv_frame_->format = AV_PIX_FMT_YUV420P;
     yuv_frame_->width = config_.video.width;
     yuv_frame_->height = config_.video.height;
+    yuv_frame_->color_primaries = codec_ctx_->color_primaries;
+    yuv_frame_->color_trc = codec_ctx_->color_trc;
+    yuv_frame_->colorspace = codec_ctx_->colorspace;
+    yuv_frame_->color_range = codec_ctx_->color_range;
 
     if (ffmpeg_->av_frame_get_buffer(yuv_frame_.get(), YUV_FRAME_ALIGNMENT) < 0) {
         Logger::error("Failed to allocate YUV frame buffer");
         return false;
     }
+    yuv_valid_ = false;  // New buffer: the next frame is converted in full
+    has_converted_frame_ = false;
 
-    sws_ctx_ = std::unique_ptr<SwsContext, SwsContextDeleter>(ffmpeg_->sws_getContext(
-        config_.video.width, config_.video.height, AV_PIX_FMT_BGRA,
-        config_.video.width, config_.video.height, AV_PIX_FMT_YUV420P,
-        SWS_BILINEAR, nullptr, nullptr, nullptr), SwsContextDeleter(ffmpeg_));
-
-    if (!sws_ctx_) {
-        Logger::error("Failed to create swscale context");
-        return false;
-    }
+    // Pages render at the output size: ColorConverter handles them, a scaler is only created on resize
+    sws_ctx_.reset();
+    snapshot_width_ = config_.video.width;
+    snapshot_height_ = config_.video.height;
 
     Logger::info("Video encoder setup complete");
     Logger::info("  - Resolution: " + std::to_string(config_.video.width) + "x" + std::to_string(config_.video.height));
     Logger::info("  - Frame rate: " + std::to_string(config_.video.fps) + " fps");
     Logger::info("  - Codec: H.264");
+    Logger::info(std::string("  - Colour conversion: BT.709 limited range (") + ColorConverter::implementationName() + ")");
 
     return true;
 }
@@ -412,10 +553,13 @@ bool BrowserInput::resetEncoders() {
 
     frame_count_ = 0;
     audio_samples_written_ = 0;
-    start_time_ms_ = 0;
+    pacer_.stop();
+    av_sync_.stop();
     audio_start_pts_ = -1;
-    audio_buffer_.clear();
-    received_real_frame_ = false;  // Reset frame tracking after page reload
+    if (audio_ring_) {
+        audio_ring_->clear();
+    }
+    received_real_frame_ = false;  // Reset frame tracking for the new timeline
     Logger::info("Reset PTS counters, cleared audio buffer, and reset frame tracking");
 
     resetting_encoders_ = false;
@@ -504,10 +648,17 @@ bool BrowserInput::setupAudioEncoder(int sample_rate, int channels, bool is_rese
 }
 
 bool BrowserInput::convertBGRAtoYUVWithCrop(const uint8_t* bgra_data, int src_width, int src_height, AVFrame* yuv_frame) {
-    if (!bgra_data || !yuv_frame || !sws_ctx_) {
+    if (!bgra_data || !yuv_frame) {
         return false;
     }
 
+    // Snapshot at the output size: colour conversion only, no swscale
+    if (!sws_ctx_) {
+        ColorConverter::bgraToYuv420(bgra_data, src_width * BGRA_BYTES_PER_PIXEL, yuv_frame->data, yuv_frame->linesize,
+                                     0, 0, src_width, std::min(src_height, (int)config_.video.height));
+        return true;
+    }
+
     const uint8_t* src_data[4] = { bgra_data, nullptr, nullptr, nullptr };
     int src_linesize[4] = { src_width * BGRA_BYTES_PER_PIXEL, 0, 0, 0 };
 
@@ -524,6 +675,79 @@ bool BrowserInput::convertBGRAtoYUVWithCrop(const uint8_t* bgra_data, int src_wi
     return ret > 0;
 }
 
+bool BrowserInput::convertFrame(const BrowserFrame& frame) {
+    if (!yuv_frame_) {
+        return false;
+    }
+
+    const int width = snapshot_width_;
+    const int height = std::min(snapshot_height_, (int)config_.video.height);
+    frame_pixels_ += (int64_t)width * height;
+
+    // Dirty rects only describe the step from the previous paint: a skipped paint needs a full conversion
+    const bool consecutive = frame.sequence == converted_sequence_ + 1;
+    converted_sequence_ = frame.sequence;
+
+    // yuv_frame_ still holds the previous frame: only the changed macroblocks need converting
+    if (!sws_ctx_ && yuv_valid_ && consecutive && !frame.all_dirty) {
+        convertDirtyBlocks(frame, width, height);
+        return true;
+    }
+
+    converted_pixels_ += (int64_t)width * height;
+    bool converted = convertBGRAtoYUVWithCrop(frame.bgra.data(), frame.width, snapshot_height_, yuv_frame_.get());
+
+    // Scaled frames are never patched: every source pixel spreads over its neighbours
+    yuv_valid_ = converted && !sws_ctx_;
+    return converted;
+}
+
+void BrowserInput::convertDirtyBlocks(const BrowserFrame& frame, int width, int height) {
+    const int blocks_x = (width + MACROBLOCK_SIZE - 1) / MACROBLOCK_SIZE;
+    const int blocks_y = (height + MACROBLOCK_SIZE - 1) / MACROBLOCK_SIZE;
+    dirty_blocks_.assign((size_t)blocks_x * blocks_y, 0);
+
+    // Rasterize the rects onto the macroblock grid (overlapping rects are converted once)
+    for (const DirtyRect& rect : frame.dirty) {
+        int x0 = std::max(rect.x, 0);
+        int y0 = std::max(rect.y, 0);
+        int x1 = std::min(rect.x + rect.width, width);
+        int y1 = std::min(rect.y + rect.height, height);
+        if (x0 >= x1 || y0 >= y1) {
+            continue;
+        }
+        for (int by = y0 / MACROBLOCK_SIZE; by <= (y1 - 1) / MACROBLOCK_SIZE; by++) {
+            uint8_t* row = &dirty_blocks_[(size_t)by * blocks_x];
+            std::fill(row + x0 / MACROBLOCK_SIZE, row + (x1 - 1) / MACROBLOCK_SIZE + 1, 1);
+        }
+    }
+
+    // Convert each horizontal run of dirty blocks as one region
+    const int stride = frame.width * BGRA_BYTES_PER_PIXEL;
+    for (int by = 0; by < blocks_y; by++) {
+        const uint8_t* row = &dirty_blocks_[(size_t)by * blocks_x];
+        const int y = by * MACROBLOCK_SIZE;
+        const int region_height = std::min(MACROBLOCK_SIZE, height - y);
+
+        int bx = 0;
+        while (bx < blocks_x) {
+            if (!row[bx]) {
+                bx++;
+                continue;
+            }
+            int run_start = bx;
+            while (bx < blocks_x && row[bx]) {
+                bx++;
+            }
+            const int x = run_start * MACROBLOCK_SIZE;
+            const int region_width = std::min(bx * MACROBLOCK_SIZE, width) - x;
+            ColorConverter::bgraToYuv420(frame.bgra.data(), stride, yuv_frame_->data, yuv_frame_->linesize,
+                                         x, y, region_width, region_height);
+            converted_pixels_ += (int64_t)region_width * region_height;
+        }
+    }
+}
+
 bool BrowserInput::convertBGRAtoYUV(const uint8_t* bgra_data, AVFrame* yuv_frame) {
     return convertBGRAtoYUVWithCrop(bgra_data, config_.video.width, config_.video.height, yuv_frame);
 }
@@ -539,6 +763,12 @@ bool BrowserInput::encodeFrame(AVFrame* frame, AVPacket* packet) {
         return false;
     }
 
+    // Force an IDR on every segment boundary so each HLS segment is exactly segmentDuration long
+    if (frame) {
+        frame->pict_type = keyframe_planner_.shouldForceKeyframe(frame->pts)
+            ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+    }
+
     int ret = ffmpeg_->avcodec_send_frame(codec_ctx_.get(), frame);
     if (ret < 0) {
         Logger::error("Failed to send frame to encoder");
@@ -565,31 +795,145 @@ bool BrowserInput::encodeFrame(AVFrame* frame, AVPacket* packet) {
 // Frame reception callbacks and CEF initialization
 // ============================================================================
 
-void BrowserInput::onFrameReceived(const uint8_t* bgra_data, int width, int height) {
+void BrowserInput::onFrameReceived(const uint8_t* bgra_data, int width, int height,
+                                   const std::vector<DirtyRect>& dirty_rects) {
     if (!bgra_data || width <= 0 || height <= 0) {
         return;
     }
 
-    int adjusted_width = width & ~1;
-    int adjusted_height = height & ~1;
+    // CEF reports whole-view dirty rects for invalidations and many animations: compare
+    // content to find what really changed, and drop paints identical to the previous one
+    // Non-short-circuit: the hashes must be updated on every paint
+    bool all_changed = force_full_paint_.exchange(false) | detectChanges(bgra_data, width, height, dirty_rects);
+    if (!all_changed && changed_rects_.empty()) {
+        return;
+    }
+
+    BrowserFrame& frame = frames_.back();
+
+    // Changes are relative to the previous paint only. If readPacket skips a paint, it sees
+    // the gap in the sequence and converts the next frame it takes in full
+    frame.sequence = ++paint_sequence_;
+    frame.all_dirty = all_changed || changed_rects_.size() > MAX_DIRTY_RECTS;
+    frame.dirty.clear();
+    if (!frame.all_dirty) {
+        frame.dirty.insert(frame.dirty.end(), changed_rects_.begin(), changed_rects_.end());
+    }
 
-    // Acquire lock BEFORE modifying sws_ctx_ to prevent race conditions
-    std::lock_guard<std::mutex> lock(frame_mutex_);
+    // Single copy out of the browser's paint buffer, straight into the producer slot
+    size_t frame_size = (size_t)width * height * BGRA_BYTES_PER_PIXEL;
+    frame.bgra.resize(frame_size);
+    std::memcpy(frame.bgra.data(), bgra_data, frame_size);
+    frame.width = width;
+    frame.height = height;
 
-    if (adjusted_width != snapshot_width_ || adjusted_height != snapshot_height_) {
-        if (adjusted_width != width || adjusted_height != height) {
-            Logger::info("Snapshot dimensions: " + std::to_string(width) + "x" + std::to_string(height) +
-                         " adjusted to " + std::to_string(adjusted_width) + "x" + std::to_string(adjusted_height));
+    frames_.publish();
+}
+
+// Paint thread. Updates the tile hashes and fills changed_rects_ with what differs from the
+// previous paint. Returns true if the whole frame counts as changed (first paint or new size)
+bool BrowserInput::detectChanges(const uint8_t* bgra_data, int width, int height,
+                                 const std::vector<DirtyRect>& dirty_rects) {
+    const int tiles_x = (width + CHANGE_TILE_WIDTH - 1) / CHANGE_TILE_WIDTH;
+    const int tiles_y = (height + CHANGE_TILE_HEIGHT - 1) / CHANGE_TILE_HEIGHT;
+    const int stride = width * BGRA_BYTES_PER_PIXEL;
+    const bool resized = width != painted_width_ || height != painted_height_;
+
+    painted_width_ = width;
+    painted_height_ = height;
+    changed_rects_.clear();
+
+    // Only tiles inside CEF's dirty rects can differ (no rects: the whole view)
+    tile_changed_.assign((size_t)tiles_x * tiles_y, dirty_rects.empty() || resized ? 1 : 0);
+    for (const DirtyRect& rect : dirty_rects) {
+        int x0 = std::max(rect.x, 0);
+        int y0 = std::max(rect.y, 0);
+        int x1 = std::min(rect.x + rect.width, width);
+        int y1 = std::min(rect.y + rect.height, height);
+        if (x0 >= x1 || y0 >= y1) {
+            continue;
+        }
+        for (int ty = y0 / CHANGE_TILE_HEIGHT; ty <= (y1 - 1) / CHANGE_TILE_HEIGHT; ty++) {
+            uint8_t* row = &tile_changed_[(size_t)ty * tiles_x];
+            std::fill(row + x0 / CHANGE_TILE_WIDTH, row + (x1 - 1) / CHANGE_TILE_WIDTH + 1, 1);
+        }
+    }
+
+    if (resized) {
+        tile_hashes_.assign((size_t)tiles_x * tiles_y, 0);
+    }
+
+    // Hash candidate tiles; a tile only stays marked if its content differs
+    for (int ty = 0; ty < tiles_y; ty++) {
+        const int y = ty * CHANGE_TILE_HEIGHT;
+        const int rows = std::min(CHANGE_TILE_HEIGHT, height - y);
+        for (int tx = 0; tx < tiles_x; tx++) {
+            size_t index = (size_t)ty * tiles_x + tx;
+            if (!tile_changed_[index]) {
+                continue;
+            }
+            const int x = tx * CHANGE_TILE_WIDTH;
+            const int columns = std::min(CHANGE_TILE_WIDTH, width - x);
+            uint64_t hash = hashTile(bgra_data + (size_t)y * stride + (size_t)x * BGRA_BYTES_PER_PIXEL,
+                                     stride, columns * BGRA_BYTES_PER_PIXEL, rows);
+            tile_changed_[index] = hash != tile_hashes_[index];
+            tile_hashes_[index] = hash;
         }
+    }
 
-        bool needs_scaling = (adjusted_width != (int)config_.video.width || adjusted_height != (int)config_.video.height);
-        if (needs_scaling || snapshot_width_ == 0) {
-            const char* action = sws_ctx_ ? "Recreating" : "Creating";
-            if (needs_scaling) {
-                Logger::info(std::string(action) + " scaler: " + std::to_string(adjusted_width) + "x" + std::to_string(adjusted_height) +
-                             " -> " + std::to_string(config_.video.width) + "x" + std::to_string(config_.video.height));
+    if (resized) {
+        return true;
+    }
+
+    // One rect per horizontal run of changed tiles
+    for (int ty = 0; ty < tiles_y; ty++) {
+        const uint8_t* row = &tile_changed_[(size_t)ty * tiles_x];
+        int tx = 0;
+        while (tx < tiles_x) {
+            if (!row[tx]) {
+                tx++;
+                continue;
             }
+            int run_start = tx;
+            while (tx < tiles_x && row[tx]) {
+                tx++;
+            }
+            DirtyRect rect;
+            rect.x = run_start * CHANGE_TILE_WIDTH;
+            rect.y = ty * CHANGE_TILE_HEIGHT;
+            rect.width = std::min(tx * CHANGE_TILE_WIDTH, width) - rect.x;
+            rect.height = std::min(CHANGE_TILE_HEIGHT, height - rect.y);
+            changed_rects_.push_back(rect);
+        }
+    }
+    return false;
+}
+
+bool BrowserInput::updateScaler(int width, int height) {
+    // Runs on the encode thread, the only user of sws_ctx_
+    int adjusted_width = width & ~1;
+    int adjusted_height = height & ~1;
+    bool needs_scaling = (adjusted_width != (int)config_.video.width || adjusted_height != (int)config_.video.height);
+
+    if (adjusted_width == snapshot_width_ && adjusted_height == snapshot_height_ && (sws_ctx_ || !needs_scaling)) {
+        return true;
+    }
+
+    if (adjusted_width != width || adjusted_height != height) {
+        Logger::info("Snapshot dimensions: " + std::to_string(width) + "x" + std::to_string(height) +
+                     " adjusted to " + std::to_string(adjusted_width) + "x" + std::to_string(adjusted_height));
+    }
+
+    if (!needs_scaling) {
+        // Back at the output size: colour conversion only (ColorConverter)
+        if (sws_ctx_) {
+            Logger::info("Snapshot matches output size, releasing scaler");
         }
+        sws_ctx_.reset();
+    } else {
+        const char* action = sws_ctx_ ? "Recreating" : "Creating";
+        Logger::info(std::string(action) + " scaler: " + std::to_string(adjusted_width) + "x" + std::to_string(adjusted_height) +
+                     " -> " + std::to_string(config_.video.width) + "x" + std::to_string(config_.video.height));
 
         sws_ctx_ = std::unique_ptr<SwsContext, SwsContextDeleter>(ffmpeg_->sws_getContext(
             adjusted_width, adjusted_height, AV_PIX_FMT_BGRA,
@@ -599,22 +943,24 @@ void BrowserInput::onFrameReceived(const uint8_t* bgra_data, int width, int heig
 
         if (!sws_ctx_) {
             Logger::error("Failed to recreate scaler context");
-            return;
+            snapshot_width_ = 0;
+            snapshot_height_ = 0;
+            return false;
         }
 
-        snapshot_width_ = adjusted_width;
-        snapshot_height_ = adjusted_height;
+        // Same matrix as the unscaled path (swscale defaults to BT.601): full-range RGB in, limited-range BT.709 out
+        const int* bt709 = ffmpeg_->sws_getCoefficients(SWS_CS_ITU709);
+        ffmpeg_->sws_setColorspaceDetails(sws_ctx_.get(), bt709, 1, bt709, 0, 0, 1 << 16, 1 << 16);
     }
 
-    size_t frame_size = width * height * BGRA_BYTES_PER_PIXEL;
-    current_frame_.resize(frame_size);
-    std::memcpy(current_frame_.data(), bgra_data, frame_size);
-
-    frame_ready_ = true;
+    snapshot_width_ = adjusted_width;
+    snapshot_height_ = adjusted_height;
+    yuv_valid_ = false;  // New source size: the next frame is converted in full
+    return true;
 }
 
 void BrowserInput::pullAudioFromBackend() {
-    if (!backend_) {
+    if (!backend_ || !audio_ring_) {
         return;
     }
 
@@ -628,36 +974,23 @@ void BrowserInput::pullAudioFromBackend() {
         Logger::info("Audio stream detected from CEF");
     }
 
-    if (cef_backend->hasAudioData()) {
-        std::vector<float> new_audio = cef_backend->getAndClearAudioBuffer();
-        if (new_audio.empty()) {
-            return;
-        }
-
-        static int audio_packet_count = 0;
-        audio_packet_count++;
-
-        if (start_time_ms_ == 0) {
-            static bool logged_discard = false;
-            if (!logged_discard) {
-                Logger::info("Discarding pre-page-load audio (packet #" + std::to_string(audio_packet_count) +
-                           ") - waiting for page to load and first video frame");
-                logged_discard = true;
-            }
-            return;
-        }
+    if (audio_ring_->available() == 0) {
+        return;
+    }
 
-        if (audio_start_pts_ < 0 && audio_sample_rate_ > 0) {
-            audio_start_pts_ = 0;
-            Logger::info("First audio after video start - audio PTS starts from 0");
+    if (!pacer_.isStarted()) {
+        if (!logged_audio_discard_) {
+            Logger::info("Discarding pre-page-load audio (" + std::to_string(audio_ring_->available()) +
+                       " frames) - waiting for page to load and first video frame");
+            logged_audio_discard_ = true;
         }
+        audio_ring_->clear();
+        return;
+    }
 
-        audio_buffer_.insert(audio_buffer_.end(), new_audio.begin(), new_audio.end());
-
-        if (audio_packet_count % AUDIO_LOG_INTERVAL_PACKETS == 0) {
-            Logger::info("Audio packet #" + std::to_string(audio_packet_count) +
-                       " received, buffer size: " + std::to_string(audio_buffer_.size()) + " samples");
-        }
+    if (audio_start_pts_ < 0 && audio_sample_rate_ > 0) {
+        audio_start_pts_ = 0;
+        Logger::info("First audio after video start - placed on the video clock by its capture time");
     }
 }
 
@@ -668,26 +1001,69 @@ bool BrowserInput::encodeAudio(AVPacket* packet) {
 
     std::lock_guard<std::mutex> lock(encoder_mutex_);
 
-    if (!audio_codec_ctx_ || !audio_frame_ || audio_channels_ == 0) {
+    if (!audio_codec_ctx_ || !audio_frame_ || audio_channels_ == 0 || !audio_ring_) {
+        return false;
+    }
+
+    int frame_size = audio_codec_ctx_->frame_size;
+    if (audio_ring_->available() < (size_t)frame_size) {
         return false;
     }
 
-    int samples_needed = audio_codec_ctx_->frame_size * audio_channels_;
-    if ((int)audio_buffer_.size() < samples_needed) {
+    // The encoder may still reference the previous frame's buffers
+    if (ffmpeg_->av_frame_make_writable(audio_frame_.get()) < 0) {
+        Logger::error("Failed to make audio frame writable");
         return false;
     }
 
-    float** planes = (float**)audio_frame_->data;
-    for (int sample = 0; sample < audio_codec_ctx_->frame_size; sample++) {
+    // Place the frame on the video clock: CEF's capture time of its first sample against its stamp
+    AVSync::Plan plan;
+    plan.consume = frame_size;
+    CEFBackend* cef_backend = dynamic_cast<CEFBackend*>(backend_.get());
+    FramePacer::Clock::time_point capture_time;
+    if (av_sync_.isStarted() && cef_backend &&
+        cef_backend->getAudioCaptureTime(audio_ring_->readPosition(), capture_time)) {
+        plan = av_sync_.plan(audio_samples_written_, capture_time, frame_size);
+        if (plan.discard > 0 || plan.ptsJump > 0) {
+            Logger::info("A/V sync: audio " + std::to_string(static_cast<int>(av_sync_.driftMs())) + "ms off the video clock - " +
+                         (plan.discard > 0 ? "dropped " + std::to_string(plan.discard) + " samples"
+                                           : "skipped " + std::to_string(plan.ptsJump) + " samples of timestamps"));
+            audio_ring_->discard(static_cast<size_t>(plan.discard));
+            audio_samples_written_ += plan.ptsJump;
+        }
+        if (audio_ring_->available() < static_cast<size_t>(plan.consume)) {
+            return false;
+        }
+    }
+
+    // Planar ring → planar FLTP frame, one memcpy per channel. A drift-corrected frame takes
+    // a few samples more (the extra ones land in a small tail) or fewer, resampled in place
+    float* planes[AV_NUM_DATA_POINTERS];
+    for (int ch = 0; ch < audio_channels_; ch++) {
+        planes[ch] = reinterpret_cast<float*>(audio_frame_->data[ch]);
+    }
+    audio_ring_->read(planes, audio_channels_, std::min(plan.consume, frame_size));
+
+    if (plan.consume != frame_size) {
+        int extra = std::max(plan.consume - frame_size, 0);
+        float* tails[AV_NUM_DATA_POINTERS];
+        audio_tail_planes_.resize(audio_channels_);
         for (int ch = 0; ch < audio_channels_; ch++) {
-            planes[ch][sample] = audio_buffer_[sample * audio_channels_ + ch];
+            if (audio_tail_planes_[ch].size() < static_cast<size_t>(extra)) {
+                audio_tail_planes_[ch].resize(extra);
+            }
+            tails[ch] = audio_tail_planes_[ch].data();
+        }
+        if (extra > 0) {
+            audio_ring_->read(tails, audio_channels_, extra);
+        }
+        for (int ch = 0; ch < audio_channels_; ch++) {
+            resamplePlaneInPlace(planes[ch], tails[ch], plan.consume, frame_size);
         }
     }
 
     audio_frame_->pts = audio_samples_written_;
-    audio_samples_written_ += audio_codec_ctx_->frame_size;
-
-    audio_buffer_.erase(audio_buffer_.begin(), audio_buffer_.begin() + samples_needed);
+    audio_samples_written_ += frame_size;
 
     int ret = ffmpeg_->avcodec_send_frame(audio_codec_ctx_.get(), audio_frame_.get());
     if (ret < 0) {
@@ -708,7 +1084,8 @@ bool BrowserInput::encodeAudio(AVPacket* packet) {
 }
 
 bool BrowserInput::hasAudioData() const {
-    return !audio_buffer_.empty();
+    return audio_ring_ && audio_codec_ctx_ &&
+           audio_ring_->available() >= (size_t)audio_codec_ctx_->frame_size;
 }
 
 void BrowserInput::tryInitializeCEF() {
@@ -735,17 +1112,23 @@ void BrowserInput::tryInitializeCEF() {
     Logger::info("Using browser backend: " + std::string(backend_->getName()));
 
     backend_->setViewportSize(config_.video.width, config_.video.height);
-    backend_->setFrameCallback([this](const uint8_t* data, int width, int height) {
-        this->onFrameReceived(data, width, height);
+    backend_->setFrameRate(config_.video.fps);
+    backend_->setFrameCallback([this](const uint8_t* data, int width, int height,
+                                      const std::vector<DirtyRect>& dirty_rects) {
+        this->onFrameReceived(data, width, height, dirty_rects);
     });
+    backend_->setWakeCallback([this]() { pacer_.wake(); });
 
-    // Configure JavaScript injection (if CEF backend)
+    // Configure JavaScript injection and frame control (if CEF backend)
     CEFBackend* cef_backend = dynamic_cast<CEFBackend*>(backend_.get());
     if (cef_backend) {
+        audio_ring_ = &cef_backend->getAudioRing();
         cef_backend->setJsInjectionEnabled(config_.browser.enableJsInjection);
         if (!config_.browser.enableJsInjection) {
             Logger::info("JavaScript injection disabled (--no-js flag)");
         }
+        cef_backend->setExternalBeginFrameEnabled(config_.browser.externalBeginFrame);
+        begin_frame_mode_ = config_.browser.externalBeginFrame;
     }
 
     Logger::info("Loading URL: " + pending_uri_);
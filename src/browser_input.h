@@ -4,6 +4,10 @@
 #include "stream_input.h"
 #include "browser_backend.h"
 #include "ffmpeg_deleters.h"
+#include "triple_buffer.h"
+#include "keyframe_planner.h"
+#include "frame_pacer.h"
+#include "av_sync.h"
 #include "config.h"
 
 #include <string>
@@ -16,6 +20,7 @@
 
 // Forward declarations
 class FFmpegContext;
+class AudioRingBuffer;
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -38,7 +43,12 @@ public:
     std::string getTypeName() const override;
     bool isProgrammatic() const override { return true; }
 
-    void setPageReloadCallback(std::function<bool()> callback) { pageReloadCallback_ = callback; }
+    /**
+     * Set the callback that restarts the output after a discontinuity
+     * Called when the timeline really breaks (not on page reloads, which continue in-stream);
+     * timestamps restart at 0 afterwards
+     */
+    void setDiscontinuityCallback(std::function<bool()> callback) { discontinuityCallback_ = callback; }
     bool resetEncoders();
 
 private:
@@ -57,28 +67,57 @@ private:
     int video_stream_index_;
     int audio_stream_index_;
 
-    std::mutex frame_mutex_;
+    // BGRA frame as painted by the browser (one triple-buffer slot)
+    struct BrowserFrame {
+        std::vector<uint8_t> bgra;
+        int width = 0;
+        int height = 0;
+        std::vector<DirtyRect> dirty;  // Changed since the previous paint (sequence - 1)
+        bool all_dirty = true;         // Whole frame changed (dirty is unused)
+        uint64_t sequence = 0;         // Paint number; a gap means readPacket skipped a paint
+    };
+
     std::mutex encoder_mutex_;
-    std::vector<uint8_t> current_frame_;
-    bool frame_ready_;
+    TripleBuffer<BrowserFrame> frames_;  // Paint callback → readPacket, written once, read in place
+    uint64_t paint_sequence_ = 0;        // Paint thread: sequence of the last published frame
+    int painted_width_ = 0;              // Paint thread: size of the previous paint
+    int painted_height_ = 0;
+    std::vector<uint64_t> tile_hashes_;  // Paint thread: content hash per change-detection tile
+    std::vector<uint8_t> tile_changed_;  // Paint thread: scratch, per tile
+    std::vector<DirtyRect> changed_rects_;  // Paint thread: scratch, runs of changed tiles
+    std::atomic<bool> force_full_paint_{false};  // readPacket needs a frame even if nothing changed
+    bool yuv_valid_ = false;             // yuv_frame_ holds the previous frame (dirty regions suffice)
+    uint64_t converted_sequence_ = 0;    // Sequence of the frame converted into yuv_frame_
+    bool has_converted_frame_ = false;   // yuv_frame_ holds a picture that can be re-encoded
+    std::vector<uint8_t> dirty_blocks_;  // Per 16x16 macroblock: needs conversion
+    int64_t converted_pixels_ = 0;       // Conversion stats since the last log line
+    int64_t frame_pixels_ = 0;
+    int64_t static_frames_ = 0;
     std::atomic<bool> resetting_encoders_;
     std::atomic<bool> received_real_frame_{false};
+    KeyframePlanner keyframe_planner_;  // IDR on every HLS segment boundary
     int64_t frame_count_;
-    int64_t start_time_ms_;
+    FramePacer pacer_;  // Frame deadlines; started by the first encoded frame, woken by paints/audio/CEF
+    bool begin_frame_mode_ = false;                 // Browser renders only on requestBeginFrame()
+    FramePacer::Clock::time_point last_begin_frame_;
     int snapshot_width_;
     int snapshot_height_;
 
-    std::vector<float> audio_buffer_;
+    AudioRingBuffer* audio_ring_ = nullptr;  // Owned by the CEF backend (planar, lock-free)
     int audio_channels_;
     int audio_sample_rate_;
     int64_t audio_samples_written_;
     int64_t audio_start_pts_;
     bool audio_stream_started_;
+    bool logged_audio_discard_ = false;
+    AVSync av_sync_;  // Audio timestamps follow the frame clock (CEF audio PTS, drift correction)
+    std::vector<std::vector<float>> audio_tail_planes_;  // Drift correction: samples beyond the frame size
 
     bool initialized_;
     std::atomic<bool> running_;
 
-    std::function<bool()> pageReloadCallback_;
+    std::function<bool()> discontinuityCallback_;
+    bool reload_keyframe_pending_ = false;  // Page reloaded: force an IDR on the first new paint
 
     // CEF initialization
     std::atomic<bool> cef_initialized_{false};
@@ -87,14 +126,21 @@ private:
 
     bool setupEncoder(bool is_reset = false);
     bool setupAudioEncoder(int sample_rate, int channels, bool is_reset = false);
+    bool updateScaler(int width, int height);
     bool convertBGRAtoYUV(const uint8_t* bgra_data, AVFrame* yuv_frame);
     bool convertBGRAtoYUVWithCrop(const uint8_t* bgra_data, int src_width, int src_height, AVFrame* yuv_frame);
+    bool convertFrame(const BrowserFrame& frame);
+    void convertDirtyBlocks(const BrowserFrame& frame, int width, int height);
     bool encodeFrame(AVFrame* frame, AVPacket* packet);
     bool encodeAudio(AVPacket* packet);
     bool hasAudioData() const;
 
-    void onFrameReceived(const uint8_t* bgra_data, int width, int height);
+    void onFrameReceived(const uint8_t* bgra_data, int width, int height, const std::vector<DirtyRect>& dirty_rects);
+    bool detectChanges(const uint8_t* bgra_data, int width, int height, const std::vector<DirtyRect>& dirty_rects);
     void pullAudioFromBackend();
+    void waitForWork(FramePacer::Clock::time_point deadline);
+    void handlePageReload();
+    void requestBeginFrame();
 };
 
 #endif // BROWSER_INPUT_H
@@ -6,21 +6,17 @@
 #include <include/cef_life_span_handler.h>
 #include <include/cef_load_handler.h>
 #include <include/cef_audio_handler.h>
-#include <include/cef_command_line.h>
-#include <include/cef_version.h>
-#include <include/cef_api_hash.h>
 
 #include "cef_backend.h"
-#include "cef_loader.h"
+#include "cef_runtime.h"
 #include "logger.h"
-#include "obs_detector.h"
 #include "all_cef_scripts.h"  // Auto-generated CEF injection scripts
 
+#include <algorithm>
 #include <cstring>
 #include <cstdlib>  // for std::getenv
 #include <thread>
 #include <chrono>
-#include <filesystem>  // for std::filesystem
 
 #ifdef _WIN32
 #include <windows.h>
@@ -36,59 +32,23 @@
 namespace {
     constexpr int AUDIO_PACKET_INITIAL_LOG_COUNT = 10;  // Log first N audio packets
     constexpr int AUDIO_PACKET_LOG_INTERVAL = 100;      // Then log every N packets
-}
 
-// Simple app to configure command-line switches (OBS-style, multi-process with CEF standalone)
-class SimpleApp : public CefApp {
-public:
-    void OnBeforeCommandLineProcessing(
-        const CefString& process_type,
-        CefRefPtr<CefCommandLine> command_line) override {
-        // Performance optimizations: Disable GPU rendering (use software rasterizer)
-        command_line->AppendSwitch("disable-gpu");
-        // NOTE: DO NOT disable-software-rasterizer - CEF needs it when GPU is disabled
-
-        // Startup acceleration: Disable unnecessary components
-        command_line->AppendSwitch("disable-extensions");
-        command_line->AppendSwitch("disable-plugins");
-        command_line->AppendSwitch("disable-component-update");
-        command_line->AppendSwitch("disable-background-networking");
-        command_line->AppendSwitch("disable-pdf-extension");
-        command_line->AppendSwitch("disable-hang-monitor");
-        command_line->AppendSwitch("no-proxy-server");
-        command_line->AppendSwitch("no-first-run");
-        command_line->AppendSwitch("no-default-browser-check");
-
-        // Additional startup optimizations
-        command_line->AppendSwitch("disable-sync");
-        command_line->AppendSwitch("disable-domain-reliability");
-        command_line->AppendSwitch("disable-breakpad");
-        command_line->AppendSwitch("metrics-recording-only");
-        command_line->AppendSwitch("disable-client-side-phishing-detection");
-        command_line->AppendSwitch("disable-notifications");
-        command_line->AppendSwitch("disable-speech-api");
-        command_line->AppendSwitch("disable-geolocation");
-        command_line->AppendSwitch("disable-sensors");
-
-        // Minimal cache sizes (1MB each)
-        command_line->AppendSwitchWithValue("disk-cache-size", "1048576");
-        command_line->AppendSwitchWithValue("media-cache-size", "1048576");
-
-        // Audio/Video: Critical for YouTube autoplay
-        command_line->AppendSwitchWithValue("autoplay-policy", "no-user-gesture-required");
-        command_line->AppendSwitchWithValue("disable-features", "HardwareMediaKeyHandling,WebBluetooth");
-
-        #ifndef _WIN32
-        // Linux-specific: Critical for subprocess stability
-        command_line->AppendSwitchWithValue("ozone-platform", "x11");
-        #endif
-
-        Logger::info("CEF command line configured (OBS-style, multi-process, optimized startup)");
-    }
+    // Audio ring buffer (preallocated once: 2 planes x 256K samples = 2 MB, ~5.4s at 48kHz)
+    constexpr int AUDIO_RING_CHANNELS = 2;              // AAC encoder is mono or stereo
+    constexpr size_t AUDIO_RING_CAPACITY_FRAMES = 1 << 18;
 
-private:
-    IMPLEMENT_REFCOUNTING(SimpleApp);
-};
+    // Audio PTS → steady_clock offset: a larger step is a wall clock change (re-anchor),
+    // smaller increases are followed slowly (the lowest-latency packet is the best estimate)
+    constexpr int64_t AUDIO_PTS_JUMP_US = 1000000;
+    constexpr int64_t AUDIO_PTS_OFFSET_LEAK = 256;
+
+    // CEF's limits for CefBrowserSettings::windowless_frame_rate
+    constexpr int CEF_MIN_FRAME_RATE = 1;
+    constexpr int CEF_MAX_FRAME_RATE = 60;
+
+    // Longest wait for a closing browser to release its handlers
+    constexpr int BROWSER_CLOSE_TIMEOUT_MS = 2000;
+}
 
 // Simple render handler to capture frames
 class SimpleRenderHandler : public CefRenderHandler {
@@ -96,23 +56,29 @@ public:
     explicit SimpleRenderHandler(CEFBackend* backend) : backend_(backend) {}
 
     // CefRenderHandler methods
-    void GetViewRect(CefRefPtr<CefBrowser> browser, CefRect& rect) override {
+    void GetViewRect(CefRefPtr<CefBrowser> /*browser*/, CefRect& rect) override {
         rect = CefRect(0, 0, backend_->width_, backend_->height_);
     }
 
-    void OnPaint(CefRefPtr<CefBrowser> browser,
+    void OnPaint(CefRefPtr<CefBrowser> /*browser*/,
                  PaintElementType type,
                  const RectList& dirtyRects,
                  const void* buffer,
                  int width,
                  int height) override {
         if (type == PET_VIEW) {
-            backend_->onPaint(buffer, width, height);
+            // Reused across paints (OnPaint always runs on the CEF UI thread)
+            dirty_rects_.clear();
+            for (const CefRect& rect : dirtyRects) {
+                dirty_rects_.push_back(DirtyRect{rect.x, rect.y, rect.width, rect.height});
+            }
+            backend_->onPaint(buffer, width, height, dirty_rects_);
         }
     }
 
 private:
     CEFBackend* backend_;
+    std::vector<DirtyRect> dirty_rects_;
     IMPLEMENT_REFCOUNTING(SimpleRenderHandler);
 };
 
@@ -128,8 +94,9 @@ public:
         backend_->setBrowser(new CefRefPtr<CefBrowser>(browser));
     }
 
-    void OnBeforeClose(CefRefPtr<CefBrowser> browser) override {
+    void OnBeforeClose(CefRefPtr<CefBrowser> /*browser*/) override {
         Logger::info("CEF browser closing");
+        backend_->onBeforeClose();
     }
 
 private:
@@ -142,17 +109,17 @@ class SimpleLoadHandler : public CefLoadHandler {
 public:
     explicit SimpleLoadHandler(CEFBackend* backend) : backend_(backend) {}
 
-    void OnLoadEnd(CefRefPtr<CefBrowser> browser,
+    void OnLoadEnd(CefRefPtr<CefBrowser> /*browser*/,
                    CefRefPtr<CefFrame> frame,
-                   int httpStatusCode) override {
+                   int /*httpStatusCode*/) override {
         if (frame->IsMain()) {
             backend_->onLoadEnd();
         }
     }
 
-    void OnLoadError(CefRefPtr<CefBrowser> browser,
+    void OnLoadError(CefRefPtr<CefBrowser> /*browser*/,
                      CefRefPtr<CefFrame> frame,
-                     ErrorCode errorCode,
+                     ErrorCode /*errorCode*/,
                      const CefString& errorText,
                      const CefString& failedUrl) override {
         if (frame->IsMain()) {
@@ -171,7 +138,7 @@ public:
     explicit SimpleAudioHandler(CEFBackend* backend) : backend_(backend) {}
 
     // Called when audio stream starts
-    void OnAudioStreamStarted(CefRefPtr<CefBrowser> browser,
+    void OnAudioStreamStarted(CefRefPtr<CefBrowser> /*browser*/,
                               const CefAudioParameters& params,
                               int channels) override {
         Logger::info("Audio stream started: " + std::to_string(channels) + " channels, " +
@@ -182,7 +149,7 @@ public:
     }
 
     // Called when PCM audio packet arrives
-    void OnAudioStreamPacket(CefRefPtr<CefBrowser> browser,
+    void OnAudioStreamPacket(CefRefPtr<CefBrowser> /*browser*/,
                              const float** data,
                              int frames,
                              int64_t pts) override {
@@ -192,13 +159,13 @@ public:
     }
 
     // Called when audio stream stops
-    void OnAudioStreamStopped(CefRefPtr<CefBrowser> browser) override {
+    void OnAudioStreamStopped(CefRefPtr<CefBrowser> /*browser*/) override {
         Logger::info("Audio stream stopped");
         backend_->onAudioStreamStopped();
     }
 
     // Called on audio error
-    void OnAudioStreamError(CefRefPtr<CefBrowser> browser,
+    void OnAudioStreamError(CefRefPtr<CefBrowser> /*browser*/,
                             const CefString& message) override {
         Logger::error("Audio stream error: " + message.ToString());
         backend_->onAudioStreamError(message.ToString());
@@ -253,45 +220,19 @@ CEFBackend::CEFBackend()
     , page_reloaded_(false)
     , browser_created_(false)
     , load_error_(false)
-    , cef_initialized_(false)
     , enable_js_injection_(true)
+    , frame_rate_(30)
+    , external_begin_frame_(false)
     , audio_channels_(0)
     , audio_sample_rate_(0)
-    , audio_streaming_(false) {
+    , audio_streaming_(false)
+    , audio_ring_(AUDIO_RING_CHANNELS, AUDIO_RING_CAPACITY_FRAMES) {
 }
 
 CEFBackend::~CEFBackend() {
     shutdown();
 }
 
-bool CEFBackend::loadCEFLibrary() {
-    // Load CEF dynamically from OBS installation (like ffmpeg_loader)
-    OBSPaths obsPaths = OBSDetector::detect();
-    if (!obsPaths.found) {
-        Logger::error("OBS not detected - cannot load CEF");
-        Logger::error("Install OBS Studio to use browser source:");
-        #ifdef _WIN32
-        Logger::error("  Download from: https://obsproject.com/download");
-        #else
-        Logger::error("  sudo apt install obs-studio");
-        #endif
-        return false;
-    }
-
-    Logger::info("OBS detected - loading CEF from OBS installation");
-    Logger::info("  CEF path: " + obsPaths.cef_path);
-
-    // Load CEF dynamically (LoadLibrary/dlopen)
-    if (!::loadCEFLibrary(obsPaths.cef_path)) {
-        Logger::error("Failed to load CEF from OBS");
-        Logger::error("  Path tried: " + obsPaths.cef_path);
-        return false;
-    }
-
-    Logger::info("CEF loaded successfully from OBS");
-    return true;
-}
-
 bool CEFBackend::initialize() {
     if (initialized_) {
         return true;
@@ -299,13 +240,9 @@ bool CEFBackend::initialize() {
 
     Logger::info("Initializing CEF backend...");
 
-    // Load CEF library
-    if (!loadCEFLibrary()) {
-        return false;
-    }
-
-    // Initialize CEF
-    if (!initializeCEF()) {
+    // Shared CEF instance (loaded and initialized by the first browser of the process)
+    runtime_ = CefRuntime::acquire();
+    if (!runtime_) {
         return false;
     }
 
@@ -314,133 +251,14 @@ bool CEFBackend::initialize() {
     return true;
 }
 
-bool CEFBackend::checkCEFVersion() {
-    // Get runtime CEF version from loaded libcef.so
-    int runtime_cef_major = cef_version_info(0);
-    int runtime_cef_minor = cef_version_info(1);
-    int runtime_cef_patch = cef_version_info(2);
-    int runtime_chrome_major = cef_version_info(4);
-    int runtime_chrome_minor = cef_version_info(5);
-    int runtime_chrome_build = cef_version_info(6);
-    int runtime_chrome_patch = cef_version_info(7);
-
-    // Get compile-time CEF version from headers
-    int compiled_cef_major = CEF_VERSION_MAJOR;
-    int compiled_chrome_build = CHROME_VERSION_BUILD;
-
-    // Log detected versions
-    Logger::info("CEF version detected:");
-    Logger::info("  Runtime:  CEF " + std::to_string(runtime_cef_major) + "." +
-                std::to_string(runtime_cef_minor) + "." + std::to_string(runtime_cef_patch) +
-                " (Chromium " + std::to_string(runtime_chrome_major) + ".0." +
-                std::to_string(runtime_chrome_build) + "." + std::to_string(runtime_chrome_patch) + ")");
-    Logger::info("  Compiled: CEF " + std::to_string(compiled_cef_major) + ".x.x (Chromium " +
-                std::to_string(CHROME_VERSION_MAJOR) + ".0." + std::to_string(compiled_chrome_build) + ".x)");
-
-    // Check API hash for binary compatibility (this is the REAL compatibility test)
-    const char* runtime_hash = cef_api_hash(0);  // Platform hash
-    const char* compiled_hash = CEF_API_HASH_PLATFORM;
-
-    if (strcmp(runtime_hash, compiled_hash) != 0) {
-        Logger::error("╔════════════════════════════════════════════════════════════╗");
-        Logger::error("║       CEF API INCOMPATIBILITY DETECTED!                    ║");
-        Logger::error("╚════════════════════════════════════════════════════════════╝");
-        Logger::error("");
-        Logger::error("API hash mismatch - binary compatibility broken:");
-        Logger::error("  Runtime:  " + std::string(runtime_hash));
-        Logger::error("  Compiled: " + std::string(compiled_hash));
-        Logger::error("");
-        Logger::error("OBS has updated to an incompatible CEF version.");
-        Logger::error("You MUST recompile hls-generator:");
-        Logger::error("  cd build && cmake .. && make");
-        Logger::error("");
-        return false;
-    }
-
-    // Informational warnings for version differences (but API is compatible)
-    if (runtime_chrome_build != compiled_chrome_build) {
-        Logger::warn("CEF Chromium build differs (compiled=" + std::to_string(compiled_chrome_build) +
-                    ", runtime=" + std::to_string(runtime_chrome_build) + ")");
-        Logger::warn("API is compatible, but recompilation recommended for optimal performance.");
+void CEFBackend::postTask(std::function<void()> task) {
+    if (runtime_) {
+        runtime_->postTask(std::move(task));
     }
-
-    if (runtime_cef_major != compiled_cef_major) {
-        Logger::warn("CEF major version differs (compiled=" + std::to_string(compiled_cef_major) +
-                    ", runtime=" + std::to_string(runtime_cef_major) + ")");
-        Logger::warn("API is compatible, but recompilation recommended.");
-    }
-
-    Logger::info("CEF version check: OK (API compatible)");
-    return true;
 }
 
-bool CEFBackend::initializeCEF() {
-    if (cef_initialized_) {
-        return true;
-    }
-
-    Logger::info("Initializing CEF...");
-
-    // Create app handler to configure command line switches
-    CefRefPtr<CefApp> app = new SimpleApp();
-
-    // Set up CEF main args
-#ifdef PLATFORM_WINDOWS
-    CefMainArgs main_args(GetModuleHandle(nullptr));
-#else
-    CefMainArgs main_args(0, nullptr);
-#endif
-
-    // Set up CEF settings (multi-process with CEF standalone)
-    CefSettings settings;
-    settings.no_sandbox = true;
-    settings.windowless_rendering_enabled = true;
-    settings.multi_threaded_message_loop = false;
-    settings.log_severity = LOGSEVERITY_DISABLE;  // Disable debug.log generation
-
-    // No cache needed - cookies are auto-accepted via JavaScript every time
-    // CEF will use in-memory cache only
-    cache_path_ = "";  // Empty = no cache to cleanup
-    Logger::info("Running without persistent cache (in-memory only)");
-    Logger::info("Cookies will be auto-accepted via JavaScript");
-
-    // Set browser subprocess path to OBS's obs-browser-page helper
-    OBSPaths obsPaths = OBSDetector::detect();
-    std::string subprocess_path = obsPaths.subprocess_path;
-
-    if (!subprocess_path.empty()) {
-        CefString(&settings.browser_subprocess_path).FromASCII(subprocess_path.c_str());
-        Logger::info("CEF subprocess path: " + subprocess_path);
-    } else {
-        Logger::warn("No subprocess path found - CEF may not work correctly");
-    }
-
-    // Resources are provided by OBS's libcef.dll/so (embedded)
-    // We don't need to set resources_dir_path, locales_dir_path, or framework_dir_path
-    // because OBS's CEF has these paths compiled in
-
-    Logger::info("CEF paths configured:");
-    Logger::info("  Using OBS's embedded CEF resources");
-
-    // Initialize CEF using the C++ API with app handler
-    bool result = CefInitialize(main_args, settings, app.get(), nullptr);
-
-    if (!result) {
-        Logger::error("CefInitialize failed");
-        return false;
-    }
-
-    cef_initialized_ = true;
-    Logger::info("CEF initialized successfully");
-
-    // Verify CEF version compatibility
-    if (!checkCEFVersion()) {
-        Logger::error("CEF version check failed - binary incompatibility detected");
-        cleanupCEF();
-        return false;
-    }
-
-    return true;
+bool CEFBackend::runTask(std::function<bool()> task) {
+    return runtime_ ? runtime_->runTask(std::move(task)) : false;
 }
 
 bool CEFBackend::loadURL(const std::string& url) {
@@ -451,10 +269,11 @@ bool CEFBackend::loadURL(const std::string& url) {
 
     Logger::info("Loading URL: " + url);
 
-    // Create browser with URL
-    createBrowser(url);
-
-    return browser_created_;
+    // Create browser with URL (on the message-loop thread, which keeps pumping afterwards)
+    return runTask([this, url]() {
+        createBrowser(url);
+        return browser_created_.load();
+    });
 }
 
 void CEFBackend::createBrowser(const std::string& url) {
@@ -472,13 +291,19 @@ void CEFBackend::createBrowser(const std::string& url) {
     // Set up window info for off-screen rendering (OBS-style multi-process)
     CefWindowInfo window_info;
     window_info.SetAsWindowless(0);  // 0 = no parent window
-    // NOTE: external_begin_frame_enabled causes deadlock in our single-threaded model
-    // OBS uses it with complex multi-threaded architecture we don't have
-    // window_info.external_begin_frame_enabled = true;
+    // External BeginFrame: BrowserInput sends one BeginFrame per output frame from the
+    // thread that pumps the message loop and never blocks waiting for the paint
+    // (a missed paint repeats the previous picture), so the loop keeps running
+    window_info.external_begin_frame_enabled = external_begin_frame_ ? 1 : 0;
 
-    // Set up browser settings (auto frame generation at 30fps, audio muted)
+    // Set up browser settings (auto frame generation at the output rate, audio muted)
     CefBrowserSettings browser_settings;
-    browser_settings.windowless_frame_rate = 30;  // CEF auto-generates frames at 30fps
+    browser_settings.windowless_frame_rate = frame_rate_;
+    if (external_begin_frame_) {
+        Logger::info("CEF rendering: external BeginFrame (one frame per output frame)");
+    } else {
+        Logger::info("CEF rendering: " + std::to_string(frame_rate_) + " fps");
+    }
 
     // Mute audio - we only capture it, don't play it through speakers
     CefString(&browser_settings.default_encoding).FromASCII("utf-8");
@@ -537,33 +362,35 @@ void CEFBackend::setBrowser(void* browser) {
 }
 
 void CEFBackend::setViewportSize(int width, int height) {
-    width_ = width;
-    height_ = height;
-
     Logger::info("CEF viewport: " + std::to_string(width) + "x" + std::to_string(height));
 
-    // If browser already exists, notify it of size change
-    if (browser_) {
-        CefRefPtr<CefBrowser>* browser_ptr = static_cast<CefRefPtr<CefBrowser>*>(browser_);
-        if (browser_ptr && browser_ptr->get()) {
-            (*browser_ptr)->GetHost()->WasResized();
+    // GetViewRect reads the size on the message-loop thread
+    postTask([this, width, height]() {
+        width_ = width;
+        height_ = height;
+
+        // If browser already exists, notify it of size change
+        if (browser_) {
+            CefRefPtr<CefBrowser>* browser_ptr = static_cast<CefRefPtr<CefBrowser>*>(browser_);
+            if (browser_ptr && browser_ptr->get()) {
+                (*browser_ptr)->GetHost()->WasResized();
+            }
         }
-    }
+    });
 }
 
-void CEFBackend::setFrameCallback(std::function<void(const uint8_t*, int, int)> callback) {
+void CEFBackend::setFrameCallback(FrameCallback callback) {
     frame_callback_ = callback;
 }
 
-void CEFBackend::processEvents() {
-    if (!initialized_ || !cef_initialized_) {
-        return;
-    }
+void CEFBackend::setWakeCallback(std::function<void()> callback) {
+    wake_callback_ = callback;
+}
 
-    // Process CEF message loop (C++ API)
-    // Note: We call SendExternalBeginFrame() from browser_input when needed,
-    // not here in every processEvents call
-    CefDoMessageLoopWork();
+void CEFBackend::wake() {
+    if (wake_callback_) {
+        wake_callback_();
+    }
 }
 
 bool CEFBackend::isPageLoaded() const {
@@ -572,23 +399,45 @@ bool CEFBackend::isPageLoaded() const {
 
 void CEFBackend::invalidate() {
     // Force browser to repaint (like OBS does)
-    if (browser_ && page_loaded_) {
-        CefRefPtr<CefBrowser>* browser_ptr = static_cast<CefRefPtr<CefBrowser>*>(browser_);
-        if (browser_ptr && browser_ptr->get()) {
-            (*browser_ptr)->GetHost()->Invalidate(PET_VIEW);
+    postTask([this]() {
+        if (browser_ && page_loaded_) {
+            CefRefPtr<CefBrowser>* browser_ptr = static_cast<CefRefPtr<CefBrowser>*>(browser_);
+            if (browser_ptr && browser_ptr->get()) {
+                (*browser_ptr)->GetHost()->Invalidate(PET_VIEW);
+            }
         }
+    });
+}
+
+void CEFBackend::setFrameRate(int fps) {
+    int frame_rate = std::clamp(fps, CEF_MIN_FRAME_RATE, CEF_MAX_FRAME_RATE);
+    if (frame_rate != fps) {
+        Logger::warn("CEF renders at most " + std::to_string(CEF_MAX_FRAME_RATE) + " fps - browser frame rate " +
+                     std::to_string(fps) + " clamped to " + std::to_string(frame_rate) + " (frames are repeated)");
     }
+
+    postTask([this, frame_rate]() {
+        frame_rate_ = frame_rate;
+        if (browser_) {
+            CefRefPtr<CefBrowser>* browser_ptr = static_cast<CefRefPtr<CefBrowser>*>(browser_);
+            if (browser_ptr && browser_ptr->get()) {
+                (*browser_ptr)->GetHost()->SetWindowlessFrameRate(frame_rate_);
+            }
+        }
+    });
 }
 
 void CEFBackend::signalBeginFrame() {
     // Signal CEF to generate next frame (OBS-style external frame control)
     // Only call this when page is loaded and we actually need a frame
-    if (browser_ && page_loaded_) {
-        CefRefPtr<CefBrowser>* browser_ptr = static_cast<CefRefPtr<CefBrowser>*>(browser_);
-        if (browser_ptr && browser_ptr->get()) {
-            (*browser_ptr)->GetHost()->SendExternalBeginFrame();
+    postTask([this]() {
+        if (external_begin_frame_ && browser_ && page_loaded_) {
+            CefRefPtr<CefBrowser>* browser_ptr = static_cast<CefRefPtr<CefBrowser>*>(browser_);
+            if (browser_ptr && browser_ptr->get()) {
+                (*browser_ptr)->GetHost()->SendExternalBeginFrame();
+            }
         }
-    }
+    });
 }
 
 void CEFBackend::shutdown() {
@@ -598,58 +447,67 @@ void CEFBackend::shutdown() {
 
     Logger::info("Shutting down CEF backend...");
 
-    // Clean up browser
-    if (browser_) {
+    // Close this browser (other browsers keep sharing the runtime). Its handlers point
+    // at this backend, so wait until CEF is done with it (OnBeforeClose)
+    bool closing = runTask([this]() {
+        frame_callback_ = nullptr;
+        wake_callback_ = nullptr;
+        if (!browser_) {
+            return false;
+        }
         CefRefPtr<CefBrowser>* browser_ptr = static_cast<CefRefPtr<CefBrowser>*>(browser_);
-        delete browser_ptr;
-        browser_ = nullptr;
+        if (!browser_ptr->get()) {
+            return false;
+        }
+        (*browser_ptr)->GetHost()->CloseBrowser(true);
+        return true;
+    });
+    if (closing) {
+        std::unique_lock<std::mutex> lock(close_mutex_);
+        if (!close_cond_.wait_for(lock, std::chrono::milliseconds(BROWSER_CLOSE_TIMEOUT_MS),
+                                  [this]() { return browser_closed_; })) {
+            Logger::warn("CEF browser did not close within " + std::to_string(BROWSER_CLOSE_TIMEOUT_MS) + " ms");
+        }
     }
 
-    // Clean up client
-    if (client_) {
-        CefRefPtr<CefClient>* client_ptr = static_cast<CefRefPtr<CefClient>*>(client_);
-        delete client_ptr;
-        client_ = nullptr;
-    }
+    // Browser references belong to the message-loop thread
+    runTask([this]() {
+        // Clean up browser
+        if (browser_) {
+            CefRefPtr<CefBrowser>* browser_ptr = static_cast<CefRefPtr<CefBrowser>*>(browser_);
+            delete browser_ptr;
+            browser_ = nullptr;
+        }
 
-    cleanupCEF();
+        // Clean up client
+        if (client_) {
+            CefRefPtr<CefClient>* client_ptr = static_cast<CefRefPtr<CefClient>*>(client_);
+            delete client_ptr;
+            client_ = nullptr;
+        }
+        return true;
+    });
 
+    // The last browser of the process shuts CEF down
+    runtime_.reset();
     initialized_ = false;
 }
 
-void CEFBackend::cleanupCacheDirectory() {
-    if (!cache_path_.empty() && std::filesystem::exists(cache_path_)) {
-        try {
-            std::filesystem::remove_all(cache_path_);
-            Logger::info("Cleaned up temporary cache: " + cache_path_);
-        } catch (const std::exception& e) {
-            Logger::warn("Could not cleanup cache: " + std::string(e.what()));
-        }
-    }
-}
-
-void CEFBackend::cleanupCEF() {
-    if (cef_initialized_) {
-        Logger::info("Shutting down CEF...");
-        CefShutdown();
-        cef_initialized_ = false;
+void CEFBackend::onBeforeClose() {
+    {
+        std::lock_guard<std::mutex> lock(close_mutex_);
+        browser_closed_ = true;
     }
-
-    // No cache to cleanup (using in-memory only)
+    close_cond_.notify_all();
 }
 
-void CEFBackend::onPaint(const void* buffer, int width, int height) {
-    std::lock_guard<std::mutex> lock(frame_mutex_);
-
-    // Copy frame data (BGRA format)
-    size_t size = width * height * 4;
-    frame_buffer_.resize(size);
-    std::memcpy(frame_buffer_.data(), buffer, size);
-
-    // Call frame callback
+void CEFBackend::onPaint(const void* buffer, int width, int height, const std::vector<DirtyRect>& dirtyRects) {
+    // Hand CEF's paint buffer (BGRA) straight to the callback: it is valid for the
+    // duration of OnPaint, and the callback copies what it needs exactly once
     if (frame_callback_) {
-        frame_callback_(frame_buffer_.data(), width, height);
+        frame_callback_(static_cast<const uint8_t*>(buffer), width, height, dirtyRects);
     }
+    wake();
 }
 
 void CEFBackend::onLoadEnd() {
@@ -696,88 +554,108 @@ bool CEFBackend::hasLoadError() const {
     return load_error_;
 }
 
-// Audio stream callbacks
-void CEFBackend::onAudioStreamStarted(int channels, int sample_rate, int frames_per_buffer) {
-    std::lock_guard<std::mutex> lock(audio_mutex_);
-
+// Audio stream callbacks (CEF audio thread)
+void CEFBackend::onAudioStreamStarted(int channels, int sample_rate, int /*frames_per_buffer*/) {
     audio_channels_ = channels;
     audio_sample_rate_ = sample_rate;
     audio_streaming_ = true;
-
-    // Reserve buffer space (10 seconds worth of samples)
-    size_t buffer_size = channels * sample_rate * 10;
-    audio_buffer_.reserve(buffer_size);
+    {
+        // New stream: PTS restarts, the clock is re-anchored by its first packet
+        std::lock_guard<std::mutex> lock(audio_clock_mutex_);
+        audio_clock_valid_ = false;
+    }
 
     Logger::info("Audio capture started: " + std::to_string(channels) + " channels @ " +
                  std::to_string(sample_rate) + " Hz");
 }
 
 void CEFBackend::onAudioStreamPacket(const float** data, int frames, int channels, int64_t pts) {
-    if (!audio_streaming_) {
+    if (!audio_streaming_ || !data || frames <= 0 || channels <= 0) {
         return;
     }
 
-    std::lock_guard<std::mutex> lock(audio_mutex_);
-
     // CEF provides planar audio: data[0] = left channel, data[1] = right channel, etc.
-    // We need to interleave it: [L, R, L, R, L, R, ...]
-
-    // Calculate total samples
-    size_t total_samples = frames * channels;
-    size_t old_size = audio_buffer_.size();
-    audio_buffer_.resize(old_size + total_samples);
-
-    // Interleave channels
-    for (int frame = 0; frame < frames; frame++) {
-        for (int ch = 0; ch < channels; ch++) {
-            audio_buffer_[old_size + frame * channels + ch] = data[ch][frame];
-        }
-    }
+    // Copied plane by plane into the ring (no interleaving, no lock, no allocation)
+    size_t written = audio_ring_.write(data, channels, frames);
+    updateAudioClock(pts, written);
+    wake();
 
     // Log packet reception
-    static int packet_count = 0;
-    packet_count++;
-    if (packet_count <= AUDIO_PACKET_INITIAL_LOG_COUNT || packet_count % AUDIO_PACKET_LOG_INTERVAL == 0) {
-        Logger::info("CEF audio packet #" + std::to_string(packet_count) +
-                   ": " + std::to_string(frames) + " frames (" + std::to_string(total_samples) + " samples total), " +
-                   "buffer_size=" + std::to_string(audio_buffer_.size()) +
+    audio_packet_count_++;
+    if (audio_packet_count_ <= AUDIO_PACKET_INITIAL_LOG_COUNT || audio_packet_count_ % AUDIO_PACKET_LOG_INTERVAL == 0) {
+        Logger::info("CEF audio packet #" + std::to_string(audio_packet_count_) +
+                   ": " + std::to_string(frames) + " frames, " +
+                   "ring=" + std::to_string(audio_ring_.available()) + "/" + std::to_string(audio_ring_.getCapacity()) +
                    ", ch=" + std::to_string(channels) +
                    ", sr=" + std::to_string(audio_sample_rate_));
     }
 
+    if (written < (size_t)frames) {
+        if (audio_overflow_count_++ % AUDIO_PACKET_LOG_INTERVAL == 0) {
+            Logger::warn("Audio ring buffer full - dropped " + std::to_string(frames - written) +
+                         " frames (encoder not keeping up)");
+        }
+    }
+
     // Log every second worth of audio
-    static int64_t last_log_pts = 0;
-    if (pts - last_log_pts >= 1000) {
-        Logger::info("Audio buffer: " + std::to_string(audio_buffer_.size() / channels / audio_sample_rate_) +
-                     " seconds (" + std::to_string(audio_buffer_.size() * sizeof(float) / 1024 / 1024) + " MB)");
-        last_log_pts = pts;
+    if (pts - audio_last_log_pts_ >= 1000 && audio_sample_rate_ > 0) {
+        Logger::info("Audio buffer: " + std::to_string(audio_ring_.available() / audio_sample_rate_) + " seconds");
+        audio_last_log_pts_ = pts;
     }
 }
 
+void CEFBackend::updateAudioClock(int64_t pts, size_t written) {
+    int sample_rate = audio_sample_rate_;
+    if (sample_rate <= 0) {
+        return;
+    }
+
+    // PTS is wall clock (ms since the Unix epoch); map it onto steady_clock with an offset
+    // that ignores delivery jitter (late packets) and wall clock steps
+    int64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t pts_us = pts * 1000;
+    int64_t offset_us = now_us - pts_us;
+
+    std::lock_guard<std::mutex> lock(audio_clock_mutex_);
+    if (!audio_clock_valid_ || std::abs(offset_us - audio_pts_offset_us_) > AUDIO_PTS_JUMP_US) {
+        audio_pts_offset_us_ = offset_us;
+    } else if (offset_us < audio_pts_offset_us_) {
+        audio_pts_offset_us_ = offset_us;
+    } else {
+        audio_pts_offset_us_ += (offset_us - audio_pts_offset_us_) / AUDIO_PTS_OFFSET_LEAK;
+    }
+
+    // Anchor: the sample just after this packet (PTS is the packet's first sample)
+    audio_clock_time_us_ = pts_us + audio_pts_offset_us_ + (int64_t)written * 1000000 / sample_rate;
+    audio_clock_position_ = audio_ring_.writePosition();
+    audio_clock_valid_ = true;
+}
+
+bool CEFBackend::getAudioCaptureTime(uint64_t position, std::chrono::steady_clock::time_point& time) const {
+    int sample_rate = audio_sample_rate_;
+    std::lock_guard<std::mutex> lock(audio_clock_mutex_);
+    if (!audio_clock_valid_ || sample_rate <= 0) {
+        return false;
+    }
+
+    int64_t samples = (int64_t)(position - audio_clock_position_);  // Usually negative (already buffered)
+    int64_t time_us = audio_clock_time_us_ + samples * 1000000 / sample_rate;
+    time = std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::microseconds(time_us)));
+    return true;
+}
+
 void CEFBackend::onAudioStreamStopped() {
-    std::lock_guard<std::mutex> lock(audio_mutex_);
     audio_streaming_ = false;
-    Logger::info("Audio capture stopped. Total samples: " + std::to_string(audio_buffer_.size()));
+    Logger::info("Audio capture stopped. Buffered frames: " + std::to_string(audio_ring_.available()));
 }
 
 void CEFBackend::onAudioStreamError(const std::string& message) {
-    std::lock_guard<std::mutex> lock(audio_mutex_);
     audio_streaming_ = false;
     Logger::error("Audio capture error: " + message);
 }
 
-std::vector<float> CEFBackend::getAndClearAudioBuffer() {
-    std::lock_guard<std::mutex> lock(audio_mutex_);
-    std::vector<float> buffer = std::move(audio_buffer_);
-    audio_buffer_.clear();
-    return buffer;
-}
-
-bool CEFBackend::hasAudioData() const {
-    std::lock_guard<std::mutex> lock(audio_mutex_);
-    return !audio_buffer_.empty() && audio_streaming_;
-}
-
 // Factory implementation
 extern "C" BrowserBackend* createCEFBackend() {
     CEFBackend* backend = new CEFBackend();
@@ -2,19 +2,31 @@
 #define CEF_BACKEND_H
 
 #include "browser_backend.h"
+#include "audio_ring_buffer.h"
 #include <memory>
 #include <vector>
 #include <mutex>
 #include <atomic>
 #include <string>
+#include <functional>
+#include <condition_variable>
+#include <chrono>
+
+class CefRuntime;
 
 // Forward declarations for CEF C++ types
 // CefRefPtr is defined in CEF headers, so we don't forward declare it
 // We use void* for CEF objects to avoid including CEF headers here
 
 /**
- * CEF (Chromium Embedded Framework) backend
+ * CEF (Chromium Embedded Framework) backend - one offscreen browser
  * Uses libcef.so from OBS Studio installation for offscreen rendering
+ *
+ * All browsers of the process share one CefRuntime (one CefInitialize, one
+ * render subprocess tree) and its message-loop thread, so page layout/paint
+ * and encoding never delay each other. Calls from other threads are posted to
+ * that thread; frames and audio leave it through the frame callback and the
+ * audio ring.
  */
 class CEFBackend : public BrowserBackend {
 public:
@@ -25,22 +37,30 @@ public:
     bool initialize() override;
     bool loadURL(const std::string& url) override;
     void setViewportSize(int width, int height) override;
-    void setFrameCallback(std::function<void(const uint8_t*, int, int)> callback) override;
-    void processEvents() override;
+    void setFrameRate(int fps) override;
+    void setFrameCallback(FrameCallback callback) override;
+    void setWakeCallback(std::function<void()> callback) override;
     bool isPageLoaded() const override;
     void shutdown() override;
     const char* getName() const override { return "CEF (OBS)"; }
 
-    // Force browser repaint (for continuous frame generation)
+    // Force browser repaint (for continuous frame generation), any thread
     void invalidate();
 
-    // Signal browser to generate next frame (OBS-style external frame control)
+    // Signal browser to generate next frame (OBS-style external frame control), any thread
+    // Only has an effect with external BeginFrame enabled
     void signalBeginFrame();
 
+    // External BeginFrame mode: Chromium renders only when signalBeginFrame() is called
+    // (set before loadURL)
+    void setExternalBeginFrameEnabled(bool enabled) { external_begin_frame_ = enabled; }
+    bool isExternalBeginFrameEnabled() const { return external_begin_frame_; }
+
     // CEF callbacks
-    void onPaint(const void* buffer, int width, int height);
+    void onPaint(const void* buffer, int width, int height, const std::vector<DirtyRect>& dirtyRects);
     void onLoadEnd();
     void onLoadError(const std::string& url, const std::string& error);
+    void onBeforeClose();
 
     // Audio callbacks
     void onAudioStreamStarted(int channels, int sample_rate, int frames_per_buffer);
@@ -50,12 +70,21 @@ public:
     int onGetAudioChannels() const { return audio_channels_; }
 
     // Audio buffer access (for BrowserInput to encode)
-    std::vector<float> getAndClearAudioBuffer();
+    // Planar stereo ring: CEF audio thread writes, the encoder reads AAC frames directly
+    AudioRingBuffer& getAudioRing() { return audio_ring_; }
     int getAudioChannels() const { return audio_channels_; }
     int getAudioSampleRate() const { return audio_sample_rate_; }
-    bool hasAudioData() const;
     bool isAudioStreaming() const { return audio_streaming_; }
 
+    /**
+     * Capture time of a ring sample, from CEF's audio PTS mapped onto steady_clock
+     * (the media clock the frame pacer uses)
+     * @param position Ring sample position (e.g. getAudioRing().readPosition())
+     * @param time Receives the time the sample was captured
+     * @return false until the first packet of the current audio stream arrived
+     */
+    bool getAudioCaptureTime(uint64_t position, std::chrono::steady_clock::time_point& time) const;
+
     // Check if page load failed
     bool hasLoadError() const;
 
@@ -92,30 +121,47 @@ private:
     std::atomic<bool> load_error_;
 
     // CEF-specific state
-    bool cef_initialized_;
+    std::shared_ptr<CefRuntime> runtime_;  // Shared CEF instance and message-loop thread
     bool enable_js_injection_;  // Control JavaScript injection (default: true)
+    int frame_rate_;            // windowless_frame_rate (clamped to CEF's limit)
+    bool external_begin_frame_; // Frames only on signalBeginFrame()
     std::string load_error_message_;
-    std::string cache_path_;  // Temporary cache directory path (for cleanup)
-
-    // Frame data
-    std::mutex frame_mutex_;
-    std::vector<uint8_t> frame_buffer_;
-    std::function<void(const uint8_t*, int, int)> frame_callback_;
-
-    // Audio data
-    mutable std::mutex audio_mutex_;
-    std::vector<float> audio_buffer_;  // Accumulated PCM float samples
-    int audio_channels_;
-    int audio_sample_rate_;
+
+    // Frame callback (set before the browser is created, invoked from OnPaint)
+    FrameCallback frame_callback_;
+
+    // Wakes the consumer when a frame or audio arrives
+    std::function<void()> wake_callback_;  // Set before the browser is created
+    void wake();
+
+    // Work on the runtime's message-loop thread
+    void postTask(std::function<void()> task);
+    bool runTask(std::function<bool()> task);  // Blocks until done on the loop thread
+
+    // Browser close handshake (shutdown waits for OnBeforeClose)
+    std::mutex close_mutex_;
+    std::condition_variable close_cond_;
+    bool browser_closed_ = false;
+
+    // Audio data (written on the CEF audio thread, no locks)
+    std::atomic<int> audio_channels_;
+    std::atomic<int> audio_sample_rate_;
     std::atomic<bool> audio_streaming_;
+    AudioRingBuffer audio_ring_;
+    int64_t audio_packet_count_ = 0;   // Logging (CEF audio thread, per browser)
+    int64_t audio_overflow_count_ = 0;
+    int64_t audio_last_log_pts_ = 0;
+
+    // CEF audio PTS (wall clock) → steady_clock mapping, updated per packet
+    int64_t audio_pts_offset_us_ = 0;        // steady_clock - PTS, low-pass filtered (CEF audio thread)
+    mutable std::mutex audio_clock_mutex_;
+    bool audio_clock_valid_ = false;         // Guarded by audio_clock_mutex_
+    int64_t audio_clock_time_us_ = 0;        // steady_clock time of the sample at audio_clock_position_
+    uint64_t audio_clock_position_ = 0;      // Ring write position at the end of the last packet
 
     // Helper methods
-    bool loadCEFLibrary();
-    bool checkCEFVersion();
-    bool initializeCEF();
     void createBrowser(const std::string& url);
-    void cleanupCEF();
-    void cleanupCacheDirectory();
+    void updateAudioClock(int64_t pts, size_t written);  // CEF audio thread
 };
 
 #endif // CEF_BACKEND_H
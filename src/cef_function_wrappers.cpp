@@ -25,13 +25,13 @@ cef_string_userfree_t cef_base64encode(const void* data,
                                                   size_t data_size) {
     if (CEFLib::cef_base64encode)
         return CEFLib::cef_base64encode(data, data_size);
-    return (cef_string_userfree_t){0};
+    return cef_string_userfree_t{};
 }
 
 cef_basetime_t cef_basetime_now(void) {
     if (CEFLib::cef_basetime_now)
         return CEFLib::cef_basetime_now();
-    return (cef_basetime_t){0};
+    return cef_basetime_t{};
 }
 
 int cef_begin_tracing(const cef_string_t* categories,
@@ -194,19 +194,19 @@ int cef_execute_process(const cef_main_args_t* args,
 cef_string_userfree_t cef_format_url_for_security_display(const cef_string_t* origin_url) {
     if (CEFLib::cef_format_url_for_security_display)
         return CEFLib::cef_format_url_for_security_display(origin_url);
-    return (cef_string_userfree_t){0};
+    return cef_string_userfree_t{};
 }
 
 cef_platform_thread_handle_t cef_get_current_platform_thread_handle(void) {
     if (CEFLib::cef_get_current_platform_thread_handle)
         return CEFLib::cef_get_current_platform_thread_handle();
-    return (cef_platform_thread_handle_t){0};
+    return cef_platform_thread_handle_t{};
 }
 
 cef_platform_thread_id_t cef_get_current_platform_thread_id(void) {
     if (CEFLib::cef_get_current_platform_thread_id)
         return CEFLib::cef_get_current_platform_thread_id();
-    return (cef_platform_thread_id_t){0};
+    return cef_platform_thread_id_t{};
 }
 
 int cef_get_exit_code(void) {
@@ -224,7 +224,7 @@ void cef_get_extensions_for_mime_type(const cef_string_t* mime_type,
 cef_string_userfree_t cef_get_mime_type(const cef_string_t* extension) {
     if (CEFLib::cef_get_mime_type)
         return CEFLib::cef_get_mime_type(extension);
-    return (cef_string_userfree_t){0};
+    return cef_string_userfree_t{};
 }
 
 int cef_get_min_log_level(void) {
@@ -326,7 +326,7 @@ cef_menu_model_t* cef_menu_model_create(struct _cef_menu_model_delegate_t* deleg
 int64_t cef_now_from_system_trace_time(void) {
     if (CEFLib::cef_now_from_system_trace_time)
         return CEFLib::cef_now_from_system_trace_time();
-    return (int64_t){0};
+    return int64_t{};
 }
 
 struct _cef_value_t* cef_parse_json(const cef_string_t* json_string,
@@ -558,7 +558,7 @@ int cef_string_ascii_to_wide(const char* src,
 cef_string_list_t cef_string_list_alloc(void) {
     if (CEFLib::cef_string_list_alloc)
         return CEFLib::cef_string_list_alloc();
-    return (cef_string_list_t){0};
+    return cef_string_list_t{};
 }
 
 void cef_string_list_append(cef_string_list_t list,
@@ -575,7 +575,7 @@ void cef_string_list_clear(cef_string_list_t list) {
 cef_string_list_t cef_string_list_copy(cef_string_list_t list) {
     if (CEFLib::cef_string_list_copy)
         return CEFLib::cef_string_list_copy(list);
-    return (cef_string_list_t){0};
+    return cef_string_list_t{};
 }
 
 void cef_string_list_free(cef_string_list_t list) {
@@ -600,7 +600,7 @@ int cef_string_list_value(cef_string_list_t list,
 cef_string_map_t cef_string_map_alloc(void) {
     if (CEFLib::cef_string_map_alloc)
         return CEFLib::cef_string_map_alloc();
-    return (cef_string_map_t){0};
+    return cef_string_map_t{};
 }
 
 int cef_string_map_append(cef_string_map_t map,
@@ -654,7 +654,7 @@ int cef_string_map_value(cef_string_map_t map,
 cef_string_multimap_t cef_string_multimap_alloc(void) {
     if (CEFLib::cef_string_multimap_alloc)
         return CEFLib::cef_string_multimap_alloc();
-    return (cef_string_multimap_t){0};
+    return cef_string_multimap_t{};
 }
 
 int cef_string_multimap_append(cef_string_multimap_t map,
@@ -716,7 +716,7 @@ int cef_string_multimap_value(cef_string_multimap_t map,
 cef_string_userfree_utf16_t cef_string_userfree_utf16_alloc(void) {
     if (CEFLib::cef_string_userfree_utf16_alloc)
         return CEFLib::cef_string_userfree_utf16_alloc();
-    return (cef_string_userfree_utf16_t){0};
+    return cef_string_userfree_utf16_t{};
 }
 
 void cef_string_userfree_utf16_free(cef_string_userfree_utf16_t str) {
@@ -727,7 +727,7 @@ void cef_string_userfree_utf16_free(cef_string_userfree_utf16_t str) {
 cef_string_userfree_utf8_t cef_string_userfree_utf8_alloc(void) {
     if (CEFLib::cef_string_userfree_utf8_alloc)
         return CEFLib::cef_string_userfree_utf8_alloc();
-    return (cef_string_userfree_utf8_t){0};
+    return cef_string_userfree_utf8_t{};
 }
 
 void cef_string_userfree_utf8_free(cef_string_userfree_utf8_t str) {
@@ -738,7 +738,7 @@ void cef_string_userfree_utf8_free(cef_string_userfree_utf8_t str) {
 cef_string_userfree_wide_t cef_string_userfree_wide_alloc(void) {
     if (CEFLib::cef_string_userfree_wide_alloc)
         return CEFLib::cef_string_userfree_wide_alloc();
-    return (cef_string_userfree_wide_t){0};
+    return cef_string_userfree_wide_t{};
 }
 
 void cef_string_userfree_wide_free(cef_string_userfree_wide_t str) {
@@ -1044,14 +1044,14 @@ cef_string_userfree_t cef_uridecode(const cef_string_t* text,
               cef_uri_unescape_rule_t unescape_rule) {
     if (CEFLib::cef_uridecode)
         return CEFLib::cef_uridecode(text, convert_to_utf8, unescape_rule);
-    return (cef_string_userfree_t){0};
+    return cef_string_userfree_t{};
 }
 
 cef_string_userfree_t cef_uriencode(const cef_string_t* text,
                                                int use_plus) {
     if (CEFLib::cef_uriencode)
         return CEFLib::cef_uriencode(text, use_plus);
-    return (cef_string_userfree_t){0};
+    return cef_string_userfree_t{};
 }
 
 cef_urlrequest_t* cef_urlrequest_create(struct _cef_request_t* request,
@@ -1184,7 +1184,7 @@ cef_waitable_event_t* cef_waitable_event_create(int automatic_reset,
 cef_string_userfree_t cef_write_json(struct _cef_value_t* node, cef_json_writer_options_t options) {
     if (CEFLib::cef_write_json)
         return CEFLib::cef_write_json(node, options);
-    return (cef_string_userfree_t){0};
+    return cef_string_userfree_t{};
 }
 
 cef_xml_reader_t* cef_xml_reader_create(struct _cef_stream_reader_t* stream,
@@ -0,0 +1,429 @@
+// CEF C++ API headers - MUST come first before cef_loader.h
+#include <include/cef_app.h>
+#include <include/cef_browser_process_handler.h>
+#include <include/cef_command_line.h>
+#include <include/cef_version.h>
+#include <include/cef_api_hash.h>
+
+#include "cef_runtime.h"
+#include "cef_loader.h"
+#include "logger.h"
+#include "obs_detector.h"
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <filesystem>  // for std::filesystem
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace {
+    // Longest wait between message loop iterations when CEF schedules nothing
+    // (the external pump contract only covers work CEF knows about)
+    constexpr int64_t MAX_PUMP_INTERVAL_MS = 33;
+
+    int64_t steadyNowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+// Simple app to configure command-line switches (OBS-style, multi-process with CEF standalone)
+// and to schedule the external message pump
+class SimpleApp : public CefApp, public CefBrowserProcessHandler {
+public:
+    explicit SimpleApp(CefRuntime* runtime) : runtime_(runtime) {}
+
+    CefRefPtr<CefBrowserProcessHandler> GetBrowserProcessHandler() override {
+        return this;
+    }
+
+    // Called from any thread: CEF wants CefDoMessageLoopWork() after delay_ms
+    void OnScheduleMessagePumpWork(int64_t delay_ms) override {
+        runtime_->onScheduleMessagePumpWork(delay_ms);
+    }
+
+    void OnBeforeCommandLineProcessing(
+        const CefString& /*process_type*/,
+        CefRefPtr<CefCommandLine> command_line) override {
+        // Performance optimizations: Disable GPU rendering (use software rasterizer)
+        command_line->AppendSwitch("disable-gpu");
+        // NOTE: DO NOT disable-software-rasterizer - CEF needs it when GPU is disabled
+
+        // Startup acceleration: Disable unnecessary components
+        command_line->AppendSwitch("disable-extensions");
+        command_line->AppendSwitch("disable-plugins");
+        command_line->AppendSwitch("disable-component-update");
+        command_line->AppendSwitch("disable-background-networking");
+        command_line->AppendSwitch("disable-pdf-extension");
+        command_line->AppendSwitch("disable-hang-monitor");
+        command_line->AppendSwitch("no-proxy-server");
+        command_line->AppendSwitch("no-first-run");
+        command_line->AppendSwitch("no-default-browser-check");
+
+        // Additional startup optimizations
+        command_line->AppendSwitch("disable-sync");
+        command_line->AppendSwitch("disable-domain-reliability");
+        command_line->AppendSwitch("disable-breakpad");
+        command_line->AppendSwitch("metrics-recording-only");
+        command_line->AppendSwitch("disable-client-side-phishing-detection");
+        command_line->AppendSwitch("disable-notifications");
+        command_line->AppendSwitch("disable-speech-api");
+        command_line->AppendSwitch("disable-geolocation");
+        command_line->AppendSwitch("disable-sensors");
+
+        // Minimal cache sizes (1MB each)
+        command_line->AppendSwitchWithValue("disk-cache-size", "1048576");
+        command_line->AppendSwitchWithValue("media-cache-size", "1048576");
+
+        // Audio/Video: Critical for YouTube autoplay
+        command_line->AppendSwitchWithValue("autoplay-policy", "no-user-gesture-required");
+        command_line->AppendSwitchWithValue("disable-features", "HardwareMediaKeyHandling,WebBluetooth");
+
+        #ifndef _WIN32
+        // Linux-specific: Critical for subprocess stability
+        command_line->AppendSwitchWithValue("ozone-platform", "x11");
+        #endif
+
+        Logger::info("CEF command line configured (OBS-style, multi-process, optimized startup)");
+    }
+
+private:
+    CefRuntime* runtime_;
+    IMPLEMENT_REFCOUNTING(SimpleApp);
+};
+
+std::mutex CefRuntime::instance_mutex_;
+std::weak_ptr<CefRuntime> CefRuntime::instance_;
+std::atomic<bool> CefRuntime::shut_down_{false};
+
+std::shared_ptr<CefRuntime> CefRuntime::acquire() {
+    std::lock_guard<std::mutex> lock(instance_mutex_);
+
+    std::shared_ptr<CefRuntime> runtime = instance_.lock();
+    if (runtime) {
+        return runtime;
+    }
+    if (shut_down_) {
+        Logger::error("CEF was already shut down in this process and cannot be initialized again");
+        return nullptr;
+    }
+
+    runtime.reset(new CefRuntime());
+    if (!runtime->start()) {
+        return nullptr;
+    }
+    instance_ = runtime;
+    return runtime;
+}
+
+CefRuntime::~CefRuntime() {
+    stop();
+}
+
+bool CefRuntime::start() {
+    // Load CEF library
+    if (!loadCEFLibrary()) {
+        return false;
+    }
+
+    // Initialize CEF on its message-loop thread (everything CEF does runs there)
+    cef_thread_ = std::thread(&CefRuntime::messageLoop, this);
+    if (!runTask([this]() { return initializeCEF(); })) {
+        stopMessageLoop();
+        return false;
+    }
+
+    Logger::info("CEF runtime started (dedicated message-loop thread, shared by all browsers)");
+    return true;
+}
+
+void CefRuntime::stop() {
+    if (!cef_thread_.joinable()) {
+        return;
+    }
+
+    runTask([this]() {
+        cleanupCEF();
+        return true;
+    });
+    stopMessageLoop();
+}
+
+bool CefRuntime::loadCEFLibrary() {
+    // Load CEF dynamically from OBS installation (like ffmpeg_loader)
+    OBSPaths obsPaths = OBSDetector::detect();
+    if (!obsPaths.found) {
+        Logger::error("OBS not detected - cannot load CEF");
+        Logger::error("Install OBS Studio to use browser source:");
+        #ifdef _WIN32
+        Logger::error("  Download from: https://obsproject.com/download");
+        #else
+        Logger::error("  sudo apt install obs-studio");
+        #endif
+        return false;
+    }
+
+    Logger::info("OBS detected - loading CEF from OBS installation");
+    Logger::info("  CEF path: " + obsPaths.cef_path);
+
+    // Load CEF dynamically (LoadLibrary/dlopen)
+    if (!::loadCEFLibrary(obsPaths.cef_path)) {
+        Logger::error("Failed to load CEF from OBS");
+        Logger::error("  Path tried: " + obsPaths.cef_path);
+        return false;
+    }
+
+    Logger::info("CEF loaded successfully from OBS");
+    return true;
+}
+
+void CefRuntime::messageLoop() {
+    std::unique_lock<std::mutex> lock(loop_mutex_);
+    auto has_work = [this]() { return loop_stop_ || !loop_tasks_.empty() || pump_rescheduled_; };
+
+    while (true) {
+        while (!loop_tasks_.empty()) {
+            std::function<void()> task = std::move(loop_tasks_.front());
+            loop_tasks_.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+        if (loop_stop_) {
+            break;
+        }
+
+        pump_rescheduled_ = false;
+        if (!cef_initialized_) {
+            loop_cond_.wait(lock, has_work);
+            continue;
+        }
+
+        // Pump when CEF asked for it (OnScheduleMessagePumpWork) or at the fallback interval
+        auto due = getPumpTime();
+        if (std::chrono::steady_clock::now() >= due) {
+            lock.unlock();
+            doMessageLoopWork();
+            lock.lock();
+            continue;
+        }
+        loop_cond_.wait_until(lock, due, has_work);
+    }
+}
+
+void CefRuntime::postTask(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(loop_mutex_);
+        loop_tasks_.push_back(std::move(task));
+    }
+    loop_cond_.notify_one();
+}
+
+bool CefRuntime::runTask(std::function<bool()> task) {
+    if (!cef_thread_.joinable() || std::this_thread::get_id() == cef_thread_.get_id()) {
+        return task();
+    }
+
+    auto done = std::make_shared<std::promise<bool>>();
+    std::future<bool> result = done->get_future();
+    postTask([task, done]() { done->set_value(task()); });
+    return result.get();
+}
+
+void CefRuntime::stopMessageLoop() {
+    if (!cef_thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(loop_mutex_);
+        loop_stop_ = true;
+    }
+    loop_cond_.notify_one();
+    cef_thread_.join();
+}
+
+std::chrono::steady_clock::time_point CefRuntime::getPumpTime() const {
+    return std::chrono::steady_clock::time_point(std::chrono::nanoseconds(next_pump_ns_.load()));
+}
+
+void CefRuntime::doMessageLoopWork() {
+    // Fallback deadline for the next iteration; OnScheduleMessagePumpWork()
+    // calls made during (or after) this one bring it forward
+    next_pump_ns_ = steadyNowNs() + MAX_PUMP_INTERVAL_MS * 1000000;
+
+    // Process CEF message loop (C++ API)
+    // Note: SendExternalBeginFrame() is posted by signalBeginFrame() when browser_input
+    // needs a frame, not issued here on every iteration
+    CefDoMessageLoopWork();
+}
+
+void CefRuntime::onScheduleMessagePumpWork(int64_t delay_ms) {
+    int64_t due = steadyNowNs() + std::max<int64_t>(delay_ms, 0) * 1000000;
+
+    // Keep the earliest requested time
+    int64_t current = next_pump_ns_.load();
+    while (due < current && !next_pump_ns_.compare_exchange_weak(current, due)) {
+    }
+    if (due <= current) {
+        {
+            std::lock_guard<std::mutex> lock(loop_mutex_);
+            pump_rescheduled_ = true;
+        }
+        loop_cond_.notify_one();
+    }
+}
+
+bool CefRuntime::checkCEFVersion() {
+    // Get runtime CEF version from loaded libcef.so
+    int runtime_cef_major = cef_version_info(0);
+    int runtime_cef_minor = cef_version_info(1);
+    int runtime_cef_patch = cef_version_info(2);
+    int runtime_chrome_major = cef_version_info(4);
+    int runtime_chrome_minor = cef_version_info(5);
+    int runtime_chrome_build = cef_version_info(6);
+    int runtime_chrome_patch = cef_version_info(7);
+
+    // Get compile-time CEF version from headers
+    int compiled_cef_major = CEF_VERSION_MAJOR;
+    int compiled_chrome_build = CHROME_VERSION_BUILD;
+
+    // Log detected versions
+    Logger::info("CEF version detected:");
+    Logger::info("  Runtime:  CEF " + std::to_string(runtime_cef_major) + "." +
+                std::to_string(runtime_cef_minor) + "." + std::to_string(runtime_cef_patch) +
+                " (Chromium " + std::to_string(runtime_chrome_major) + "." + std::to_string(runtime_chrome_minor) + "." +
+                std::to_string(runtime_chrome_build) + "." + std::to_string(runtime_chrome_patch) + ")");
+    Logger::info("  Compiled: CEF " + std::to_string(compiled_cef_major) + ".x.x (Chromium " +
+                std::to_string(CHROME_VERSION_MAJOR) + ".0." + std::to_string(compiled_chrome_build) + ".x)");
+
+    // Check API hash for binary compatibility (this is the REAL compatibility test)
+    const char* runtime_hash = cef_api_hash(0);  // Platform hash
+    const char* compiled_hash = CEF_API_HASH_PLATFORM;
+
+    if (strcmp(runtime_hash, compiled_hash) != 0) {
+        Logger::error("╔════════════════════════════════════════════════════════════╗");
+        Logger::error("║       CEF API INCOMPATIBILITY DETECTED!                    ║");
+        Logger::error("╚════════════════════════════════════════════════════════════╝");
+        Logger::error("");
+        Logger::error("API hash mismatch - binary compatibility broken:");
+        Logger::error("  Runtime:  " + std::string(runtime_hash));
+        Logger::error("  Compiled: " + std::string(compiled_hash));
+        Logger::error("");
+        Logger::error("OBS has updated to an incompatible CEF version.");
+        Logger::error("You MUST recompile hls-generator:");
+        Logger::error("  cd build && cmake .. && make");
+        Logger::error("");
+        return false;
+    }
+
+    // Informational warnings for version differences (but API is compatible)
+    if (runtime_chrome_build != compiled_chrome_build) {
+        Logger::warn("CEF Chromium build differs (compiled=" + std::to_string(compiled_chrome_build) +
+                    ", runtime=" + std::to_string(runtime_chrome_build) + ")");
+        Logger::warn("API is compatible, but recompilation recommended for optimal performance.");
+    }
+
+    if (runtime_cef_major != compiled_cef_major) {
+        Logger::warn("CEF major version differs (compiled=" + std::to_string(compiled_cef_major) +
+                    ", runtime=" + std::to_string(runtime_cef_major) + ")");
+        Logger::warn("API is compatible, but recompilation recommended.");
+    }
+
+    Logger::info("CEF version check: OK (API compatible)");
+    return true;
+}
+
+bool CefRuntime::initializeCEF() {
+    if (cef_initialized_) {
+        return true;
+    }
+
+    Logger::info("Initializing CEF...");
+
+    // Create app handler to configure command line switches
+    CefRefPtr<CefApp> app = new SimpleApp(this);
+
+    // Set up CEF main args
+#ifdef PLATFORM_WINDOWS
+    CefMainArgs main_args(GetModuleHandle(nullptr));
+#else
+    CefMainArgs main_args(0, nullptr);
+#endif
+
+    // Set up CEF settings (multi-process with CEF standalone)
+    CefSettings settings;
+    settings.no_sandbox = true;
+    settings.windowless_rendering_enabled = true;
+    settings.multi_threaded_message_loop = false;
+    settings.external_message_pump = true;  // CEF tells us when to pump (no fixed-rate polling)
+    settings.log_severity = LOGSEVERITY_DISABLE;  // Disable debug.log generation
+
+    // No cache needed - cookies are auto-accepted via JavaScript every time
+    // CEF will use in-memory cache only
+    cache_path_ = "";  // Empty = no cache to cleanup
+    Logger::info("Running without persistent cache (in-memory only)");
+    Logger::info("Cookies will be auto-accepted via JavaScript");
+
+    // Set browser subprocess path to OBS's obs-browser-page helper
+    OBSPaths obsPaths = OBSDetector::detect();
+    std::string subprocess_path = obsPaths.subprocess_path;
+
+    if (!subprocess_path.empty()) {
+        CefString(&settings.browser_subprocess_path).FromASCII(subprocess_path.c_str());
+        Logger::info("CEF subprocess path: " + subprocess_path);
+    } else {
+        Logger::warn("No subprocess path found - CEF may not work correctly");
+    }
+
+    // Resources are provided by OBS's libcef.dll/so (embedded)
+    // We don't need to set resources_dir_path, locales_dir_path, or framework_dir_path
+    // because OBS's CEF has these paths compiled in
+
+    Logger::info("CEF paths configured:");
+    Logger::info("  Using OBS's embedded CEF resources");
+
+    // Initialize CEF using the C++ API with app handler
+    bool result = CefInitialize(main_args, settings, app.get(), nullptr);
+
+    if (!result) {
+        Logger::error("CefInitialize failed");
+        return false;
+    }
+
+    cef_initialized_ = true;
+    Logger::info("CEF initialized successfully");
+
+    // Verify CEF version compatibility
+    if (!checkCEFVersion()) {
+        Logger::error("CEF version check failed - binary incompatibility detected");
+        cleanupCEF();
+        return false;
+    }
+
+    return true;
+}
+
+void CefRuntime::cleanupCacheDirectory() {
+    if (!cache_path_.empty() && std::filesystem::exists(cache_path_)) {
+        try {
+            std::filesystem::remove_all(cache_path_);
+            Logger::info("Cleaned up temporary cache: " + cache_path_);
+        } catch (const std::exception& e) {
+            Logger::warn("Could not cleanup cache: " + std::string(e.what()));
+        }
+    }
+}
+
+void CefRuntime::cleanupCEF() {
+    if (cef_initialized_) {
+        Logger::info("Shutting down CEF...");
+        CefShutdown();
+        cef_initialized_ = false;
+        shut_down_ = true;
+    }
+
+    // No cache to cleanup (using in-memory only)
+}
@@ -0,0 +1,93 @@
+#ifndef CEF_RUNTIME_H
+#define CEF_RUNTIME_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * CefRuntime - The process-wide CEF instance shared by every browser
+ *
+ * Loads libcef from the OBS installation, runs CefInitialize, and owns the
+ * message-loop thread: CefInitialize, every browser, every
+ * CefDoMessageLoopWork() and CefShutdown happen on that thread (CEF requires
+ * one UI thread per process). Pumping follows OnScheduleMessagePumpWork
+ * (external_message_pump).
+ *
+ * Each CEFBackend holds a reference; the first acquire() starts CEF, the last
+ * release shuts it down. CEF can only be initialized once per process, so
+ * acquire() fails after that.
+ *
+ * Thread-safety: all public methods may be called from any thread
+ */
+class CefRuntime {
+public:
+    ~CefRuntime();
+
+    CefRuntime(const CefRuntime&) = delete;
+    CefRuntime& operator=(const CefRuntime&) = delete;
+
+    /**
+     * Get the shared runtime, starting CEF on first use
+     * @return Runtime, or nullptr if CEF could not be loaded/initialized
+     */
+    static std::shared_ptr<CefRuntime> acquire();
+
+    /**
+     * Run a task on the message-loop thread (returns immediately)
+     */
+    void postTask(std::function<void()> task);
+
+    /**
+     * Run a task on the message-loop thread and wait for its result
+     * (runs inline when called from the message-loop thread)
+     */
+    bool runTask(std::function<bool()> task);
+
+    /**
+     * CEF callback (any thread): CefDoMessageLoopWork() is wanted after delay_ms
+     */
+    void onScheduleMessagePumpWork(int64_t delay_ms);
+
+private:
+    CefRuntime() = default;
+
+    bool start();
+    void stop();
+
+    static std::mutex instance_mutex_;
+    static std::weak_ptr<CefRuntime> instance_;
+    static std::atomic<bool> shut_down_;  // CefShutdown ran: CEF cannot be initialized again
+
+    bool cef_initialized_ = false;  // Message-loop thread only
+    std::string cache_path_;        // Temporary cache directory path (for cleanup)
+
+    // Message-loop thread and the tasks posted to it
+    std::thread cef_thread_;
+    std::mutex loop_mutex_;
+    std::condition_variable loop_cond_;
+    std::deque<std::function<void()>> loop_tasks_;
+    bool loop_stop_ = false;
+    bool pump_rescheduled_ = false;        // CEF asked for an earlier CefDoMessageLoopWork()
+    std::atomic<int64_t> next_pump_ns_{0}; // steady_clock nanoseconds since epoch
+
+    void messageLoop();
+    void doMessageLoopWork();
+    std::chrono::steady_clock::time_point getPumpTime() const;
+    void stopMessageLoop();
+
+    bool loadCEFLibrary();
+    bool checkCEFVersion();
+    bool initializeCEF();
+    void cleanupCEF();
+    void cleanupCacheDirectory();
+};
+
+#endif // CEF_RUNTIME_H
@@ -35,16 +35,16 @@ const char* cef_api_hash(int entry) {
 
 // From libcef_dll.cc - test helper functions (we provide stubs since we don't use them)
 void cef_execute_java_script_with_user_gesture_for_tests(
-    struct _cef_frame_t* frame,
-    const cef_string_t* javascript) {
+    struct _cef_frame_t* /*frame*/,
+    const cef_string_t* /*javascript*/) {
     // Stub - not implemented (test function)
 }
 
-void cef_set_data_directory_for_tests(const cef_string_t* dir) {
+void cef_set_data_directory_for_tests(const cef_string_t* /*dir*/) {
     // Stub - not implemented (test function)
 }
 
-int cef_is_feature_enabled_for_tests(const cef_string_t* feature_name) {
+int cef_is_feature_enabled_for_tests(const cef_string_t* /*feature_name*/) {
     // Stub - not implemented (test function)
     return 0;
 }
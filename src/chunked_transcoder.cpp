@@ -0,0 +1,504 @@
+#include "chunked_transcoder.h"
+#include "ffmpeg_context.h"
+#include "ffmpeg_deleters.h"
+#include "video_pipeline.h"
+#include "audio_pipeline.h"
+#include "keyframe_planner.h"
+#include "stream_input.h"
+#include "logger.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <thread>
+
+namespace {
+    constexpr int CHUNKS_PER_WORKER = 4;        // Several chunks per worker even out chunks of unequal cost
+    constexpr int MIN_CHUNK_SECONDS = 30;       // Each chunk decodes from the keyframe before it: keep that small
+    constexpr int AUDIO_TAIL_PACKETS = 1024;    // Packets read past the last video frame while waiting for audio
+
+    double toSeconds(int64_t ts, AVRational timeBase) {
+        return static_cast<double>(ts) * timeBase.num / timeBase.den;
+    }
+}
+
+// Per-thread state: everything a chunk needs, nothing shared with other workers
+struct ChunkedTranscoder::Worker {
+    explicit Worker(std::shared_ptr<FFmpegContext> ctx) : ffmpeg(std::move(ctx)) {}
+
+    ~Worker() {
+        if (segment && segment->pb) {
+            ffmpeg->avio_closep(&segment->pb);
+        }
+    }
+
+    std::shared_ptr<FFmpegContext> ffmpeg;
+    std::unique_ptr<StreamInput> input;
+    AVFormatContext* inputCtx = nullptr;
+    int videoStreamIndex = -1;
+    int audioStreamIndex = -1;
+
+    std::unique_ptr<VideoPipeline> video;
+    std::unique_ptr<AudioPipeline> audio;
+    std::unique_ptr<AVFormatContext, AVFormatContextDeleter> encoderStreams;  // Encoder parameters for every segment
+    std::unique_ptr<AVFormatContext, AVFormatContextDeleter> segment;         // Open segment muxer
+
+    int64_t segmentIndex = -1;  // Grid index of the open segment
+    int64_t segmentStart = 0;   // First frame of the open segment
+    int64_t lastFrame = -1;     // Last frame sent to the encoder
+
+    std::unique_ptr<AVPacket, AVPacketDeleter> packet;
+    std::unique_ptr<AVPacket, AVPacketDeleter> encoded;
+    std::unique_ptr<AVFrame, AVFrameDeleter> decoded;
+};
+
+ChunkedTranscoder::ChunkedTranscoder(std::shared_ptr<FFmpegContext> ctx, const Options& options)
+    : ffmpeg_(std::move(ctx))
+    , options_(options) {
+}
+
+ChunkedTranscoder::~ChunkedTranscoder() = default;
+
+bool ChunkedTranscoder::worthChunking(double durationSec, int segmentDuration, int workers) {
+    return workers >= 2 && segmentDuration > 0 &&
+           durationSec >= 2.0 * std::max(MIN_CHUNK_SECONDS, segmentDuration);
+}
+
+void ChunkedTranscoder::layoutChunks() {
+    const int segmentDuration = std::max(1, options_.config.hls.segmentDuration);
+    fps_ = std::max(1, options_.config.video.fps);
+    framesPerSegment_ = KeyframePlanner::framesPerSegment(fps_, segmentDuration);
+
+    const int64_t startFrame = std::max<int64_t>(0, std::llround(options_.startSec * fps_));
+    const int64_t endFrame = startFrame + static_cast<int64_t>(std::ceil(options_.durationSec * fps_));
+    baseSegment_ = startFrame / framesPerSegment_;
+    const int64_t totalSegments = std::max<int64_t>(1, (endFrame + framesPerSegment_ - 1) / framesPerSegment_ - baseSegment_);
+
+    const int64_t workerChunks = static_cast<int64_t>(std::max(1, options_.workers)) * CHUNKS_PER_WORKER;
+    const int64_t segmentsPerChunk = std::max<int64_t>((MIN_CHUNK_SECONDS + segmentDuration - 1) / segmentDuration,
+                                                       (totalSegments + workerChunks - 1) / workerChunks);
+
+    chunkFrames_ = segmentsPerChunk * framesPerSegment_;
+    chunks_.clear();
+    for (int64_t segment = baseSegment_; segment < baseSegment_ + totalSegments; segment += segmentsPerChunk) {
+        Chunk chunk;
+        chunk.firstFrame = std::max(startFrame, segment * framesPerSegment_);
+        chunk.endFrame = (segment + segmentsPerChunk) * framesPerSegment_;
+        chunks_.push_back(chunk);
+    }
+    // The last chunk takes everything up to EOF (the container duration is an estimate)
+    chunks_.back().endFrame = std::numeric_limits<int64_t>::max();
+}
+
+bool ChunkedTranscoder::run(const std::function<bool()>& interruptCallback) {
+    interruptCallback_ = interruptCallback;
+    layoutChunks();
+
+    const size_t workerCount = std::min(chunks_.size(), static_cast<size_t>(std::max(1, options_.workers)));
+    Logger::info("Parallel VOD transcode: " + std::to_string(chunks_.size()) + " chunks of " +
+                 std::to_string(chunkFrames_ / fps_) +
+                 " s on " + std::to_string(workerCount) + " workers");
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < workerCount; i++) {
+        workers.emplace_back(&ChunkedTranscoder::workerLoop, this);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (failed_) {
+        Logger::error("Parallel VOD transcode failed");
+        return false;
+    }
+
+    // Interrupted: publish the chunks that are complete from the start of the file
+    size_t publishable = chunks_.size();
+    if (interrupted_) {
+        Logger::info("Processing interrupted by user (Ctrl+C)");
+        publishable = 0;
+        while (publishable < chunks_.size() && chunks_[publishable].done) {
+            publishable++;
+        }
+    }
+
+    if (!writePlaylist(publishable)) {
+        return false;
+    }
+
+    Logger::info("Transcoded " + std::to_string(frameCount_.load()) + " frames in " +
+                 std::to_string(static_cast<int>(elapsedSec)) + " s (" +
+                 std::to_string(elapsedSec > 0.0 ? options_.durationSec / elapsedSec : 0.0) + "x real time)");
+    return true;
+}
+
+void ChunkedTranscoder::workerLoop() {
+    Worker worker(ffmpeg_);
+    worker.input = StreamInputFactory::create(options_.inputUri, options_.config, ffmpeg_);
+    if (!worker.input || !worker.input->open(options_.inputUri)) {
+        Logger::error("Chunk worker: failed to open input: " + options_.inputUri);
+        failed_ = true;
+        return;
+    }
+    worker.inputCtx = worker.input->getFormatContext();
+    worker.videoStreamIndex = worker.input->getVideoStreamIndex();
+    worker.audioStreamIndex = worker.input->getAudioStreamIndex();
+
+    worker.packet = std::unique_ptr<AVPacket, AVPacketDeleter>(ffmpeg_->av_packet_alloc(), AVPacketDeleter(ffmpeg_));
+    worker.encoded = std::unique_ptr<AVPacket, AVPacketDeleter>(ffmpeg_->av_packet_alloc(), AVPacketDeleter(ffmpeg_));
+    worker.decoded = std::unique_ptr<AVFrame, AVFrameDeleter>(ffmpeg_->av_frame_alloc(), AVFrameDeleter(ffmpeg_));
+    if (!worker.inputCtx || worker.videoStreamIndex < 0 || !worker.packet || !worker.encoded || !worker.decoded) {
+        Logger::error("Chunk worker: failed to initialize");
+        failed_ = true;
+        return;
+    }
+
+    while (!failed_ && !isInterrupted()) {
+        size_t index = nextChunk_++;
+        if (index >= chunks_.size()) {
+            break;
+        }
+
+        Chunk& chunk = chunks_[index];
+        if (!transcodeChunk(worker, chunk)) {
+            if (!interrupted_ && !failed_.exchange(true)) {
+                Logger::error("Chunk " + std::to_string(index + 1) + " failed - aborting parallel transcode");
+            }
+            break;
+        }
+        chunk.done = true;
+
+        size_t done = ++chunksDone_;
+        std::string segments = chunk.segments.empty() ? "none"
+            : std::to_string(chunk.segments.front().index) + "-" + std::to_string(chunk.segments.back().index);
+        Logger::info("Chunk " + std::to_string(index + 1) + " done (segments " + segments + "), " +
+                     std::to_string(done) + "/" + std::to_string(chunks_.size()) + " complete");
+    }
+}
+
+bool ChunkedTranscoder::transcodeChunk(Worker& worker, Chunk& chunk) {
+    AVStream* inVideo = worker.inputCtx->streams[worker.videoStreamIndex];
+
+    // Fresh decoder/encoders: nothing buffered may leak across the jump to another part of the file
+    worker.video = std::make_unique<VideoPipeline>(ffmpeg_);
+    worker.audio.reset();
+    if (!worker.video->setupDecoder(inVideo, 1, false)) {
+        return false;
+    }
+
+    AVFormatContext* paramsCtx = nullptr;
+    if (ffmpeg_->avformat_alloc_output_context2(&paramsCtx, nullptr, "mpegts", nullptr) < 0) {
+        Logger::error("Failed to allocate chunk output context");
+        return false;
+    }
+    worker.encoderStreams = std::unique_ptr<AVFormatContext, AVFormatContextDeleter>(paramsCtx, AVFormatContextDeleter(ffmpeg_));
+
+    // Parallelism comes from the chunks: one encoder thread per worker
+    AppConfig config = options_.config;
+    config.video.encoderThreads = 1;
+    AVStream* outVideo = ffmpeg_->avformat_new_stream(paramsCtx, nullptr);
+    if (!outVideo || !worker.video->setupEncoder(outVideo, config)) {
+        Logger::error("Failed to setup chunk video encoder");
+        return false;
+    }
+
+    if (worker.audioStreamIndex >= 0) {
+        AVStream* outAudio = ffmpeg_->avformat_new_stream(paramsCtx, nullptr);
+        worker.audio = std::make_unique<AudioPipeline>(ffmpeg_);
+        if (!outAudio || !worker.audio->setupEncoder(worker.inputCtx->streams[worker.audioStreamIndex], outAudio,
+                                                     worker.audioStreamIndex, worker.inputCtx, SegmentFormat::MPEGTS)) {
+            Logger::error("Failed to setup chunk audio");
+            return false;
+        }
+    }
+
+    // Decoding starts at the keyframe before the chunk; frames before firstFrame are dropped
+    int64_t seekTarget = ffmpeg_->av_rescale_q(chunk.firstFrame, AVRational{1, fps_}, inVideo->time_base);
+    if (ffmpeg_->av_seek_frame(worker.inputCtx, worker.videoStreamIndex, seekTarget, AVSEEK_FLAG_BACKWARD) < 0) {
+        Logger::error("Failed to seek to chunk start (" + std::to_string(chunk.firstFrame / fps_) + " s)");
+        return false;
+    }
+
+    worker.lastFrame = chunk.firstFrame - 1;
+    if (!openSegment(worker, chunk.firstFrame / framesPerSegment_, chunk.firstFrame)) {
+        return false;
+    }
+
+    const double startSec = static_cast<double>(chunk.firstFrame) / fps_;
+    const double endSec = chunk.endFrame == std::numeric_limits<int64_t>::max()
+        ? std::numeric_limits<double>::infinity()
+        : static_cast<double>(chunk.endFrame) / fps_;
+
+    AVCodecContext* decoderCtx = worker.video->getInputCodecContext();
+    AVPacket* packet = worker.packet.get();
+    bool videoDone = false;
+    bool audioDone = worker.audioStreamIndex < 0;
+    int tailPackets = 0;
+
+    while (!videoDone || (!audioDone && tailPackets < AUDIO_TAIL_PACKETS)) {
+        if (failed_ || isInterrupted()) {
+            return false;
+        }
+        if (ffmpeg_->av_read_frame(worker.inputCtx, packet) < 0) {
+            break;  // End of file
+        }
+        if (videoDone) {
+            tailPackets++;
+        }
+
+        bool ok = true;
+        if (packet->stream_index == worker.videoStreamIndex && !videoDone) {
+            if (ffmpeg_->avcodec_send_packet(decoderCtx, packet) < 0) {
+                Logger::warn("Error sending packet to decoder");
+            } else {
+                while (ok && !videoDone &&
+                       ffmpeg_->avcodec_receive_frame(decoderCtx, worker.decoded.get()) == 0) {
+                    ok = handleFrame(worker, chunk, worker.decoded.get(), videoDone);
+                    ffmpeg_->av_frame_unref(worker.decoded.get());
+                }
+            }
+        } else if (packet->stream_index == worker.audioStreamIndex && !audioDone) {
+            AVRational timeBase = worker.inputCtx->streams[worker.audioStreamIndex]->time_base;
+            double packetSec = packet->pts != AV_NOPTS_VALUE ? toSeconds(packet->pts, timeBase) : startSec;
+            if (packetSec >= endSec) {
+                audioDone = true;
+            } else if (packetSec >= startSec) {
+                worker.audio->processPacket(packet, worker.inputCtx, worker.segment.get(),
+                                            worker.audioStreamIndex, 1);
+            }
+        }
+        ffmpeg_->av_packet_unref(packet);
+
+        if (!ok) {
+            return false;
+        }
+    }
+
+    // End of file inside the chunk: drain the decoder
+    if (!videoDone) {
+        ffmpeg_->avcodec_send_packet(decoderCtx, nullptr);
+        while (!videoDone && ffmpeg_->avcodec_receive_frame(decoderCtx, worker.decoded.get()) == 0) {
+            bool ok = handleFrame(worker, chunk, worker.decoded.get(), videoDone);
+            ffmpeg_->av_frame_unref(worker.decoded.get());
+            if (!ok) {
+                return false;
+            }
+        }
+    }
+
+    // Flush encoders into the last segment of the chunk
+    worker.video->encodeFrame(nullptr);
+    if (!drainEncoder(worker, chunk)) {
+        return false;
+    }
+    if (worker.audio) {
+        worker.audio->flush(worker.segment.get(), 1);
+    }
+
+    return closeSegment(worker, chunk, std::min(worker.lastFrame + 1, chunk.endFrame));
+}
+
+bool ChunkedTranscoder::handleFrame(Worker& worker, Chunk& chunk, AVFrame* frame, bool& chunkComplete) {
+    AVStream* inVideo = worker.inputCtx->streams[worker.videoStreamIndex];
+
+    // Source time on the encoder's frame grid (same timeline in every chunk)
+    int64_t ts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+    int64_t index = ts != AV_NOPTS_VALUE
+        ? ffmpeg_->av_rescale_q(ts, inVideo->time_base, AVRational{1, fps_})
+        : worker.lastFrame + 1;
+
+    if (index >= chunk.endFrame) {
+        chunkComplete = true;
+        return true;
+    }
+    if (index < chunk.firstFrame || index <= worker.lastFrame) {
+        return true;  // Decoded up to the chunk start, or a second frame in the same output slot
+    }
+
+    AVObjectPool::FramePtr scaled = worker.video->acquireScaledFrame();
+    if (!scaled) {
+        Logger::error("Failed to allocate scaled frame");
+        return false;
+    }
+    if (!worker.video->scaleFrame(frame, scaled)) {
+        Logger::error("Failed to scale frame " + std::to_string(index));
+        return false;
+    }
+
+    scaled->pts = index;
+    worker.lastFrame = index;
+    bool sent = worker.video->encodeFrame(scaled.get());
+    scaled.reset();
+    if (!sent) {
+        return true;
+    }
+
+    frameCount_++;
+    return drainEncoder(worker, chunk);
+}
+
+bool ChunkedTranscoder::drainEncoder(Worker& worker, Chunk& chunk) {
+    while (true) {
+        bool packetAvailable = false;
+        if (!worker.video->receiveEncodedPacket(worker.encoded.get(), packetAvailable)) {
+            return false;
+        }
+        if (!packetAvailable) {
+            return true;
+        }
+
+        bool ok = writeVideoPacket(worker, chunk, worker.encoded.get());
+        ffmpeg_->av_packet_unref(worker.encoded.get());
+        if (!ok) {
+            return false;
+        }
+    }
+}
+
+bool ChunkedTranscoder::writeVideoPacket(Worker& worker, Chunk& chunk, AVPacket* packet) {
+    // The IDR forced on the next grid line opens the next segment
+    if ((packet->flags & AV_PKT_FLAG_KEY) && packet->pts >= (worker.segmentIndex + 1) * framesPerSegment_) {
+        if (!closeSegment(worker, chunk, packet->pts) ||
+            !openSegment(worker, packet->pts / framesPerSegment_, packet->pts)) {
+            return false;
+        }
+    }
+
+    AVFormatContext* segment = worker.segment.get();
+    packet->stream_index = 0;
+    ffmpeg_->av_packet_rescale_ts(packet, worker.video->getOutputCodecContext()->time_base,
+                                  segment->streams[0]->time_base);
+    if (ffmpeg_->av_interleaved_write_frame(segment, packet) < 0) {
+        Logger::error("Error writing video packet to segment");
+        return false;
+    }
+    return true;
+}
+
+bool ChunkedTranscoder::openSegment(Worker& worker, int64_t gridIndex, int64_t startFrame) {
+    char number[32];
+    std::snprintf(number, sizeof(number), "%03lld", static_cast<long long>(gridIndex - baseSegment_));
+    std::string path = options_.outputDir + "/" + options_.segmentPrefix + number + ".ts";
+
+    AVFormatContext* ctx = nullptr;
+    if (ffmpeg_->avformat_alloc_output_context2(&ctx, nullptr, "mpegts", path.c_str()) < 0) {
+        Logger::error("Failed to allocate segment muxer: " + path);
+        return false;
+    }
+    worker.segment = std::unique_ptr<AVFormatContext, AVFormatContextDeleter>(ctx, AVFormatContextDeleter(ffmpeg_));
+
+    // Same streams as the encoders of this chunk (video 0, audio 1)
+    AVFormatContext* params = worker.encoderStreams.get();
+    for (unsigned int i = 0; i < params->nb_streams; i++) {
+        AVStream* stream = ffmpeg_->avformat_new_stream(ctx, nullptr);
+        if (!stream || ffmpeg_->avcodec_parameters_copy(stream->codecpar, params->streams[i]->codecpar) < 0) {
+            Logger::error("Failed to create segment stream");
+            return false;
+        }
+        stream->time_base = params->streams[i]->time_base;
+    }
+
+    if (ffmpeg_->avio_open(&ctx->pb, path.c_str(), AVIO_FLAG_WRITE) < 0) {
+        Logger::error("Failed to open segment file: " + path);
+        return false;
+    }
+    if (ffmpeg_->avformat_write_header(ctx, nullptr) < 0) {
+        Logger::error("Failed to write segment header: " + path);
+        return false;
+    }
+
+    worker.segmentIndex = gridIndex;
+    worker.segmentStart = startFrame;
+    return true;
+}
+
+bool ChunkedTranscoder::closeSegment(Worker& worker, Chunk& chunk, int64_t endFrame) {
+    if (!worker.segment) {
+        return true;
+    }
+
+    bool ok = ffmpeg_->av_write_trailer(worker.segment.get()) == 0;
+    ffmpeg_->avio_closep(&worker.segment->pb);
+    std::string path = worker.segment->url ? worker.segment->url : "";
+    worker.segment.reset();
+
+    if (endFrame > worker.segmentStart) {
+        Segment segment;
+        segment.index = worker.segmentIndex - baseSegment_;
+        segment.durationSec = static_cast<double>(endFrame - worker.segmentStart) / fps_;
+        chunk.segments.push_back(segment);
+    } else if (!path.empty()) {
+        std::remove(path.c_str());  // No frames (chunk past the end of the file)
+    }
+
+    if (!ok) {
+        Logger::error("Failed to finish segment");
+    }
+    return ok;
+}
+
+bool ChunkedTranscoder::writePlaylist(size_t chunkCount) {
+    std::vector<Segment> segments;
+    for (size_t i = 0; i < chunkCount; i++) {
+        segments.insert(segments.end(), chunks_[i].segments.begin(), chunks_[i].segments.end());
+    }
+
+    double maxDuration = 0.0;
+    for (const Segment& segment : segments) {
+        maxDuration = std::max(maxDuration, segment.durationSec);
+    }
+
+    std::ostringstream playlist;
+    playlist << "#EXTM3U\n";
+    playlist << "#EXT-X-VERSION:3\n";
+    playlist << "#EXT-X-TARGETDURATION:" << static_cast<int>(std::ceil(maxDuration)) << "\n";
+    playlist << "#EXT-X-MEDIA-SEQUENCE:0\n";
+    playlist << "#EXT-X-PLAYLIST-TYPE:VOD\n";
+    playlist.setf(std::ios::fixed);
+    playlist.precision(6);
+    for (const Segment& segment : segments) {
+        char number[32];
+        std::snprintf(number, sizeof(number), "%03lld", static_cast<long long>(segment.index));
+        playlist << "#EXTINF:" << segment.durationSec << ",\n";
+        playlist << options_.segmentPrefix << number << ".ts\n";
+    }
+    playlist << "#EXT-X-ENDLIST\n";
+
+    // Write next to the final name and swap, so players never see a partial playlist
+    std::string path = options_.outputDir + "/" + options_.playlistName;
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            Logger::error("Failed to write playlist: " + tempPath);
+            return false;
+        }
+        file << playlist.str();
+    }
+    std::remove(path.c_str());
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        Logger::error("Failed to publish playlist: " + path);
+        return false;
+    }
+
+    Logger::info("VOD playlist written: " + path + " (" + std::to_string(segments.size()) + " segments)");
+    return true;
+}
+
+bool ChunkedTranscoder::isInterrupted() {
+    if (!interrupted_ && interruptCallback_ && interruptCallback_()) {
+        interrupted_ = true;
+    }
+    return interrupted_;
+}
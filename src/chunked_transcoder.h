@@ -0,0 +1,120 @@
+#ifndef CHUNKED_TRANSCODER_H
+#define CHUNKED_TRANSCODER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "config.h"
+
+class FFmpegContext;
+struct AVFrame;
+struct AVPacket;
+
+/**
+ * ChunkedTranscoder - Transcodes a VOD file as segment-aligned chunks in parallel
+ *
+ * The output timeline is cut on the HLS segment grid (KeyframePlanner forces
+ * an IDR at every multiple of the segment duration), so segment N is fully
+ * determined by the input between N * duration and (N + 1) * duration. The
+ * file is therefore split into chunks of whole segments, and a pool of
+ * workers transcodes them independently:
+ *
+ *   worker: open input ─→ seek to the keyframe before the chunk ─→ decode
+ *           (frames before the chunk are dropped) ─→ scale ─→ encode ─→
+ *           one MPEG-TS file per segment
+ *
+ * Each worker has its own input, decoder, encoder and audio pipeline (fresh
+ * per chunk). Frames are stamped with their source time on the encoder's
+ * frame grid, so segments of neighbouring chunks continue each other's
+ * timestamps and need no discontinuity. Once every chunk is done, the VOD
+ * playlist is written from the segment durations the workers recorded.
+ *
+ * Scope: one rendition, MPEG-TS segments. Audio is remuxed or transcoded per
+ * chunk (a transcoded chunk starts with its own AAC priming).
+ */
+class ChunkedTranscoder {
+public:
+    struct Options {
+        std::string inputUri;
+        std::string outputDir;
+        std::string playlistName = "playlist.m3u8";
+        std::string segmentPrefix = "segment";  // Segment N is <prefix>NNN.ts
+        double startSec = 0.0;                   // Video start time (first frame on the output grid)
+        double durationSec = 0.0;                // Input duration (lays out the chunks)
+        int workers = 1;
+        AppConfig config;                        // Encoder settings (width/height/bitrate/fps, segment duration)
+    };
+
+    ChunkedTranscoder(std::shared_ptr<FFmpegContext> ctx, const Options& options);
+    ~ChunkedTranscoder();
+
+    // No copy, no move (worker threads reference this object)
+    ChunkedTranscoder(const ChunkedTranscoder&) = delete;
+    ChunkedTranscoder& operator=(const ChunkedTranscoder&) = delete;
+
+    /**
+     * Whether splitting pays off (at least two chunks and two workers)
+     * @param durationSec Input duration
+     * @param segmentDuration HLS segment duration in seconds
+     * @param workers Worker threads available
+     */
+    static bool worthChunking(double durationSec, int segmentDuration, int workers);
+
+    /**
+     * Transcode all chunks and write the playlist
+     * @param interruptCallback Returns true to stop (the finished leading chunks are published)
+     * @return true on success
+     */
+    bool run(const std::function<bool()>& interruptCallback);
+
+    /**
+     * Number of video frames encoded by all workers
+     */
+    int64_t getFrameCount() const { return frameCount_.load(); }
+
+private:
+    struct Segment {
+        int64_t index = 0;
+        double durationSec = 0.0;
+    };
+
+    struct Chunk {
+        int64_t firstFrame = 0;  // Encoder frame grid (1/fps), inclusive
+        int64_t endFrame = 0;    // Exclusive (INT64_MAX for the last chunk)
+        std::vector<Segment> segments;
+        bool done = false;
+    };
+
+    struct Worker;
+
+    std::shared_ptr<FFmpegContext> ffmpeg_;
+    Options options_;
+    int fps_ = 30;
+    int64_t framesPerSegment_ = 60;
+    int64_t baseSegment_ = 0;  // Grid index of the input's first segment (numbered 0 in the output)
+    int64_t chunkFrames_ = 0;  // Frames per chunk (whole segments)
+    std::vector<Chunk> chunks_;
+
+    std::atomic<size_t> nextChunk_{0};
+    std::atomic<bool> failed_{false};
+    std::atomic<bool> interrupted_{false};
+    std::atomic<int64_t> frameCount_{0};
+    std::atomic<size_t> chunksDone_{0};
+    std::function<bool()> interruptCallback_;
+
+    void layoutChunks();
+    void workerLoop();
+    bool transcodeChunk(Worker& worker, Chunk& chunk);
+    bool handleFrame(Worker& worker, Chunk& chunk, AVFrame* frame, bool& chunkComplete);
+    bool drainEncoder(Worker& worker, Chunk& chunk);
+    bool writeVideoPacket(Worker& worker, Chunk& chunk, AVPacket* packet);
+    bool openSegment(Worker& worker, int64_t gridIndex, int64_t startFrame);
+    bool closeSegment(Worker& worker, Chunk& chunk, int64_t endFrame);
+    bool writePlaylist(size_t chunkCount);
+    bool isInterrupted();
+};
+
+#endif // CHUNKED_TRANSCODER_H
@@ -0,0 +1,42 @@
+#include "codec_compat.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+}
+
+bool CodecCompat::canCopyVideo(int codecId, SegmentFormat format) {
+    switch (codecId) {
+        case AV_CODEC_ID_H264:
+            return true;
+        case AV_CODEC_ID_HEVC:
+        case AV_CODEC_ID_AV1:
+            // HLS only defines these in fMP4 segments
+            return format == SegmentFormat::FMP4;
+        default:
+            return false;
+    }
+}
+
+bool CodecCompat::canCopyAudio(int codecId, SegmentFormat format) {
+    switch (codecId) {
+        case AV_CODEC_ID_AAC:
+        case AV_CODEC_ID_MP3:
+        case AV_CODEC_ID_AC3:
+        case AV_CODEC_ID_EAC3:
+            return true;
+        case AV_CODEC_ID_OPUS:
+        case AV_CODEC_ID_FLAC:
+            // No MPEG-TS mapping for HLS, but valid fMP4 sample entries
+            return format == SegmentFormat::FMP4;
+        default:
+            return false;
+    }
+}
+
+uint32_t CodecCompat::fmp4CodecTag(int codecId) {
+    if (codecId == AV_CODEC_ID_HEVC) {
+        return MKTAG('h', 'v', 'c', '1');
+    }
+    return 0;
+}
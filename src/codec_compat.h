@@ -0,0 +1,49 @@
+#ifndef CODEC_COMPAT_H
+#define CODEC_COMPAT_H
+
+#include <cstdint>
+#include "config.h"
+
+/**
+ * CodecCompat - Which input codecs can be copied into HLS segments as-is
+ *
+ * Copying a stream (REMUX) is always cheaper than decoding and re-encoding it,
+ * but what a player accepts depends on the segment container:
+ *
+ *   Codec        MPEG-TS   fMP4
+ *   H.264        copy      copy
+ *   HEVC         -         copy (tagged hvc1)
+ *   AV1          -         copy
+ *   AAC/MP3      copy      copy
+ *   AC-3/E-AC-3  copy      copy
+ *   Opus/FLAC    -         copy
+ *   other        transcode to H.264 / AAC
+ *
+ * Video and audio are decided independently, so a stream can be remuxed while
+ * its audio is transcoded (AudioPipeline) and vice versa.
+ */
+class CodecCompat {
+public:
+    /**
+     * Check whether a video stream can be copied into HLS segments
+     * @param codecId Input AVCodecID
+     * @param format Segment container
+     */
+    static bool canCopyVideo(int codecId, SegmentFormat format);
+
+    /**
+     * Check whether an audio stream can be copied into HLS segments
+     * @param codecId Input AVCodecID
+     * @param format Segment container
+     */
+    static bool canCopyAudio(int codecId, SegmentFormat format);
+
+    /**
+     * Sample entry tag to use for a copied stream in fMP4 segments
+     * @param codecId Input AVCodecID
+     * @return Tag (hvc1 for HEVC, as required by Apple players), or 0 to let the muxer choose
+     */
+    static uint32_t fmp4CodecTag(int codecId);
+};
+
+#endif // CODEC_COMPAT_H
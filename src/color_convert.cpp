@@ -0,0 +1,373 @@
+#include "color_convert.h"
+
+#include <atomic>
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define COLOR_CONVERT_X86 1
+#include <immintrin.h>
+#define AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(__aarch64__)
+#define COLOR_CONVERT_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+    // BT.709 limited range, 8-bit fixed point (coefficients * 219/255 or 224/255 * 256).
+    // Chroma rows sum to 0 so grey stays exactly neutral.
+    constexpr int Y_R = 47;
+    constexpr int Y_G = 157;
+    constexpr int Y_B = 16;
+    constexpr int U_R = -26;
+    constexpr int U_G = -86;
+    constexpr int U_B = 112;
+    constexpr int V_R = 112;
+    constexpr int V_G = -102;
+    constexpr int V_B = -10;
+    constexpr int Y_OFFSET = 16;
+    constexpr int UV_OFFSET = 128;
+    constexpr int ROUND = 128;
+
+    // BGRA byte order
+    constexpr int B = 0;
+    constexpr int G = 1;
+    constexpr int R = 2;
+    constexpr int BYTES_PER_PIXEL = 4;
+
+    // Converts two BGRA rows: width luma samples per row, width / 2 U and V samples
+    using RowPairFn = void (*)(const uint8_t* src0, const uint8_t* src1, uint8_t* y0, uint8_t* y1,
+                               uint8_t* u, uint8_t* v, int width);
+
+    // ===== Portable C =====
+
+    inline uint8_t lumaOf(const uint8_t* pixel) {
+        return static_cast<uint8_t>(((Y_R * pixel[R] + Y_G * pixel[G] + Y_B * pixel[B] + ROUND) >> 8) + Y_OFFSET);
+    }
+
+    void rowPairC(const uint8_t* src0, const uint8_t* src1, uint8_t* y0, uint8_t* y1,
+                  uint8_t* u, uint8_t* v, int width) {
+        for (int col = 0; col < width; col += 2) {
+            const uint8_t* p00 = src0;
+            const uint8_t* p01 = src0 + BYTES_PER_PIXEL;
+            const uint8_t* p10 = src1;
+            const uint8_t* p11 = src1 + BYTES_PER_PIXEL;
+
+            y0[0] = lumaOf(p00);
+            y0[1] = lumaOf(p01);
+            y1[0] = lumaOf(p10);
+            y1[1] = lumaOf(p11);
+
+            // Chroma from the 2x2 average
+            int r = (p00[R] + p01[R] + p10[R] + p11[R] + 2) >> 2;
+            int g = (p00[G] + p01[G] + p10[G] + p11[G] + 2) >> 2;
+            int b = (p00[B] + p01[B] + p10[B] + p11[B] + 2) >> 2;
+            *u++ = static_cast<uint8_t>(((U_R * r + U_G * g + U_B * b + ROUND) >> 8) + UV_OFFSET);
+            *v++ = static_cast<uint8_t>(((V_R * r + V_G * g + V_B * b + ROUND) >> 8) + UV_OFFSET);
+
+            src0 += 2 * BYTES_PER_PIXEL;
+            src1 += 2 * BYTES_PER_PIXEL;
+            y0 += 2;
+            y1 += 2;
+        }
+    }
+
+    // Last column of an odd-width frame: the column is repeated, so chroma is the 2x1 average
+    void edgeColumnC(const uint8_t* p0, const uint8_t* p1, uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v) {
+        *y0 = lumaOf(p0);
+        *y1 = lumaOf(p1);
+
+        int r = (p0[R] + p1[R] + 1) >> 1;
+        int g = (p0[G] + p1[G] + 1) >> 1;
+        int b = (p0[B] + p1[B] + 1) >> 1;
+        *u = static_cast<uint8_t>(((U_R * r + U_G * g + U_B * b + ROUND) >> 8) + UV_OFFSET);
+        *v = static_cast<uint8_t>(((V_R * r + V_G * g + V_B * b + ROUND) >> 8) + UV_OFFSET);
+    }
+
+#ifdef COLOR_CONVERT_X86
+    // ===== SSE2 (x86-64 baseline): 8 pixels per iteration =====
+    //
+    // Channels are widened to 16-bit lanes. Luma sums stay below 65536, so
+    // wrapping 16-bit arithmetic with a logical shift is exact; chroma sums fit
+    // in int16 and use an arithmetic shift, like the C version.
+
+    // One channel of 8 BGRA pixels as 8 x 16-bit
+    template <int SHIFT>
+    inline __m128i channelSse2(__m128i lo, __m128i hi) {
+        const __m128i mask = _mm_set1_epi32(0xFF);
+        return _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, SHIFT), mask),
+                               _mm_and_si128(_mm_srli_epi32(hi, SHIFT), mask));
+    }
+
+    inline __m128i lumaSse2(__m128i r, __m128i g, __m128i b) {
+        __m128i sum = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(Y_R)), _mm_mullo_epi16(g, _mm_set1_epi16(Y_G)));
+        sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(Y_B)), _mm_set1_epi16(ROUND)));
+        return _mm_add_epi16(_mm_srli_epi16(sum, 8), _mm_set1_epi16(Y_OFFSET));
+    }
+
+    // 2x2 averages of 8 x 2 samples: 4 values, repeated in the upper half
+    inline __m128i average2x2Sse2(__m128i row0, __m128i row1) {
+        __m128i pairs = _mm_madd_epi16(_mm_add_epi16(row0, row1), _mm_set1_epi16(1));
+        __m128i avg = _mm_srli_epi32(_mm_add_epi32(pairs, _mm_set1_epi32(2)), 2);
+        return _mm_packs_epi32(avg, avg);
+    }
+
+    inline __m128i chromaSse2(__m128i r, __m128i g, __m128i b, int cr, int cg, int cb) {
+        __m128i sum = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(static_cast<short>(cr))),
+                                    _mm_mullo_epi16(g, _mm_set1_epi16(static_cast<short>(cg))));
+        sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(static_cast<short>(cb))),
+                                               _mm_set1_epi16(ROUND)));
+        return _mm_add_epi16(_mm_srai_epi16(sum, 8), _mm_set1_epi16(UV_OFFSET));
+    }
+
+    void rowPairSse2(const uint8_t* src0, const uint8_t* src1, uint8_t* y0, uint8_t* y1,
+                     uint8_t* u, uint8_t* v, int width) {
+        int col = 0;
+        for (; col + 8 <= width; col += 8) {
+            const __m128i* s0 = reinterpret_cast<const __m128i*>(src0 + col * BYTES_PER_PIXEL);
+            const __m128i* s1 = reinterpret_cast<const __m128i*>(src1 + col * BYTES_PER_PIXEL);
+            __m128i lo0 = _mm_loadu_si128(s0);
+            __m128i hi0 = _mm_loadu_si128(s0 + 1);
+            __m128i lo1 = _mm_loadu_si128(s1);
+            __m128i hi1 = _mm_loadu_si128(s1 + 1);
+
+            __m128i b0 = channelSse2<0>(lo0, hi0);
+            __m128i g0 = channelSse2<8>(lo0, hi0);
+            __m128i r0 = channelSse2<16>(lo0, hi0);
+            __m128i b1 = channelSse2<0>(lo1, hi1);
+            __m128i g1 = channelSse2<8>(lo1, hi1);
+            __m128i r1 = channelSse2<16>(lo1, hi1);
+
+            __m128i luma0 = lumaSse2(r0, g0, b0);
+            __m128i luma1 = lumaSse2(r1, g1, b1);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(y0 + col), _mm_packus_epi16(luma0, luma0));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(y1 + col), _mm_packus_epi16(luma1, luma1));
+
+            __m128i r = average2x2Sse2(r0, r1);
+            __m128i g = average2x2Sse2(g0, g1);
+            __m128i b = average2x2Sse2(b0, b1);
+            // Bytes 0-3: U, bytes 8-11: V
+            __m128i uv = _mm_packus_epi16(chromaSse2(r, g, b, U_R, U_G, U_B), chromaSse2(r, g, b, V_R, V_G, V_B));
+            int u4 = _mm_cvtsi128_si32(uv);
+            int v4 = _mm_cvtsi128_si32(_mm_srli_si128(uv, 8));
+            std::memcpy(u + col / 2, &u4, 4);
+            std::memcpy(v + col / 2, &v4, 4);
+        }
+
+        rowPairC(src0 + col * BYTES_PER_PIXEL, src1 + col * BYTES_PER_PIXEL, y0 + col, y1 + col,
+                 u + col / 2, v + col / 2, width - col);
+    }
+
+    // ===== AVX2: 16 pixels per iteration =====
+    //
+    // Same arithmetic as SSE2. AVX2 packs work per 128-bit lane, so results are
+    // put back in pixel order with cross-lane permutes.
+
+    template <int SHIFT>
+    AVX2_TARGET inline __m256i channelAvx2(__m256i lo, __m256i hi) {
+        const __m256i mask = _mm256_set1_epi32(0xFF);
+        __m256i packed = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(lo, SHIFT), mask),
+                                            _mm256_and_si256(_mm256_srli_epi32(hi, SHIFT), mask));
+        return _mm256_permute4x64_epi64(packed, 0xD8);
+    }
+
+    AVX2_TARGET inline __m256i lumaAvx2(__m256i r, __m256i g, __m256i b) {
+        __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(Y_R)),
+                                       _mm256_mullo_epi16(g, _mm256_set1_epi16(Y_G)));
+        sum = _mm256_add_epi16(sum, _mm256_add_epi16(_mm256_mullo_epi16(b, _mm256_set1_epi16(Y_B)),
+                                                     _mm256_set1_epi16(ROUND)));
+        return _mm256_add_epi16(_mm256_srli_epi16(sum, 8), _mm256_set1_epi16(Y_OFFSET));
+    }
+
+    // 16 luma values (16-bit) → 16 bytes in pixel order
+    AVX2_TARGET inline __m128i packLumaAvx2(__m256i luma) {
+        return _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi16(luma, luma), 0xD8));
+    }
+
+    // 2x2 averages of 16 x 2 samples: lane 0 holds values 0-3 (twice), lane 1 values 4-7 (twice)
+    AVX2_TARGET inline __m256i average2x2Avx2(__m256i row0, __m256i row1) {
+        __m256i pairs = _mm256_madd_epi16(_mm256_add_epi16(row0, row1), _mm256_set1_epi16(1));
+        __m256i avg = _mm256_srli_epi32(_mm256_add_epi32(pairs, _mm256_set1_epi32(2)), 2);
+        return _mm256_packs_epi32(avg, avg);
+    }
+
+    AVX2_TARGET inline __m256i chromaAvx2(__m256i r, __m256i g, __m256i b, int cr, int cg, int cb) {
+        __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(static_cast<short>(cr))),
+                                       _mm256_mullo_epi16(g, _mm256_set1_epi16(static_cast<short>(cg))));
+        sum = _mm256_add_epi16(sum, _mm256_add_epi16(_mm256_mullo_epi16(b, _mm256_set1_epi16(static_cast<short>(cb))),
+                                                     _mm256_set1_epi16(ROUND)));
+        return _mm256_add_epi16(_mm256_srai_epi16(sum, 8), _mm256_set1_epi16(UV_OFFSET));
+    }
+
+    AVX2_TARGET void rowPairAvx2(const uint8_t* src0, const uint8_t* src1, uint8_t* y0, uint8_t* y1,
+                                 uint8_t* u, uint8_t* v, int width) {
+        int col = 0;
+        for (; col + 16 <= width; col += 16) {
+            const __m256i* s0 = reinterpret_cast<const __m256i*>(src0 + col * BYTES_PER_PIXEL);
+            const __m256i* s1 = reinterpret_cast<const __m256i*>(src1 + col * BYTES_PER_PIXEL);
+            __m256i lo0 = _mm256_loadu_si256(s0);
+            __m256i hi0 = _mm256_loadu_si256(s0 + 1);
+            __m256i lo1 = _mm256_loadu_si256(s1);
+            __m256i hi1 = _mm256_loadu_si256(s1 + 1);
+
+            __m256i b0 = channelAvx2<0>(lo0, hi0);
+            __m256i g0 = channelAvx2<8>(lo0, hi0);
+            __m256i r0 = channelAvx2<16>(lo0, hi0);
+            __m256i b1 = channelAvx2<0>(lo1, hi1);
+            __m256i g1 = channelAvx2<8>(lo1, hi1);
+            __m256i r1 = channelAvx2<16>(lo1, hi1);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(y0 + col), packLumaAvx2(lumaAvx2(r0, g0, b0)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(y1 + col), packLumaAvx2(lumaAvx2(r1, g1, b1)));
+
+            __m256i r = average2x2Avx2(r0, r1);
+            __m256i g = average2x2Avx2(g0, g1);
+            __m256i b = average2x2Avx2(b0, b1);
+            // Per lane: 4 U bytes, 4 U (repeat), 4 V, 4 V (repeat) → U0-7 in bytes 0-7, V0-7 in bytes 8-15
+            __m256i uv = _mm256_packus_epi16(chromaAvx2(r, g, b, U_R, U_G, U_B), chromaAvx2(r, g, b, V_R, V_G, V_B));
+            __m128i ordered = _mm256_castsi256_si128(
+                _mm256_permutevar8x32_epi32(uv, _mm256_setr_epi32(0, 4, 2, 6, 1, 5, 3, 7)));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(u + col / 2), ordered);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(v + col / 2), _mm_srli_si128(ordered, 8));
+        }
+
+        rowPairSse2(src0 + col * BYTES_PER_PIXEL, src1 + col * BYTES_PER_PIXEL, y0 + col, y1 + col,
+                    u + col / 2, v + col / 2, width - col);
+    }
+#endif // COLOR_CONVERT_X86
+
+#ifdef COLOR_CONVERT_NEON
+    // ===== NEON: 16 pixels per iteration (vld4 de-interleaves B, G, R, A) =====
+
+    inline uint8x16_t lumaNeon(const uint8x16x4_t& pixels) {
+        uint16x8_t lo = vmull_u8(vget_low_u8(pixels.val[R]), vdup_n_u8(Y_R));
+        lo = vmlal_u8(lo, vget_low_u8(pixels.val[G]), vdup_n_u8(Y_G));
+        lo = vmlal_u8(lo, vget_low_u8(pixels.val[B]), vdup_n_u8(Y_B));
+        uint16x8_t hi = vmull_u8(vget_high_u8(pixels.val[R]), vdup_n_u8(Y_R));
+        hi = vmlal_u8(hi, vget_high_u8(pixels.val[G]), vdup_n_u8(Y_G));
+        hi = vmlal_u8(hi, vget_high_u8(pixels.val[B]), vdup_n_u8(Y_B));
+
+        // Rounding narrow: (sum + 128) >> 8
+        uint8x8_t offset = vdup_n_u8(Y_OFFSET);
+        return vcombine_u8(vadd_u8(vrshrn_n_u16(lo, 8), offset), vadd_u8(vrshrn_n_u16(hi, 8), offset));
+    }
+
+    // 2x2 averages: (sum + 2) >> 2
+    inline int16x8_t average2x2Neon(uint8x16_t row0, uint8x16_t row1) {
+        return vreinterpretq_s16_u16(vrshrq_n_u16(vpadalq_u8(vpaddlq_u8(row0), row1), 2));
+    }
+
+    inline uint8x8_t chromaNeon(int16x8_t r, int16x8_t g, int16x8_t b, int16_t cr, int16_t cg, int16_t cb) {
+        int16x8_t sum = vmulq_n_s16(r, cr);
+        sum = vmlaq_n_s16(sum, g, cg);
+        sum = vmlaq_n_s16(sum, b, cb);
+        sum = vaddq_s16(sum, vdupq_n_s16(ROUND));
+        return vqmovun_s16(vaddq_s16(vshrq_n_s16(sum, 8), vdupq_n_s16(UV_OFFSET)));
+    }
+
+    void rowPairNeon(const uint8_t* src0, const uint8_t* src1, uint8_t* y0, uint8_t* y1,
+                     uint8_t* u, uint8_t* v, int width) {
+        int col = 0;
+        for (; col + 16 <= width; col += 16) {
+            uint8x16x4_t p0 = vld4q_u8(src0 + col * BYTES_PER_PIXEL);
+            uint8x16x4_t p1 = vld4q_u8(src1 + col * BYTES_PER_PIXEL);
+
+            vst1q_u8(y0 + col, lumaNeon(p0));
+            vst1q_u8(y1 + col, lumaNeon(p1));
+
+            int16x8_t r = average2x2Neon(p0.val[R], p1.val[R]);
+            int16x8_t g = average2x2Neon(p0.val[G], p1.val[G]);
+            int16x8_t b = average2x2Neon(p0.val[B], p1.val[B]);
+            vst1_u8(u + col / 2, chromaNeon(r, g, b, U_R, U_G, U_B));
+            vst1_u8(v + col / 2, chromaNeon(r, g, b, V_R, V_G, V_B));
+        }
+
+        rowPairC(src0 + col * BYTES_PER_PIXEL, src1 + col * BYTES_PER_PIXEL, y0 + col, y1 + col,
+                 u + col / 2, v + col / 2, width - col);
+    }
+#endif // COLOR_CONVERT_NEON
+
+    // ===== Runtime dispatch =====
+
+    struct Kernel {
+        RowPairFn rowPair;
+        const char* name;
+    };
+
+    // Kernels this build can run on this CPU, fastest first
+    std::vector<Kernel> supportedKernels() {
+        std::vector<Kernel> kernels;
+#if defined(COLOR_CONVERT_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            kernels.push_back({rowPairAvx2, "AVX2"});
+        }
+        kernels.push_back({rowPairSse2, "SSE2"});
+#elif defined(COLOR_CONVERT_NEON)
+        kernels.push_back({rowPairNeon, "NEON"});
+#endif
+        kernels.push_back({rowPairC, "C"});
+        return kernels;
+    }
+
+    const std::vector<Kernel>& kernels() {
+        static const std::vector<Kernel> supported = supportedKernels();
+        return supported;
+    }
+
+    std::atomic<const Kernel*> selected{nullptr};
+
+    const Kernel& kernel() {
+        const Kernel* current = selected.load(std::memory_order_acquire);
+        if (!current) {
+            current = &kernels().front();
+            selected.store(current, std::memory_order_release);
+        }
+        return *current;
+    }
+}
+
+void ColorConverter::bgraToYuv420(const uint8_t* bgra, int bgraStride,
+                                  uint8_t* const dst[3], const int dstStride[3],
+                                  int x, int y, int width, int height) {
+    const RowPairFn rowPair = kernel().rowPair;
+    const int pairWidth = width & ~1;
+
+    for (int row = y; row < y + height; row += 2) {
+        // Odd height: the last row is paired with itself
+        const bool lastRow = row + 1 == y + height;
+        const uint8_t* src0 = bgra + static_cast<intptr_t>(row) * bgraStride + x * BYTES_PER_PIXEL;
+        const uint8_t* src1 = lastRow ? src0 : src0 + bgraStride;
+        uint8_t* y0 = dst[0] + static_cast<intptr_t>(row) * dstStride[0] + x;
+        uint8_t* y1 = lastRow ? y0 : y0 + dstStride[0];
+        uint8_t* u = dst[1] + static_cast<intptr_t>(row / 2) * dstStride[1] + x / 2;
+        uint8_t* v = dst[2] + static_cast<intptr_t>(row / 2) * dstStride[2] + x / 2;
+
+        rowPair(src0, src1, y0, y1, u, v, pairWidth);
+        if (width & 1) {
+            edgeColumnC(src0 + pairWidth * BYTES_PER_PIXEL, src1 + pairWidth * BYTES_PER_PIXEL,
+                        y0 + pairWidth, y1 + pairWidth, u + pairWidth / 2, v + pairWidth / 2);
+        }
+    }
+}
+
+const char* ColorConverter::implementationName() {
+    return kernel().name;
+}
+
+std::vector<std::string> ColorConverter::availableImplementations() {
+    std::vector<std::string> names;
+    for (const Kernel& candidate : kernels()) {
+        names.push_back(candidate.name);
+    }
+    return names;
+}
+
+bool ColorConverter::selectImplementation(const std::string& name) {
+    for (const Kernel& candidate : kernels()) {
+        if (name == candidate.name) {
+            selected.store(&candidate, std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,65 @@
+#ifndef COLOR_CONVERT_H
+#define COLOR_CONVERT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * ColorConverter - BGRA → YUV420P conversion without scaling
+ *
+ * The browser path renders at the output size, so it only needs a colour
+ * conversion, which swscale's generic scaler does far slower than a dedicated
+ * kernel. This one converts two rows at a time (one chroma row per pass):
+ *   - x86-64: SSE2, or AVX2 when the CPU has it (detected once at runtime)
+ *   - ARM64:  NEON
+ *   - other:  portable C (also used for the last columns of a row)
+ * All implementations produce identical output (tests/color_convert_test
+ * checks them against each other and against swscale).
+ *
+ * Colours are BT.709, limited range (the encoder tags its output the same
+ * way); chroma is averaged over each 2x2 block.
+ *
+ * Any rectangle of the frame can be converted (swscale only converts whole
+ * frames or top-to-bottom slices), so the browser path re-converts only its
+ * dirty macroblocks. Regions must start on even coordinates (one chroma
+ * sample per 2x2 luma block); an odd width or height is only allowed where the
+ * region ends at the right or bottom edge of the frame, whose last column or
+ * row is then repeated for chroma.
+ */
+class ColorConverter {
+public:
+    /**
+     * Convert one rectangle of a BGRA image into the same rectangle of a YUV420P image
+     * @param bgra BGRA image (top-left pixel of the frame, not of the region)
+     * @param bgraStride Bytes per BGRA row
+     * @param dst Y, U, V plane pointers (e.g. AVFrame::data)
+     * @param dstStride Y, U, V bytes per row (e.g. AVFrame::linesize)
+     * @param x Left edge of the region (even)
+     * @param y Top edge of the region (even)
+     * @param width Region width (even unless the region ends at the frame's right edge)
+     * @param height Region height (even unless the region ends at the frame's bottom edge)
+     */
+    static void bgraToYuv420(const uint8_t* bgra, int bgraStride,
+                             uint8_t* const dst[3], const int dstStride[3],
+                             int x, int y, int width, int height);
+
+    /**
+     * Name of the kernel selected for this CPU ("AVX2", "SSE2", "NEON" or "C")
+     */
+    static const char* implementationName();
+
+    /**
+     * Names of the kernels this build can run on this CPU, fastest first (always ends with "C")
+     */
+    static std::vector<std::string> availableImplementations();
+
+    /**
+     * Use a specific kernel instead of the fastest one (tests and benchmarks)
+     * @param name One of availableImplementations()
+     * @return false if the kernel is not available
+     */
+    static bool selectImplementation(const std::string& name);
+};
+
+#endif // COLOR_CONVERT_H
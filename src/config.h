@@ -3,12 +3,41 @@
 #define CONFIG_H
 
 #include <string>
+#include <vector>
+
+// HLS media segment container
+enum class SegmentFormat {
+    MPEGTS,  // .ts segments (needs Annex B H.264)
+    FMP4     // CMAF: init.mp4 + .m4s fragments (length-prefixed NAL units, no bitstream filter)
+};
 
 struct HLSConfig {
     std::string inputFile;
+    std::string backupInput;  // Live inputs: hot standby URI, used on failover (empty = reconnect only)
     std::string outputDir;
     int segmentDuration = 2;  // 2s segments - good balance of latency and efficiency
     int playlistSize = 3;     // Small live window (3 segments = ~6s buffer)
+    bool lowLatency = false;  // LL-HLS: partial segments + preload hints (REMUX/PROGRAMMATIC)
+    int partDurationMs = 200; // LL-HLS part target
+    SegmentFormat segmentFormat = SegmentFormat::MPEGTS;
+    bool asyncWrites = true;  // Write-behind I/O thread between the hls muxer and the output directory
+    int writeBufferMB = 64;   // Max queued output before the muxer waits for storage
+    int httpPort = 0;         // Embedded HTTP origin port (0 = disabled)
+    std::string httpBindAddress = "127.0.0.1";
+    bool writeToDisk = true;  // false: live segments only in memory (needs httpPort)
+    bool parallelVod = true;  // TRANSCODE of a file: segment-aligned chunks on parallel workers (ChunkedTranscoder)
+
+    // LL-HLS parts are cut from an MPEG-TS muxer, so fMP4 only applies to regular segments
+    bool usesFmp4() const { return segmentFormat == SegmentFormat::FMP4 && !lowLatency; }
+    SegmentFormat outputSegmentFormat() const { return usesFmp4() ? SegmentFormat::FMP4 : SegmentFormat::MPEGTS; }
+};
+
+// One rung of an adaptive-bitrate ladder (TRANSCODE mode)
+struct RenditionConfig {
+    std::string name;   // Variant name, used in playlist/segment file names (e.g. "720p")
+    int width = 0;
+    int height = 0;
+    int bitrate = 0;
 };
 
 struct VideoConfig {
@@ -16,8 +45,10 @@ struct VideoConfig {
     int height = 720;
     int fps = 30;
     int bitrate = 2500000;
-    int gop_size = 15;  // 15 frames = 0.5s keyframe interval for FAST segment generation
-                        // This ensures the first HLS segment appears within 0.5 seconds
+    int gop_size = 0;   // Max keyframe interval; 0 = one GOP per HLS segment (fps * segmentDuration)
+                        // IDRs are forced on segment boundaries by KeyframePlanner either way
+    std::vector<RenditionConfig> renditions;  // Empty = single output at width/height/bitrate
+    int encoderThreads = 0;  // Per encoder, set per rendition from the thread budget (0 = library default)
 };
 
 struct AudioConfig {
@@ -28,6 +59,13 @@ struct AudioConfig {
 
 struct BrowserConfig {
     bool enableJsInjection = true;  // Enable JavaScript injection by default
+    bool externalBeginFrame = false; // Render exactly one frame per output frame (BeginFrame from the frame clock)
+};
+
+// CPU budget shared by all channels of the process (see ThreadBudget)
+struct ThreadingConfig {
+    int cpuBudget = 0;     // Cores for the whole process (0 = all hardware threads)
+    int channelCores = 0;  // This channel's share of cpuBudget (set per channel at startup, 0 = whole budget)
 };
 
 struct AppConfig {
@@ -35,6 +73,7 @@ struct AppConfig {
     VideoConfig video;
     AudioConfig audio;
     BrowserConfig browser;
+    ThreadingConfig threading;
 };
 
 #endif // CONFIG_H
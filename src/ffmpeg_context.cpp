@@ -118,18 +118,27 @@ bool FFmpegContext::loadSymbols() {
     if (!name) { Logger::error("Failed to load function: " #name); return false; }
 
     // avformat functions
+    LOAD_FUNC(avformatLib_, avformat_alloc_context);
     LOAD_FUNC(avformatLib_, avformat_open_input);
     LOAD_FUNC(avformatLib_, avformat_close_input);
     LOAD_FUNC(avformatLib_, avformat_find_stream_info);
+    LOAD_FUNC(avformatLib_, av_find_input_format);
     LOAD_FUNC(avformatLib_, avformat_alloc_output_context2);
     LOAD_FUNC(avformatLib_, avformat_free_context);
     LOAD_FUNC(avformatLib_, avformat_new_stream);
     LOAD_FUNC(avformatLib_, avformat_write_header);
     LOAD_FUNC(avformatLib_, av_write_trailer);
     LOAD_FUNC(avformatLib_, av_interleaved_write_frame);
+    LOAD_FUNC(avformatLib_, av_write_frame);
     LOAD_FUNC(avformatLib_, av_read_frame);
+    LOAD_FUNC(avformatLib_, av_seek_frame);
     LOAD_FUNC(avformatLib_, avio_open);
     LOAD_FUNC(avformatLib_, avio_closep);
+    LOAD_FUNC(avformatLib_, avio_alloc_context);
+    LOAD_FUNC(avformatLib_, avio_context_free);
+    LOAD_FUNC(avformatLib_, avio_flush);
+    LOAD_FUNC(avformatLib_, avio_open_dyn_buf);
+    LOAD_FUNC(avformatLib_, avio_close_dyn_buf);
 
     // avcodec functions
     LOAD_FUNC(avcodecLib_, avcodec_find_decoder);
@@ -163,9 +172,14 @@ bool FFmpegContext::loadSymbols() {
     LOAD_FUNC(avutilLib_, av_frame_alloc);
     LOAD_FUNC(avutilLib_, av_frame_free);
     LOAD_FUNC(avutilLib_, av_frame_unref);
+    LOAD_FUNC(avutilLib_, av_frame_ref);
+    LOAD_FUNC(avutilLib_, av_frame_move_ref);
     LOAD_FUNC(avutilLib_, av_frame_get_buffer);
+    LOAD_FUNC(avutilLib_, av_frame_make_writable);
     LOAD_FUNC(avutilLib_, av_rescale_q);
     LOAD_FUNC(avutilLib_, av_opt_set);
+    LOAD_FUNC(avutilLib_, av_dict_set);
+    LOAD_FUNC(avutilLib_, av_dict_free);
     LOAD_FUNC(avutilLib_, av_malloc);
     LOAD_FUNC(avutilLib_, av_free);
 
@@ -174,6 +188,8 @@ bool FFmpegContext::loadSymbols() {
     LOAD_FUNC(swscaleLib_, sws_getCachedContext);
     LOAD_FUNC(swscaleLib_, sws_freeContext);
     LOAD_FUNC(swscaleLib_, sws_scale);
+    LOAD_FUNC(swscaleLib_, sws_setColorspaceDetails);
+    LOAD_FUNC(swscaleLib_, sws_getCoefficients);
 
     // swresample functions
     LOAD_FUNC(swresampleLib_, swr_alloc);
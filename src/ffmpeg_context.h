@@ -18,6 +18,7 @@ struct AVCodec;
 struct AVCodecParameters;
 struct AVRational;
 struct AVDictionary;
+struct AVInputFormat;
 struct AVOutputFormat;
 struct AVIOContext;
 struct AVBSFContext;
@@ -69,18 +70,30 @@ public:
     bool isInitialized() const { return initialized_; }
 
     // ===== avformat functions =====
-    int (*avformat_open_input)(AVFormatContext**, const char*, const AVOutputFormat*, AVDictionary**) = nullptr;
+    AVFormatContext* (*avformat_alloc_context)() = nullptr;
+    int (*avformat_open_input)(AVFormatContext**, const char*, const AVInputFormat*, AVDictionary**) = nullptr;
     void (*avformat_close_input)(AVFormatContext**) = nullptr;
     int (*avformat_find_stream_info)(AVFormatContext*, AVDictionary**) = nullptr;
+    const AVInputFormat* (*av_find_input_format)(const char*) = nullptr;
     int (*avformat_alloc_output_context2)(AVFormatContext**, const AVOutputFormat*, const char*, const char*) = nullptr;
     void (*avformat_free_context)(AVFormatContext*) = nullptr;
     AVStream* (*avformat_new_stream)(AVFormatContext*, const AVCodec*) = nullptr;
     int (*avformat_write_header)(AVFormatContext*, AVDictionary**) = nullptr;
     int (*av_write_trailer)(AVFormatContext*) = nullptr;
     int (*av_interleaved_write_frame)(AVFormatContext*, AVPacket*) = nullptr;
+    int (*av_write_frame)(AVFormatContext*, AVPacket*) = nullptr;
     int (*av_read_frame)(AVFormatContext*, AVPacket*) = nullptr;
+    int (*av_seek_frame)(AVFormatContext*, int, int64_t, int) = nullptr;
     int (*avio_open)(AVIOContext**, const char*, int) = nullptr;
     int (*avio_closep)(AVIOContext**) = nullptr;
+    AVIOContext* (*avio_alloc_context)(unsigned char*, int, int, void*,
+                                       int (*)(void*, uint8_t*, int),
+                                       int (*)(void*, const uint8_t*, int),
+                                       int64_t (*)(void*, int64_t, int)) = nullptr;
+    void (*avio_context_free)(AVIOContext**) = nullptr;
+    void (*avio_flush)(AVIOContext*) = nullptr;
+    int (*avio_open_dyn_buf)(AVIOContext**) = nullptr;
+    int (*avio_close_dyn_buf)(AVIOContext*, uint8_t**) = nullptr;
 
     // ===== avcodec functions =====
     const AVCodec* (*avcodec_find_decoder)(int) = nullptr;
@@ -111,7 +124,10 @@ public:
     AVFrame* (*av_frame_alloc)() = nullptr;
     void (*av_frame_free)(AVFrame**) = nullptr;
     void (*av_frame_unref)(AVFrame*) = nullptr;
+    int (*av_frame_ref)(AVFrame*, const AVFrame*) = nullptr;
+    void (*av_frame_move_ref)(AVFrame*, AVFrame*) = nullptr;
     int (*av_frame_get_buffer)(AVFrame*, int) = nullptr;
+    int (*av_frame_make_writable)(AVFrame*) = nullptr;
     AVPacket* (*av_packet_alloc)() = nullptr;
     void (*av_packet_free)(AVPacket**) = nullptr;
     void (*av_packet_unref)(AVPacket*) = nullptr;
@@ -119,6 +135,8 @@ public:
     void (*av_packet_rescale_ts)(AVPacket*, AVRational, AVRational) = nullptr;
     int64_t (*av_rescale_q)(int64_t, AVRational, AVRational) = nullptr;
     int (*av_opt_set)(void*, const char*, const char*, int) = nullptr;
+    int (*av_dict_set)(AVDictionary**, const char*, const char*, int) = nullptr;
+    void (*av_dict_free)(AVDictionary**) = nullptr;
     void* (*av_malloc)(size_t) = nullptr;
     void (*av_free)(void*) = nullptr;
 
@@ -127,6 +145,8 @@ public:
     SwsContext* (*sws_getCachedContext)(SwsContext*, int, int, int, int, int, int, int, void*, void*, const double*) = nullptr;
     void (*sws_freeContext)(SwsContext*) = nullptr;
     int (*sws_scale)(SwsContext*, const uint8_t* const*, const int*, int, int, uint8_t* const*, const int*) = nullptr;
+    int (*sws_setColorspaceDetails)(SwsContext*, const int*, int, const int*, int, int, int, int) = nullptr;
+    const int* (*sws_getCoefficients)(int) = nullptr;
 
     // ===== swresample functions =====
     SwrContext* (*swr_alloc)() = nullptr;
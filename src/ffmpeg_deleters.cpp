@@ -28,6 +28,12 @@ void AVFrameDeleter::operator()(AVFrame* frame) const {
     }
 }
 
+void AVPacketDeleter::operator()(AVPacket* packet) const {
+    if (packet && ffmpeg) {
+        ffmpeg->av_packet_free(&packet);
+    }
+}
+
 void SwsContextDeleter::operator()(SwsContext* ctx) const {
     if (ctx && ffmpeg) {
         ffmpeg->sws_freeContext(ctx);
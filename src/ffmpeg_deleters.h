@@ -12,6 +12,7 @@ extern "C" {
 struct AVFormatContext;
 struct AVCodecContext;
 struct AVFrame;
+struct AVPacket;
 struct SwsContext;
 struct AVBSFContext;
 struct SwrContext;
@@ -47,6 +48,15 @@ struct AVFrameDeleter {
     void operator()(AVFrame* frame) const;
 };
 
+struct AVPacketDeleter {
+    std::shared_ptr<FFmpegContext> ffmpeg;
+
+    AVPacketDeleter() = default;
+    explicit AVPacketDeleter(std::shared_ptr<FFmpegContext> ctx) : ffmpeg(ctx) {}
+
+    void operator()(AVPacket* packet) const;
+};
+
 struct SwsContextDeleter {
     std::shared_ptr<FFmpegContext> ffmpeg;
 
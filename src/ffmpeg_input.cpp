@@ -3,10 +3,78 @@
 #include "ffmpeg_context.h"
 #include "logger.h"
 
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
 extern "C" {
 #include <libavformat/avformat.h>
 }
 
+namespace {
+    // Fast-start open profile of a live protocol
+    struct OpenProfile {
+        const char* format = nullptr;  // Container the protocol carries (skips format probing)
+        std::vector<std::pair<const char*, const char*>> options;
+    };
+
+    OpenProfile openProfileFor(const std::string& protocol) {
+        OpenProfile profile;
+        if (protocol == "file") {
+            return profile;  // Files: FFmpeg's defaults (probing costs nothing noticeable)
+        }
+
+        // Live: small probe window, no demuxer-side buffering (the decoder's low-delay flag is set by VideoPipeline)
+        profile.options = {
+            {"probesize", "500000"},        // Bytes (default 5 MB)
+            {"analyzeduration", "500000"},  // Microseconds (default 5 s)
+            {"fpsprobesize", "0"},          // Frame rate comes from timestamps, not probing
+            {"fflags", "nobuffer"},
+        };
+
+        // Protocol latency options (query parameters in the URL still take precedence)
+        if (protocol == "srt") {
+            profile.format = "mpegts";
+            profile.options.push_back({"latency", "120000"});       // Microseconds of SRT receive latency
+        } else if (protocol == "rtmp") {
+            profile.format = "flv";
+            profile.options.push_back({"rtmp_live", "live"});
+            profile.options.push_back({"rtmp_buffer", "100"});      // Milliseconds (default 3000)
+        } else if (protocol == "udp") {
+            profile.format = "mpegts";
+            profile.options.push_back({"overrun_nonfatal", "1"});   // Keep going if the socket FIFO overflows
+        } else if (protocol == "rtsp") {
+            profile.options.push_back({"rtsp_flags", "prefer_tcp"}); // No UDP attempt + timeout behind NAT
+        }
+        return profile;
+    }
+
+    // The demuxer header already describes every stream well enough to set up decoding
+    bool streamsComplete(const AVFormatContext* ctx) {
+        if (ctx->nb_streams == 0) {
+            return false;
+        }
+        for (unsigned int i = 0; i < ctx->nb_streams; i++) {
+            const AVCodecParameters* par = ctx->streams[i]->codecpar;
+            if (par->codec_id == AV_CODEC_ID_NONE) {
+                return false;
+            }
+            if (par->codec_type == AVMEDIA_TYPE_VIDEO && (par->width <= 0 || par->height <= 0)) {
+                return false;
+            }
+            if (par->codec_type == AVMEDIA_TYPE_AUDIO && (par->sample_rate <= 0 || par->ch_layout.nb_channels <= 0)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    double elapsedMs(std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+    }
+}
+
 FFmpegInput::FFmpegInput(const std::string& protocol, std::shared_ptr<FFmpegContext> ffmpegCtx)
     : ffmpeg_(ffmpegCtx), protocol_(protocol) {}
 
@@ -15,16 +83,45 @@ FFmpegInput::~FFmpegInput() {
 }
 
 bool FFmpegInput::open(const std::string& uri) {
-    if (ffmpeg_->avformat_open_input(&formatContext_, uri.c_str(), nullptr, nullptr) != 0) {
+    auto openStart = std::chrono::steady_clock::now();
+
+    OpenProfile profile = openProfileFor(protocol_);
+    const AVInputFormat* format = profile.format ? ffmpeg_->av_find_input_format(profile.format) : nullptr;
+    AVDictionary* options = nullptr;
+    for (const auto& option : profile.options) {
+        ffmpeg_->av_dict_set(&options, option.first, option.second, 0);
+    }
+
+    // Pre-allocated context: the interrupt callback must be in place before the protocol connects
+    formatContext_ = ffmpeg_->avformat_alloc_context();
+    if (!formatContext_) {
+        ffmpeg_->av_dict_free(&options);
+        Logger::error("Failed to allocate input context");
+        return false;
+    }
+    formatContext_->interrupt_callback.callback = &FFmpegInput::interruptCallback;
+    formatContext_->interrupt_callback.opaque = this;
+
+    int ret = ffmpeg_->avformat_open_input(&formatContext_, uri.c_str(), format, &options);
+    ffmpeg_->av_dict_free(&options);  // Options the demuxer/protocol did not take
+    if (ret != 0) {
         Logger::error("Failed to open input: " + uri);
         return false;
     }
+    double openMs = elapsedMs(openStart);
 
-    if (ffmpeg_->avformat_find_stream_info(formatContext_, nullptr) < 0) {
+    // Live sources whose header already has full codec parameters skip the probe entirely
+    bool probe = !isLiveStream() || !streamsComplete(formatContext_);
+    if (probe && ffmpeg_->avformat_find_stream_info(formatContext_, nullptr) < 0) {
         Logger::error("Failed to find stream info");
         return false;
     }
 
+    Logger::info("Input opened in " + std::to_string(static_cast<int>(openMs)) + " ms" +
+                 (probe ? ", probed in " + std::to_string(static_cast<int>(elapsedMs(openStart) - openMs)) + " ms"
+                        : ", stream info from the header (no probe)") +
+                 (profile.options.empty() ? "" : " (" + protocol_ + " fast-start profile)"));
+
     for (unsigned int i = 0; i < formatContext_->nb_streams; i++) {
         if (formatContext_->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
             videoStreamIndex_ = i;
@@ -71,3 +168,12 @@ bool FFmpegInput::isLiveStream() const {
 std::string FFmpegInput::getTypeName() const {
     return protocol_;
 }
+
+void FFmpegInput::setInterruptCallback(std::function<bool()> callback) {
+    interruptCallback_ = std::move(callback);
+}
+
+int FFmpegInput::interruptCallback(void* opaque) {
+    FFmpegInput* self = static_cast<FFmpegInput*>(opaque);
+    return self->interruptCallback_ && self->interruptCallback_() ? 1 : 0;
+}
@@ -3,6 +3,7 @@
 #define FFMPEG_INPUT_H
 
 #include "stream_input.h"
+#include <functional>
 #include <memory>
 
 // Forward declarations
@@ -22,13 +23,17 @@ public:
     int getAudioStreamIndex() const override;
     bool isLiveStream() const override;
     std::string getTypeName() const override;
+    void setInterruptCallback(std::function<bool()> callback) override;
 
 private:
+    static int interruptCallback(void* opaque);
+
     std::shared_ptr<FFmpegContext> ffmpeg_;
     std::string protocol_;
     AVFormatContext* formatContext_ = nullptr;
     int videoStreamIndex_ = -1;
     int audioStreamIndex_ = -1;
+    std::function<bool()> interruptCallback_;
 };
 
 #endif // FFMPEG_INPUT_H
@@ -5,6 +5,15 @@
 #include "logger.h"
 #include "stream_input.h"
 #include "browser_input.h"
+#include "staged_transcoder.h"
+#include "llhls_writer.h"
+#include "segment_writer.h"
+#include "codec_compat.h"
+#include "segment_store.h"
+#include "http_origin.h"
+#include "input_standby.h"
+#include "input_timeline.h"
+#include "chunked_transcoder.h"
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -14,7 +23,11 @@ extern "C" {
 #include <libavutil/opt.h>
 }
 
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <sstream>
+#include <thread>
 #include <vector>
 #include <cstdlib>
 
@@ -28,8 +41,11 @@ extern "C" {
 // Constants for logging and control flow
 namespace {
     constexpr int PACKET_LOG_INTERVAL = 100;           // Log every N packets
-    constexpr int FRAME_LOG_INTERVAL = 100;            // Log every N frames
-    constexpr int MAX_EMPTY_READ_ATTEMPTS = 1000;      // Max empty reads before EOF
+
+    // Live input reconnect: retry interval doubles from the initial value up to the maximum
+    constexpr int RECONNECT_INITIAL_BACKOFF_MS = 250;
+    constexpr int RECONNECT_MAX_BACKOFF_MS = 10000;
+    constexpr int RECONNECT_POLL_MS = 100;             // Ctrl+C / standby check while backing off
 }
 
 FFmpegWrapper::FFmpegWrapper(const AppConfig& config)
@@ -49,6 +65,7 @@ bool FFmpegWrapper::loadLibraries(const std::string& libPath) {
     // Create specialized pipelines (all share the same FFmpegContext)
     videoPipeline_ = std::make_unique<VideoPipeline>(ffmpegCtx_);
     audioPipeline_ = std::make_unique<AudioPipeline>(ffmpegCtx_);
+    inputTimeline_ = std::make_unique<InputTimeline>(ffmpegCtx_);
 
     Logger::info("FFmpeg context and pipelines initialized successfully");
 
@@ -63,6 +80,7 @@ bool FFmpegWrapper::openInput(const std::string& uri) {
     }
 
     input_uri_ = uri;
+    openStart_ = std::chrono::steady_clock::now();
     Logger::info("Opening input: " + uri);
 
     streamInput_ = StreamInputFactory::create(uri, config_, ffmpegCtx_);
@@ -75,10 +93,10 @@ bool FFmpegWrapper::openInput(const std::string& uri) {
 
     BrowserInput* browserInput = dynamic_cast<BrowserInput*>(streamInput_.get());
     if (browserInput) {
-        browserInput->setPageReloadCallback([this]() {
+        browserInput->setDiscontinuityCallback([this]() {
             return this->resetOutput();
         });
-        Logger::info("Page reload callback configured for browser input");
+        Logger::info("Discontinuity callback configured for browser input");
     }
 
     if (!streamInput_->open(uri)) {
@@ -86,6 +104,18 @@ bool FFmpegWrapper::openInput(const std::string& uri) {
         return false;
     }
 
+    if (!analyzeInput()) {
+        return false;
+    }
+
+    // Hot standby: the backup is connected and probed while the primary runs
+    if (!config_.hls.backupInput.empty() && streamInput_->isLiveStream() && !streamInput_->isProgrammatic()) {
+        startStandby(config_.hls.backupInput);
+    }
+    return true;
+}
+
+bool FFmpegWrapper::analyzeInput() {
     inputFormatCtx_ = streamInput_->getFormatContext();
     videoStreamIndex_ = streamInput_->getVideoStreamIndex();
     audioStreamIndex_ = streamInput_->getAudioStreamIndex();
@@ -142,12 +172,16 @@ bool FFmpegWrapper::detectAndDecideProcessingMode() {
     // Check if input is programmatic (browser/CEF sources)
     if (streamInput_ && streamInput_->isProgrammatic()) {
         Logger::info("Input is programmatic: Using PROGRAMMATIC mode (generated packets)");
+        if (config_.video.renditions.size() > 1) {
+            Logger::warn("Rendition ladder is not supported for programmatic input, using a single rendition");
+        }
         processingMode_ = ProcessingMode::PROGRAMMATIC;
         return true;
     }
 
     // Delegate mode detection to VideoPipeline
-    VideoPipeline::Mode videoMode = videoPipeline_->detectMode(inputFormatCtx_->streams[videoStreamIndex_]);
+    VideoPipeline::Mode videoMode = videoPipeline_->detectMode(inputFormatCtx_->streams[videoStreamIndex_],
+                                                               config_.hls.outputSegmentFormat());
 
     // Map VideoPipeline::Mode to FFmpegWrapper::ProcessingMode
     switch (videoMode) {
@@ -162,13 +196,70 @@ bool FFmpegWrapper::detectAndDecideProcessingMode() {
             break;
     }
 
+    // A rendition ladder needs decoded frames, even for HLS-compatible input
+    if (config_.video.renditions.size() > 1 && processingMode_ == ProcessingMode::REMUX) {
+        Logger::info("Rendition ladder requested: using TRANSCODE mode instead of REMUX");
+        processingMode_ = ProcessingMode::TRANSCODE;
+    }
+
     return true;
 }
 
+std::vector<RenditionConfig> FFmpegWrapper::getRenditions() const {
+    // Only TRANSCODE mode produces several renditions; the others copy one video stream
+    if (processingMode_ == ProcessingMode::TRANSCODE && !config_.video.renditions.empty()) {
+        return config_.video.renditions;
+    }
+
+    RenditionConfig single;
+    single.width = config_.video.width;
+    single.height = config_.video.height;
+    single.bitrate = config_.video.bitrate;
+    return {single};
+}
+
+ThreadBudget::Plan FFmpegWrapper::getThreadPlan() const {
+    return ThreadBudget::plan(config_.threading.channelCores, getRenditions(), streamInput_->isLiveStream());
+}
+
+int FFmpegWrapper::getChunkWorkers() const {
+    return config_.threading.channelCores > 0 ? config_.threading.channelCores : ThreadBudget::coresPerChannel(0, 1);
+}
+
+bool FFmpegWrapper::useChunkedTranscode() const {
+    if (!config_.hls.parallelVod || processingMode_ != ProcessingMode::TRANSCODE ||
+        streamInput_->isLiveStream() || streamInput_->isProgrammatic()) {
+        return false;
+    }
+    if (getRenditions().size() > 1) {
+        Logger::info("Parallel VOD transcode supports a single rendition, transcoding the ladder sequentially");
+        return false;
+    }
+    if (config_.hls.usesFmp4()) {
+        Logger::info("Parallel VOD transcode writes MPEG-TS segments, transcoding fMP4 sequentially");
+        return false;
+    }
+    return ChunkedTranscoder::worthChunking(duration_, config_.hls.segmentDuration, getChunkWorkers());
+}
+
+VideoPipeline* FFmpegWrapper::getRenditionPipeline(size_t index) {
+    if (index == 0) {
+        return videoPipeline_.get();
+    }
+    return index - 1 < extraVideoPipelines_.size() ? extraVideoPipelines_[index - 1].get() : nullptr;
+}
+
 bool FFmpegWrapper::openInputCodec() {
     // Only open decoder if we need to transcode
     if (processingMode_ == ProcessingMode::TRANSCODE) {
-        return videoPipeline_->setupDecoder(inputFormatCtx_->streams[videoStreamIndex_]);
+        ThreadBudget::Plan plan = getThreadPlan();
+        Logger::info("Threads: " + ThreadBudget::describe(plan));
+        if (plan.oversubscribed) {
+            Logger::warn("CPU budget is smaller than one core per pipeline step, threads will share cores");
+        }
+        return videoPipeline_->setupDecoder(inputFormatCtx_->streams[videoStreamIndex_],
+                                            plan.decodeThreads, plan.sliceThreading,
+                                            streamInput_->isLiveStream());
     }
     return true;
 }
@@ -190,38 +281,125 @@ bool FFmpegWrapper::setupOutput() {
 #endif
     }
 
-    std::string playlistPath = config_.hls.outputDir + "/playlist.m3u8";
+    // Memory-only output keeps a live window; a VOD playlist lists (and needs) every segment
+    if (!config_.hls.writeToDisk && !streamInput_->isLiveStream()) {
+        Logger::error("--no-disk needs a live input (a VOD playlist keeps every segment)");
+        return false;
+    }
+
+    // Parallel chunked VOD writes its own segments and playlist once all chunks are done: no hls muxer
+    chunkedVod_ = useChunkedTranscode();
+    if (chunkedVod_) {
+        Logger::info("  Segment format: MPEG-TS (parallel chunked VOD transcode)");
+        return startHttpOrigin();
+    }
 
-    // Create preliminary playlist immediately to avoid 404 errors from players
-    // This empty playlist tells the player the stream is starting soon
-    Logger::info("Creating preliminary HLS playlist (prevents 404 race condition)");
-    std::ofstream prelimPlaylist(playlistPath);
-    if (prelimPlaylist.is_open()) {
+    const std::vector<RenditionConfig> renditions = getRenditions();
+    const bool multiVariant = renditions.size() > 1;
+
+    // LL-HLS cuts parts in front of the packets it sees, which the staged TRANSCODE muxer does not expose
+    const bool lowLatency = config_.hls.lowLatency && processingMode_ != ProcessingMode::TRANSCODE;
+    if (config_.hls.lowLatency && !lowLatency) {
+        Logger::warn("LL-HLS is not supported in TRANSCODE mode, using regular HLS segments");
+    }
+    if (config_.hls.lowLatency && config_.hls.segmentFormat == SegmentFormat::FMP4) {
+        Logger::warn("LL-HLS parts are written as MPEG-TS, ignoring fMP4 segment format");
+    }
+
+    // fMP4 keeps the length-prefixed NAL units of MP4/MKV input: no h264_mp4toannexb pass
+    const bool fmp4 = config_.hls.usesFmp4();
+    Logger::info(std::string("  Segment format: ") + (fmp4 ? "fMP4 (CMAF)" : "MPEG-TS"));
+
+    // Multi-variant output: one media playlist per rendition (%v = variant name) + master.m3u8
+    const std::string playlistName = multiVariant ? "playlist_%v.m3u8" : "playlist.m3u8";
+    std::string playlistPath = config_.hls.outputDir + "/" + playlistName;
+
+    // Embedded HTTP origin: the write-behind thread also publishes every file into an in-memory store.
+    // Memory-only output needs that path (checked with the arguments) and a live window (checked above)
+    const bool serve = config_.hls.httpPort > 0;
+    const bool writeToDisk = config_.hls.writeToDisk;
+    if (serve && !lowLatency && config_.hls.asyncWrites && !segmentStore_) {
+        // Live window of every playlist (+ the one being written and a grace segment); init segments are pinned
+        const size_t playlists = renditions.size() + 1;
+        segmentStore_ = std::make_unique<SegmentStore>((config_.hls.playlistSize + 2) * playlists);
+    }
+
+    if (multiVariant) {
+        // Players start from master.m3u8, which hlsenc writes together with the header
+        Logger::info("Rendition ladder: " + std::to_string(renditions.size()) + " variants + master.m3u8");
+    } else {
+        // Create preliminary playlist immediately to avoid 404 errors from players
+        // This empty playlist tells the player the stream is starting soon
+        Logger::info("Creating preliminary HLS playlist (prevents 404 race condition)");
+        std::ostringstream prelimPlaylist;
         prelimPlaylist << "#EXTM3U\n";
-        prelimPlaylist << "#EXT-X-VERSION:6\n";
+        prelimPlaylist << "#EXT-X-VERSION:" << (fmp4 ? 7 : 6) << "\n";
         prelimPlaylist << "#EXT-X-TARGETDURATION:" << config_.hls.segmentDuration << "\n";
         prelimPlaylist << "#EXT-X-MEDIA-SEQUENCE:0\n";
         prelimPlaylist << "#EXT-X-PLAYLIST-TYPE:EVENT\n";
-        prelimPlaylist.close();
-        Logger::info("Preliminary playlist created: " + playlistPath);
-    } else {
-        Logger::warn("Could not create preliminary playlist (non-fatal)");
+        const std::string prelimText = prelimPlaylist.str();
+
+        if (segmentStore_) {
+            segmentStore_->put(playlistName, std::make_shared<const std::vector<uint8_t>>(prelimText.begin(), prelimText.end()));
+        }
+        if (writeToDisk) {
+            std::ofstream prelimFile(playlistPath);
+            if (prelimFile.is_open()) {
+                prelimFile << prelimText;
+                prelimFile.close();
+                Logger::info("Preliminary playlist created: " + playlistPath);
+            } else {
+                Logger::warn("Could not create preliminary playlist (non-fatal)");
+            }
+        }
+    }
+
+    // Write-behind: the muxer writes into memory, SegmentWriter's thread writes the files
+    const bool asyncWrites = config_.hls.asyncWrites && !lowLatency;
+    if (asyncWrites && !segmentWriter_) {
+        SegmentWriter::Options options;
+        options.outputDir = config_.hls.outputDir;
+        options.memoryLimitBytes = static_cast<size_t>(config_.hls.writeBufferMB) * 1024 * 1024;
+        options.deleteOldSegments = streamInput_->isLiveStream();
+        options.writeToDisk = writeToDisk;
+        options.store = segmentStore_.get();
+        options.startTime = openStart_;
+        segmentWriter_ = std::make_unique<SegmentWriter>(ffmpegCtx_, options);
+        if (!segmentWriter_->start()) {
+            Logger::warn("Write-behind output unavailable, writing segments from the muxing thread");
+            segmentWriter_.reset();
+        }
     }
+    std::string muxerPlaylistPath = segmentWriter_ ? segmentWriter_->stagingPath(playlistName) : playlistPath;
 
     Logger::info("Creating HLS output: " + playlistPath);
 
+    // LL-HLS: plain mpegts muxer, LLHLSWriter splits its output into parts and writes the playlist
     AVFormatContext* temp_format_ctx = nullptr;
-    if (ffmpegCtx_->avformat_alloc_output_context2(&temp_format_ctx, nullptr, "hls", playlistPath.c_str()) < 0) {
+    if (ffmpegCtx_->avformat_alloc_output_context2(&temp_format_ctx, nullptr, lowLatency ? "mpegts" : "hls",
+                                                   lowLatency ? nullptr : muxerPlaylistPath.c_str()) < 0) {
         Logger::error("Failed to allocate output context");
         return false;
     }
     outputFormatCtx_.reset(temp_format_ctx);
 
-    AVStream* outVideoStream = ffmpegCtx_->avformat_new_stream(outputFormatCtx_.get(), nullptr);
-    if (!outVideoStream) {
-        Logger::error("Failed to create output video stream");
-        return false;
+    if (segmentWriter_) {
+        segmentWriter_->attach(outputFormatCtx_.get());
     }
+
+    // Video streams first (one per rendition), so their indices match the var_stream_map order
+    std::vector<AVStream*> outVideoStreams;
+    outputVideoStreamIndices_.clear();
+    for (size_t i = 0; i < renditions.size(); i++) {
+        AVStream* stream = ffmpegCtx_->avformat_new_stream(outputFormatCtx_.get(), nullptr);
+        if (!stream) {
+            Logger::error("Failed to create output video stream");
+            return false;
+        }
+        outVideoStreams.push_back(stream);
+        outputVideoStreamIndices_.push_back(stream->index);
+    }
+    AVStream* outVideoStream = outVideoStreams[0];
     outputVideoStreamIndex_ = outVideoStream->index;
 
     AVStream* outAudioStream = nullptr;
@@ -251,6 +429,146 @@ bool FFmpegWrapper::setupOutput() {
         Logger::info("Created audio output stream at index " + std::to_string(outputAudioStreamIndex_));
     }
 
+    if (!configureOutputStreams(outVideoStreams, outAudioStream)) {
+        return false;
+    }
+
+    if (lowLatency) {
+        if (!llhlsWriter_) {
+            LLHLSWriter::Options options;
+            options.outputDir = config_.hls.outputDir;
+            options.segmentDurationSec = config_.hls.segmentDuration;
+            options.partDurationMs = config_.hls.partDurationMs;
+            options.fps = config_.video.fps;
+            options.playlistSize = config_.hls.playlistSize;
+            options.canBlockReload = serve;
+            options.keyframesForced = processingMode_ == ProcessingMode::PROGRAMMATIC;  // REMUX copies the source GOP
+            llhlsWriter_ = std::make_unique<LLHLSWriter>(ffmpegCtx_, options);
+        }
+
+        if (!llhlsWriter_->attach(outputFormatCtx_.get())) {
+            Logger::error("Failed to attach LL-HLS writer");
+            return false;
+        }
+
+        if (ffmpegCtx_->avformat_write_header(outputFormatCtx_.get(), nullptr) < 0) {
+            Logger::error("Failed to write output header");
+            return false;
+        }
+
+        Logger::info("LL-HLS output configured successfully");
+        return startHttpOrigin();
+    }
+
+    // Configure segment duration for HLS output (encoders force IDRs on the same grid)
+    ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_time",
+                           std::to_string(config_.hls.segmentDuration).c_str(), 0);
+
+    const std::string partPrefix = "part" + std::to_string(reload_count_);
+    std::string segmentPattern = config_.hls.outputDir + "/" + partPrefix +
+                                 (multiVariant ? "_%v_segment%03d" : "_segment%03d") + (fmp4 ? ".m4s" : ".ts");
+    ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_segment_filename", segmentPattern.c_str(), 0);
+
+    if (fmp4) {
+        // Init segment (ftyp + moov) is written next to the playlist; media segments are moof + mdat
+        std::string initName = partPrefix + (multiVariant ? "_%v_init.mp4" : "_init.mp4");
+        if (ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_segment_type", "fmp4", 0) < 0) {
+            Logger::error("Failed to select fMP4 HLS segments");
+            return false;
+        }
+        ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_fmp4_init_filename", initName.c_str(), 0);
+    }
+
+    if (multiVariant) {
+        // Each video rendition gets its own variant; audio is one shared rendition group
+        std::string varStreamMap;
+        if (outputAudioStreamIndex_ >= 0) {
+            varStreamMap = "a:0,agroup:audio,name:audio";
+        }
+        for (size_t i = 0; i < renditions.size(); i++) {
+            if (!varStreamMap.empty()) {
+                varStreamMap += " ";
+            }
+            varStreamMap += "v:" + std::to_string(i) + ",name:" + renditions[i].name;
+            if (outputAudioStreamIndex_ >= 0) {
+                varStreamMap += ",agroup:audio";
+            }
+        }
+
+        if (ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "var_stream_map", varStreamMap.c_str(), 0) < 0) {
+            Logger::error("Failed to set HLS var_stream_map: " + varStreamMap);
+            return false;
+        }
+        ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "master_pl_name", "master.m3u8", 0);
+        Logger::info("Variant stream map: " + varStreamMap);
+    }
+
+    // Start HLS segment numbering from 000
+    ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "start_number", "0", 0);
+
+    if (streamInput_->isLiveStream()) {
+        ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_playlist_type", "event", 0);
+        ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_list_size", std::to_string(config_.hls.playlistSize).c_str(), 0);
+        // With write-behind output, SegmentWriter deletes segments once they are out of the playlist
+        const std::string baseFlags = segmentWriter_ ? "append_list+independent_segments"
+                                                     : "append_list+delete_segments+independent_segments";
+        if (ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_flags", baseFlags.c_str(), 0) < 0) {
+            Logger::error("Failed to set HLS flags: " + baseFlags);
+            return false;
+        }
+
+        int ffmpegMajor = 0;
+        if (ffmpegCtx_->av_version_info) {
+            const char* ver = ffmpegCtx_->av_version_info();
+            if (ver) {
+                ffmpegMajor = std::atoi(ver);
+            }
+        }
+
+        if (ffmpegMajor >= 7) {
+            const std::string rapidFlags = baseFlags + "+rapid_chunking";
+            if (ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_flags", rapidFlags.c_str(), 0) == 0) {
+                Logger::info("Configured for live streaming (event type, " + std::to_string(config_.hls.playlistSize) +
+                             " segments x " + std::to_string(config_.hls.segmentDuration) + "s, rapid chunking, auto-cleanup)");
+            } else {
+                Logger::warn("rapid_chunking flag not supported by this FFmpeg build, continuing without it");
+                ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_flags", baseFlags.c_str(), 0);
+                Logger::info("Configured for live streaming (event type, " + std::to_string(config_.hls.playlistSize) +
+                             " segments x " + std::to_string(config_.hls.segmentDuration) + "s, auto-cleanup)");
+            }
+        } else {
+            Logger::info("Configured for live streaming (event type, " + std::to_string(config_.hls.playlistSize) +
+                         " segments x " + std::to_string(config_.hls.segmentDuration) + "s, auto-cleanup)");
+        }
+    } else {
+        ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_list_size", "0", 0);
+        ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_playlist_type", "vod", 0);
+        Logger::info("Configured for VOD (Video on Demand)");
+    }
+
+    if (!(outputFormatCtx_->oformat->flags & AVFMT_NOFILE)) {
+        if (ffmpegCtx_->avio_open(&outputFormatCtx_->pb, playlistPath.c_str(), AVIO_FLAG_WRITE) < 0) {
+            Logger::error("Failed to open output file");
+            return false;
+        }
+    }
+
+    if (ffmpegCtx_->avformat_write_header(outputFormatCtx_.get(), nullptr) < 0) {
+        Logger::error("Failed to write output header");
+        return false;
+    }
+
+    Logger::info("HLS output configured successfully");
+    return startHttpOrigin();
+}
+
+bool FFmpegWrapper::configureOutputStreams(const std::vector<AVStream*>& outVideoStreams, AVStream* outAudioStream) {
+    // Codec parameters, encoders and bitstream filters for the current input (also after a failover)
+    const std::vector<RenditionConfig> renditions = getRenditions();
+    const bool multiVariant = renditions.size() > 1;
+    const bool fmp4 = config_.hls.usesFmp4();
+    AVStream* outVideoStream = outVideoStreams[0];
+
     if (processingMode_ == ProcessingMode::REMUX) {
         Logger::info("Configuring output for REMUX mode");
         AVStream* inVideoStream = inputFormatCtx_->streams[videoStreamIndex_];
@@ -261,20 +579,21 @@ bool FFmpegWrapper::setupOutput() {
         }
 
         outVideoStream->time_base = inVideoStream->time_base;
+        // Input container tags do not carry over (fMP4 HEVC must be hvc1 for Apple players)
+        outVideoStream->codecpar->codec_tag = fmp4 ? CodecCompat::fmp4CodecTag(inVideoStream->codecpar->codec_id) : 0;
 
+        // Audio is copied or transcoded to AAC independently of the video path
         if (audioStreamIndex_ >= 0 && outAudioStream) {
             AVStream* inAudioStream = inputFormatCtx_->streams[audioStreamIndex_];
-            if (ffmpegCtx_->avcodec_parameters_copy(outAudioStream->codecpar, inAudioStream->codecpar) < 0) {
-                Logger::error("Failed to copy audio codec parameters");
+            if (!audioPipeline_->setupEncoder(inAudioStream, outAudioStream, audioStreamIndex_,
+                                               inputFormatCtx_, config_.hls.outputSegmentFormat())) {
+                Logger::error("Failed to setup audio via AudioPipeline");
                 return false;
             }
-            outAudioStream->time_base = inAudioStream->time_base;
-            Logger::info("Audio stream configured (codec ID: " +
-                        std::to_string(inAudioStream->codecpar->codec_id) + ")");
         }
 
-        // Setup bitstream filter for REMUX mode via VideoPipeline
-        if (!videoPipeline_->setupBitstreamFilter(
+        // Setup bitstream filter for REMUX mode via VideoPipeline (MPEG-TS needs Annex B)
+        if (!fmp4 && !videoPipeline_->setupBitstreamFilter(
             inVideoStream,
             outVideoStream,
             VideoPipeline::Mode::REMUX,
@@ -304,8 +623,8 @@ bool FFmpegWrapper::setupOutput() {
                         std::to_string(inAudioStream->codecpar->codec_id) + ")");
         }
 
-        // Setup bitstream filter for PROGRAMMATIC mode via VideoPipeline
-        if (!videoPipeline_->setupBitstreamFilter(
+        // Setup bitstream filter for PROGRAMMATIC mode via VideoPipeline (MPEG-TS needs Annex B)
+        if (!fmp4 && !videoPipeline_->setupBitstreamFilter(
             inVideoStream,
             outVideoStream,
             VideoPipeline::Mode::PROGRAMMATIC,
@@ -316,112 +635,124 @@ bool FFmpegWrapper::setupOutput() {
     } else {
         Logger::info("Configuring output for TRANSCODE mode");
 
-        // Setup video encoder (H.264) via VideoPipeline
-        if (!videoPipeline_->setupEncoder(outVideoStream, config_)) {
-            Logger::error("Failed to setup video encoder");
-            return false;
+        // Rendition 0 is encoded by the decoding pipeline, the others get their own
+        extraVideoPipelines_.clear();
+        for (size_t i = 1; i < renditions.size(); i++) {
+            extraVideoPipelines_.push_back(std::make_unique<VideoPipeline>(ffmpegCtx_));
         }
 
-        // Setup bitstream filter via VideoPipeline
-        if (!videoPipeline_->setupBitstreamFilter(
-            inputFormatCtx_->streams[videoStreamIndex_],
-            outVideoStream,
-            VideoPipeline::Mode::TRANSCODE,
-            videoPipeline_->getOutputCodecContext()->time_base)) {
-            Logger::error("Failed to setup bitstream filter");
-            return false;
+        const ThreadBudget::Plan threadPlan = getThreadPlan();
+        for (size_t i = 0; i < renditions.size(); i++) {
+            const RenditionConfig& rendition = renditions[i];
+            VideoPipeline* pipeline = getRenditionPipeline(i);
+
+            AppConfig renditionConfig = config_;
+            renditionConfig.video.width = rendition.width;
+            renditionConfig.video.height = rendition.height;
+            renditionConfig.video.bitrate = rendition.bitrate;
+            renditionConfig.video.encoderThreads = threadPlan.encodeThreads[i];
+
+            if (multiVariant) {
+                Logger::info("  Rendition " + rendition.name + ": " + std::to_string(rendition.width) + "x" +
+                             std::to_string(rendition.height) + " @ " + std::to_string(rendition.bitrate / 1000) + " kbps");
+            }
+
+            // Setup video encoder (H.264) via VideoPipeline
+            if (!pipeline->setupEncoder(outVideoStreams[i], renditionConfig)) {
+                Logger::error("Failed to setup video encoder");
+                return false;
+            }
+
+            // Setup bitstream filter via VideoPipeline (MPEG-TS only)
+            if (!fmp4 && !pipeline->setupBitstreamFilter(
+                inputFormatCtx_->streams[videoStreamIndex_],
+                outVideoStreams[i],
+                VideoPipeline::Mode::TRANSCODE,
+                pipeline->getOutputCodecContext()->time_base)) {
+                Logger::error("Failed to setup bitstream filter");
+                return false;
+            }
         }
 
         // Configure audio stream in TRANSCODE mode via AudioPipeline
         if (audioStreamIndex_ >= 0 && outAudioStream) {
             AVStream* inAudioStream = inputFormatCtx_->streams[audioStreamIndex_];
 
-            if (!audioPipeline_->setupEncoder(inAudioStream, outAudioStream,
-                                               audioStreamIndex_, inputFormatCtx_)) {
+            if (!audioPipeline_->setupEncoder(inAudioStream, outAudioStream, audioStreamIndex_,
+                                               inputFormatCtx_, config_.hls.outputSegmentFormat())) {
                 Logger::error("Failed to setup audio encoder via AudioPipeline");
                 return false;
             }
         }
     }
 
-    // Configure segment duration for HLS output
-    ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_time", "0.5", 0);
-
-    std::string segmentPattern = config_.hls.outputDir + "/part" + std::to_string(reload_count_) + "_segment%03d.ts";
-    ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_segment_filename", segmentPattern.c_str(), 0);
-
-    // Start HLS segment numbering from 000
-    ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "start_number", "0", 0);
-
-    if (streamInput_->isLiveStream()) {
-        ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_playlist_type", "event", 0);
-        ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_list_size", std::to_string(config_.hls.playlistSize).c_str(), 0);
-        const std::string baseFlags = "append_list+delete_segments+independent_segments";
-        if (ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_flags", baseFlags.c_str(), 0) < 0) {
-            Logger::error("Failed to set HLS flags: " + baseFlags);
-            return false;
-        }
-
-        int ffmpegMajor = 0;
-        if (ffmpegCtx_->av_version_info) {
-            const char* ver = ffmpegCtx_->av_version_info();
-            if (ver) {
-                ffmpegMajor = std::atoi(ver);
-            }
-        }
+    return true;
+}
 
-        if (ffmpegMajor >= 7) {
-            const std::string rapidFlags = baseFlags + "+rapid_chunking";
-            if (ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_flags", rapidFlags.c_str(), 0) == 0) {
-                Logger::info("Configured for live streaming (event type, " + std::to_string(config_.hls.playlistSize) +
-                             " segments x " + std::to_string(config_.hls.segmentDuration) + "s, rapid chunking, auto-cleanup)");
-            } else {
-                Logger::warn("rapid_chunking flag not supported by this FFmpeg build, continuing without it");
-                ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_flags", baseFlags.c_str(), 0);
-                Logger::info("Configured for live streaming (event type, " + std::to_string(config_.hls.playlistSize) +
-                             " segments x " + std::to_string(config_.hls.segmentDuration) + "s, auto-cleanup)");
-            }
-        } else {
-            Logger::info("Configured for live streaming (event type, " + std::to_string(config_.hls.playlistSize) +
-                         " segments x " + std::to_string(config_.hls.segmentDuration) + "s, auto-cleanup)");
-        }
-    } else {
-        ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_list_size", "0", 0);
-        ffmpegCtx_->av_opt_set(outputFormatCtx_->priv_data, "hls_playlist_type", "vod", 0);
-        Logger::info("Configured for VOD (Video on Demand)");
+bool FFmpegWrapper::startHttpOrigin() {
+    // Started once: keeps serving across resetOutput() (same store and LL-HLS writer)
+    if (config_.hls.httpPort <= 0 || httpOrigin_) {
+        return true;
     }
 
-    if (!(outputFormatCtx_->oformat->flags & AVFMT_NOFILE)) {
-        if (ffmpegCtx_->avio_open(&outputFormatCtx_->pb, playlistPath.c_str(), AVIO_FLAG_WRITE) < 0) {
-            Logger::error("Failed to open output file");
-            return false;
-        }
-    }
+    HttpOrigin::Options options;
+    options.bindAddress = config_.hls.httpBindAddress;
+    options.port = config_.hls.httpPort;
+    options.outputDir = config_.hls.outputDir;
+    options.blockTimeoutMs = 3 * config_.hls.segmentDuration * 1000;
 
-    if (ffmpegCtx_->avformat_write_header(outputFormatCtx_.get(), nullptr) < 0) {
-        Logger::error("Failed to write output header");
+    httpOrigin_ = std::make_unique<HttpOrigin>(options, segmentStore_.get(), llhlsWriter_.get());
+    if (!httpOrigin_->start()) {
+        Logger::error("Failed to start HTTP origin on port " + std::to_string(config_.hls.httpPort));
+        httpOrigin_.reset();
         return false;
     }
-
-    Logger::info("HLS output configured successfully");
     return true;
 }
 
 bool FFmpegWrapper::resetOutput() {
     Logger::info("Resetting output: Closing and recreating HLS muxer");
 
+    closeOutput();
+
+    if (!setupOutput()) {
+        Logger::error("Failed to recreate HLS output");
+        return false;
+    }
+
+    Logger::info("Output muxer reset complete");
+    return true;
+}
+
+void FFmpegWrapper::closeOutput() {
+    // No trailer: the next muxer appends to the playlist after a discontinuity
     if (outputFormatCtx_) {
+        if (llhlsWriter_) {
+            // Publishes the open segment and takes its AVIO back (continues after a discontinuity)
+            llhlsWriter_->detach();
+        }
         if (outputFormatCtx_->pb && !(outputFormatCtx_->oformat->flags & AVFMT_NOFILE)) {
             ffmpegCtx_->avio_closep(&outputFormatCtx_->pb);
             Logger::info("Closed output file");
         }
         outputFormatCtx_.reset();
         Logger::info("Freed output format context");
+        if (segmentWriter_) {
+            segmentWriter_->detach();
+        }
     }
 
     reload_count_++;
     Logger::info("Starting Part " + std::to_string(reload_count_));
 
+    resetPipelines();
+
+    outputVideoStreamIndex_ = -1;
+    outputAudioStreamIndex_ = -1;
+    outputVideoStreamIndices_.clear();
+}
+
+void FFmpegWrapper::resetPipelines() {
     // Reset video pipeline (SwsContext, encoder, decoder)
     videoPipeline_->reset();
     Logger::info("Reset video pipeline");
@@ -430,31 +761,191 @@ bool FFmpegWrapper::resetOutput() {
     audioPipeline_->reset();
     Logger::info("Reset audio pipeline");
 
-    outputVideoStreamIndex_ = -1;
-    outputAudioStreamIndex_ = -1;
+    extraVideoPipelines_.clear();
+}
 
-    if (!setupOutput()) {
-        Logger::error("Failed to recreate HLS output");
+bool FFmpegWrapper::resumeOutput() {
+    // The muxer has written its header: re-running the stream setup must not change its time bases
+    std::vector<AVStream*> outVideoStreams;
+    std::vector<AVRational> timeBases;
+    for (int index : outputVideoStreamIndices_) {
+        outVideoStreams.push_back(outputFormatCtx_->streams[index]);
+    }
+    AVStream* outAudioStream = outputAudioStreamIndex_ >= 0 ? outputFormatCtx_->streams[outputAudioStreamIndex_] : nullptr;
+    for (unsigned int i = 0; i < outputFormatCtx_->nb_streams; i++) {
+        timeBases.push_back(outputFormatCtx_->streams[i]->time_base);
+    }
+
+    if (!configureOutputStreams(outVideoStreams, outAudioStream)) {
         return false;
     }
 
-    Logger::info("Output muxer reset complete");
+    for (unsigned int i = 0; i < outputFormatCtx_->nb_streams; i++) {
+        outputFormatCtx_->streams[i]->time_base = timeBases[i];
+    }
+    return true;
+}
+
+bool FFmpegWrapper::sameStreams(StreamInput& next) const {
+    // The running muxer (and an fMP4 init segment) describes the current output codecs
+    AVFormatContext* nextCtx = next.getFormatContext();
+    const int nextVideo = next.getVideoStreamIndex();
+    const int nextAudio = next.getAudioStreamIndex();
+    if (!outputFormatCtx_ || !inputFormatCtx_ || !nextCtx || nextVideo < 0 ||
+        (audioStreamIndex_ >= 0) != (nextAudio >= 0)) {
+        return false;
+    }
+
+    const AVCodecParameters* video = inputFormatCtx_->streams[videoStreamIndex_]->codecpar;
+    const AVCodecParameters* nextVideoPar = nextCtx->streams[nextVideo]->codecpar;
+    if (video->codec_id != nextVideoPar->codec_id || video->profile != nextVideoPar->profile ||
+        video->width != nextVideoPar->width || video->height != nextVideoPar->height ||
+        video->format != nextVideoPar->format) {
+        return false;
+    }
+
+    if (audioStreamIndex_ >= 0) {
+        const AVCodecParameters* audio = inputFormatCtx_->streams[audioStreamIndex_]->codecpar;
+        const AVCodecParameters* nextAudioPar = nextCtx->streams[nextAudio]->codecpar;
+        if (audio->codec_id != nextAudioPar->codec_id || audio->sample_rate != nextAudioPar->sample_rate ||
+            audio->ch_layout.nb_channels != nextAudioPar->ch_layout.nb_channels) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FFmpegWrapper::inputLost() const {
+    // A live FFmpeg input that ended without Ctrl+C dropped out (files just end,
+    // programmatic inputs end the stream themselves)
+    return streamInput_ && streamInput_->isLiveStream() && !streamInput_->isProgrammatic() &&
+           !(interruptCallback_ && interruptCallback_());
+}
+
+void FFmpegWrapper::startStandby(const std::string& uri) {
+    standby_ = std::make_unique<InputStandby>(uri, config_, ffmpegCtx_);
+}
+
+bool FFmpegWrapper::recoverInput() {
+    const std::string lostUri = input_uri_;
+    Logger::warn("Input lost: " + lostUri + " - reconnecting");
+    auto outageStart = std::chrono::steady_clock::now();
+
+    std::unique_ptr<StreamInput> next;
+    std::string nextUri;
+    int backoffMs = RECONNECT_INITIAL_BACKOFF_MS;
+    for (int attempt = 1; !next; attempt++) {
+        if (interruptCallback_ && interruptCallback_()) {
+            return false;
+        }
+
+        // Hot standby first: already connected and probed
+        if (standby_) {
+            next = standby_->take();
+            if (next) {
+                nextUri = standby_->getUri();
+                standby_.reset();
+                Logger::info("Failing over to standby input: " + nextUri);
+                break;
+            }
+        }
+
+        // Cold reconnect of the lost input (a standby keeps retrying the other one)
+        next = StreamInputFactory::create(lostUri, config_, ffmpegCtx_);
+        if (next && next->open(lostUri)) {
+            nextUri = lostUri;
+            break;
+        }
+        next.reset();
+
+        Logger::warn("Reconnect attempt " + std::to_string(attempt) + " failed, retrying in " +
+                     std::to_string(backoffMs) + " ms");
+        for (int waitedMs = 0; waitedMs < backoffMs; waitedMs += RECONNECT_POLL_MS) {
+            if ((interruptCallback_ && interruptCallback_()) || (standby_ && standby_->isReady())) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(RECONNECT_POLL_MS));
+        }
+        backoffMs = std::min(backoffMs * 2, RECONNECT_MAX_BACKOFF_MS);
+    }
+
+    // TRANSCODE with the same codecs: the new encoders start with an IDR on the continued
+    // timeline (the decoder waits for the input's first keyframe), so the muxer keeps running.
+    // Copied (REMUX) packets would join mid-GOP inside the open segment: a new muxer starts
+    // a new part at the input's first keyframe and the playlist continues after a discontinuity
+    const bool transcoding = processingMode_ == ProcessingMode::TRANSCODE;
+    const bool keepMuxer = transcoding && sameStreams(*next);
+    if (keepMuxer) {
+        resetPipelines();
+    } else {
+        Logger::info(transcoding ? "Input codecs changed, rebuilding the output muxer"
+                                 : "Rebuilding the output muxer for the new input (stream copy)");
+        closeOutput();
+    }
+    streamInput_ = std::move(next);
+    input_uri_ = nextUri;
+    inputTimeline_->rebase();
+    if (!analyzeInput() || !(keepMuxer ? resumeOutput() : setupOutput())) {
+        Logger::error("Failed to resume output on input: " + nextUri);
+        return false;
+    }
+
+    double outageMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - outageStart).count();
+    Logger::info("Input restored after " + std::to_string(static_cast<int>(outageMs)) + " ms: " + nextUri +
+                 (keepMuxer ? " (output muxer kept running)"
+                            : " (new muxer, part " + std::to_string(reload_count_) + ")"));
+
+    // The input that just failed becomes the standby
+    if (!config_.hls.backupInput.empty() && !standby_) {
+        startStandby(nextUri == config_.hls.inputFile ? config_.hls.backupInput : config_.hls.inputFile);
+    }
     return true;
 }
 
 bool FFmpegWrapper::processVideo() {
+    if (chunkedVod_ && inputFormatCtx_) {
+        return processVideoChunked();
+    }
+
     if (!inputFormatCtx_ || !outputFormatCtx_) {
         Logger::error("Input or output not initialized");
         return false;
     }
 
-    if (processingMode_ == ProcessingMode::REMUX) {
-        return processVideoRemux();
-    } else if (processingMode_ == ProcessingMode::PROGRAMMATIC) {
-        return processVideoProgrammatic();
-    } else {
-        return processVideoTranscode();
+    bool success;
+    while (true) {
+        if (processingMode_ == ProcessingMode::REMUX) {
+            success = processVideoRemux();
+        } else if (processingMode_ == ProcessingMode::PROGRAMMATIC) {
+            success = processVideoProgrammatic();
+        } else {
+            success = processVideoTranscode();
+        }
+
+        // A live input dropped out: reconnect or fail over in-process and keep going
+        if (!success || !inputLost()) {
+            break;
+        }
+        if (!recoverInput()) {
+            // Ctrl+C during the outage: finish the output that is still open
+            bool interrupted = interruptCallback_ && interruptCallback_();
+            if (interrupted && outputFormatCtx_) {
+                ffmpegCtx_->av_write_trailer(outputFormatCtx_.get());
+                if (llhlsWriter_) {
+                    llhlsWriter_->finish();
+                }
+            } else {
+                success = false;
+            }
+            break;
+        }
+    }
+
+    // Segments and the final playlist are only complete once the I/O thread has written them
+    if (segmentWriter_) {
+        segmentWriter_->stop();
     }
+    return success;
 }
 
 bool FFmpegWrapper::processVideoRemux() {
@@ -475,12 +966,26 @@ bool FFmpegWrapper::processVideoRemux() {
             break;
         }
 
-        if (packet->stream_index == videoStreamIndex_) {
+        const bool video = packet->stream_index == videoStreamIndex_;
+        if ((video || (audioStreamIndex_ >= 0 && packet->stream_index == audioStreamIndex_)) &&
+            !inputTimeline_->onPacket(packet, inputFormatCtx_->streams[packet->stream_index]->time_base, video)) {
+            ffmpegCtx_->av_packet_unref(packet);
+            continue;
+        }
+
+        if (video) {
             videoPacketCount++;
 
             if (videoPacketCount % PACKET_LOG_INTERVAL == 0) {
                 Logger::debug("Processed " + std::to_string(videoPacketCount) + " video packets, " +
                              std::to_string(audioPacketCount) + " audio packets");
+                if (segmentWriter_) {
+                    segmentWriter_->logStats();
+                }
+            }
+
+            if (llhlsWriter_) {
+                llhlsWriter_->onVideoPacket(packet, inputFormatCtx_->streams[videoStreamIndex_]->time_base);
             }
 
             // Process video packet via VideoPipeline
@@ -512,7 +1017,18 @@ bool FFmpegWrapper::processVideoRemux() {
         inputFormatCtx_->streams[videoStreamIndex_]->time_base,
         outputFormatCtx_->streams[outputVideoStreamIndex_]->time_base);
 
-    ffmpegCtx_->av_write_trailer(outputFormatCtx_.get());
+    // Drain transcoded audio (no-op when audio is copied)
+    if (outputAudioStreamIndex_ >= 0) {
+        audioPipeline_->flush(outputFormatCtx_.get(), outputAudioStreamIndex_);
+    }
+
+    // On an input outage the muxer stays open: processVideo() reconnects and continues the playlist
+    if (!inputLost()) {
+        ffmpegCtx_->av_write_trailer(outputFormatCtx_.get());
+        if (llhlsWriter_) {
+            llhlsWriter_->finish();
+        }
+    }
 
     Logger::info("Processed " + std::to_string(videoPacketCount) + " video packets, " +
                  std::to_string(audioPacketCount) + " audio packets total");
@@ -532,8 +1048,6 @@ bool FFmpegWrapper::processVideoProgrammatic() {
     }
 
     int packetCount = 0;
-    int emptyIterations = 0;
-    // Use constant instead of local variable
 
     while (true) {
         if (interruptCallback_ && interruptCallback_()) {
@@ -548,31 +1062,27 @@ bool FFmpegWrapper::processVideoProgrammatic() {
             break;
         }
 
+        // Programmatic inputs block in readPacket() until their next packet is due
+        // and return an empty one when woken without output (or to let us poll the
+        // interrupt flag); they end the stream by returning false
         if (packet->size <= 0) {
-            emptyIterations++;
-
-            if (!streamInput_->isLiveStream() && emptyIterations >= MAX_EMPTY_READ_ATTEMPTS) {
-                if (packetCount == 0) {
-                    Logger::error("No packets received after waiting");
-                    ffmpegCtx_->av_packet_free(&packet);
-                    return false;
-                } else {
-                    Logger::info("No more packets available, ending stream");
-                    break;
-                }
-            }
-
             continue;
         }
 
-        emptyIterations = 0;
         packetCount++;
 
         if (packetCount % PACKET_LOG_INTERVAL == 0) {
             Logger::info("Processed " + std::to_string(packetCount) + " packets");
+            if (segmentWriter_) {
+                segmentWriter_->logStats();
+            }
         }
 
         if (packet->stream_index == outputVideoStreamIndex_) {
+            if (llhlsWriter_) {
+                llhlsWriter_->onVideoPacket(packet, inputFormatCtx_->streams[videoStreamIndex_]->time_base);
+            }
+
             // Process video packet via VideoPipeline
             videoPipeline_->processBitstreamFilter(
                 packet,
@@ -601,6 +1111,9 @@ bool FFmpegWrapper::processVideoProgrammatic() {
         outputFormatCtx_->streams[outputVideoStreamIndex_]->time_base);
 
     ffmpegCtx_->av_write_trailer(outputFormatCtx_.get());
+    if (llhlsWriter_) {
+        llhlsWriter_->finish();
+    }
 
     Logger::info("Processed " + std::to_string(packetCount) + " packets total from programmatic input");
 
@@ -613,119 +1126,65 @@ bool FFmpegWrapper::processVideoTranscode() {
     Logger::info("Processing video: TRANSCODE mode (decoding and re-encoding to H.264)");
     Logger::info("This may take longer but ensures HLS compatibility");
 
-    AVPacket* packet = ffmpegCtx_->av_packet_alloc();
-    AVFrame* frame = ffmpegCtx_->av_frame_alloc();
-
-    if (!packet || !frame) {
-        Logger::error("Failed to allocate packet or frame");
-        if (packet) ffmpegCtx_->av_packet_free(&packet);
-        if (frame) ffmpegCtx_->av_frame_free(&frame);
-        return false;
+    // Decode once; scale + encode each rendition on its own threads
+    std::vector<StagedTranscoder::Rendition> renditions;
+    for (size_t i = 0; i < outputVideoStreamIndices_.size(); i++) {
+        StagedTranscoder::Rendition rendition;
+        rendition.pipeline = getRenditionPipeline(i);
+        rendition.outputStreamIndex = outputVideoStreamIndices_[i];
+        renditions.push_back(rendition);
     }
 
-    int frameCount = 0;
-    int64_t nextPts = 0;
-
-    while (ffmpegCtx_->av_read_frame(inputFormatCtx_, packet) >= 0) {
-        if (interruptCallback_ && interruptCallback_()) {
-            Logger::info("Processing interrupted by user (Ctrl+C)");
-            break;
-        }
-
-        // Process video packets - transcode
-        if (packet->stream_index == videoStreamIndex_) {
-            // Decode packet using VideoPipeline's decoder
-            AVCodecContext* decoderCtx = videoPipeline_->getInputCodecContext();
-            if (ffmpegCtx_->avcodec_send_packet(decoderCtx, packet) < 0) {
-                Logger::error("Error sending packet to decoder");
-                ffmpegCtx_->av_packet_unref(packet);
-                continue;
-            }
-
-            while (ffmpegCtx_->avcodec_receive_frame(decoderCtx, frame) == 0) {
-                frameCount++;
-
-                if (frameCount % FRAME_LOG_INTERVAL == 0) {
-                    Logger::info("Transcoded " + std::to_string(frameCount) + " frames");
-                }
-
-                // Convert and encode frame via VideoPipeline
-                if (!videoPipeline_->convertAndEncodeFrame(frame, nextPts++)) {
-                    ffmpegCtx_->av_frame_unref(frame);
-                    continue;
-                }
-
-                // Receive encoded packets from VideoPipeline's encoder
-                AVCodecContext* encoderCtx = videoPipeline_->getOutputCodecContext();
-                AVPacket* outPacket = ffmpegCtx_->av_packet_alloc();
-                while (ffmpegCtx_->avcodec_receive_packet(encoderCtx, outPacket) == 0) {
-                    // Process encoded packet via VideoPipeline's bitstream filter
-                    videoPipeline_->processBitstreamFilter(
-                        outPacket,
-                        outputFormatCtx_.get(),
-                        outputVideoStreamIndex_,
-                        encoderCtx->time_base,
-                        outputFormatCtx_->streams[outputVideoStreamIndex_]->time_base);
-
-                    ffmpegCtx_->av_packet_unref(outPacket);
-                }
-                ffmpegCtx_->av_packet_free(&outPacket);
-
-                ffmpegCtx_->av_frame_unref(frame);
-            }
-        }
-        // Process audio packets via AudioPipeline
-        else if (packet->stream_index == audioStreamIndex_ && outputAudioStreamIndex_ >= 0) {
-            audioPipeline_->processPacket(packet, inputFormatCtx_, outputFormatCtx_.get(),
-                                          audioStreamIndex_, outputAudioStreamIndex_);
-        }
-
-        ffmpegCtx_->av_packet_unref(packet);
+    StagedTranscoder transcoder(ffmpegCtx_, *videoPipeline_, renditions, *audioPipeline_);
+    if (segmentWriter_) {
+        SegmentWriter* writer = segmentWriter_.get();
+        transcoder.setProgressCallback([writer]() { writer->logStats(); });
     }
 
-    // Drain decoder (flush remaining frames) via VideoPipeline
-    AVCodecContext* decoderCtx = videoPipeline_->getInputCodecContext();
-    AVCodecContext* encoderCtx = videoPipeline_->getOutputCodecContext();
-
-    ffmpegCtx_->avcodec_send_packet(decoderCtx, nullptr);
-    while (ffmpegCtx_->avcodec_receive_frame(decoderCtx, frame) == 0) {
-        // Convert and encode flushed frame via VideoPipeline
-        if (!videoPipeline_->convertAndEncodeFrame(frame, nextPts++)) {
-            ffmpegCtx_->av_frame_unref(frame);
-            continue;
-        }
-
-        AVPacket* outPacket = ffmpegCtx_->av_packet_alloc();
-        while (ffmpegCtx_->avcodec_receive_packet(encoderCtx, outPacket) == 0) {
-            // Process encoded packet via VideoPipeline's bitstream filter
-            videoPipeline_->processBitstreamFilter(
-                outPacket,
-                outputFormatCtx_.get(),
-                outputVideoStreamIndex_,
-                encoderCtx->time_base,
-                outputFormatCtx_->streams[outputVideoStreamIndex_]->time_base);
-
-            ffmpegCtx_->av_packet_unref(outPacket);
-        }
-        ffmpegCtx_->av_packet_free(&outPacket);
-
-        ffmpegCtx_->av_frame_unref(frame);
+    StagedTranscoder::Streams streams;
+    streams.inputFormatCtx = inputFormatCtx_;
+    streams.outputFormatCtx = outputFormatCtx_.get();
+    streams.videoStreamIndex = videoStreamIndex_;
+    streams.audioStreamIndex = audioStreamIndex_;
+    streams.outputAudioStreamIndex = outputAudioStreamIndex_;
+    streams.timeline = inputTimeline_.get();
+    streams.firstVideoPts = transcodedFrames_;
+
+    bool ran = transcoder.run(streams, interruptCallback_);
+    transcodedFrames_ += transcoder.getFrameCount();
+    if (!ran) {
+        return false;
     }
 
-    // Flush encoder via VideoPipeline
-    videoPipeline_->flushEncoder(outputFormatCtx_.get(), outputVideoStreamIndex_);
-
-    // Flush audio decoder and encoder via AudioPipeline
-    if (outputAudioStreamIndex_ >= 0) {
-        audioPipeline_->flush(outputFormatCtx_.get(), outputAudioStreamIndex_);
+    if (!inputLost()) {
+        ffmpegCtx_->av_write_trailer(outputFormatCtx_.get());
     }
 
-    ffmpegCtx_->av_write_trailer(outputFormatCtx_.get());
+    Logger::info("Transcoded " + std::to_string(transcoder.getFrameCount()) + " frames total");
 
-    Logger::info("Transcoded " + std::to_string(frameCount) + " frames total");
+    return true;
+}
 
-    ffmpegCtx_->av_packet_free(&packet);
-    ffmpegCtx_->av_frame_free(&frame);
+bool FFmpegWrapper::processVideoChunked() {
+    Logger::info("Processing video: TRANSCODE mode, parallel segment-aligned chunks (VOD)");
 
-    return true;
+    const RenditionConfig rendition = getRenditions().front();
+    AVStream* videoStream = inputFormatCtx_->streams[videoStreamIndex_];
+
+    ChunkedTranscoder::Options options;
+    options.inputUri = input_uri_;
+    options.outputDir = config_.hls.outputDir;
+    options.segmentPrefix = "part" + std::to_string(reload_count_) + "_segment";
+    options.startSec = videoStream->start_time != AV_NOPTS_VALUE
+        ? static_cast<double>(videoStream->start_time) * videoStream->time_base.num / videoStream->time_base.den
+        : 0.0;
+    options.durationSec = duration_;
+    options.workers = getChunkWorkers();
+    options.config = config_;
+    options.config.video.width = rendition.width;
+    options.config.video.height = rendition.height;
+    options.config.video.bitrate = rendition.bitrate;
+
+    ChunkedTranscoder transcoder(ffmpegCtx_, options);
+    return transcoder.run(interruptCallback_);
 }
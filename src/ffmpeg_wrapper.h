@@ -1,16 +1,25 @@
 #ifndef FFMPEG_WRAPPER_H
 #define FFMPEG_WRAPPER_H
 
+#include <chrono>
 #include <string>
 #include <memory>
 #include <functional>
+#include <vector>
 #include "config.h"
 #include "ffmpeg_deleters.h"
+#include "thread_budget.h"
 
 class StreamInput;
+class InputStandby;
 class FFmpegContext;
 class VideoPipeline;
 class AudioPipeline;
+class LLHLSWriter;
+class SegmentWriter;
+class SegmentStore;
+class HttpOrigin;
+class InputTimeline;
 
 struct AVFormatContext;
 struct AVCodecContext;
@@ -47,17 +56,26 @@ private:
     std::shared_ptr<FFmpegContext> ffmpegCtx_;
 
     // Specialized pipelines
-    std::unique_ptr<VideoPipeline> videoPipeline_;
+    std::unique_ptr<VideoPipeline> videoPipeline_;  // Decoder + first rendition
     std::unique_ptr<AudioPipeline> audioPipeline_;
+    std::vector<std::unique_ptr<VideoPipeline>> extraVideoPipelines_;  // Renditions 2..N (TRANSCODE ladder)
 
     std::unique_ptr<StreamInput> streamInput_;
+    std::unique_ptr<InputStandby> standby_;  // Hot standby of the other live input (--backup)
+    std::unique_ptr<InputTimeline> inputTimeline_;  // Continues input timestamps across failovers
+    int64_t transcodedFrames_ = 0;                  // TRANSCODE video PTS of the next input's first frame
     AVFormatContext* inputFormatCtx_ = nullptr;
     int videoStreamIndex_ = -1;
     int audioStreamIndex_ = -1;
 
+    std::unique_ptr<SegmentStore> segmentStore_;    // In-memory published files for the HTTP origin
+    std::unique_ptr<SegmentWriter> segmentWriter_;  // Write-behind file I/O (declared first: outlives the muxer)
     std::unique_ptr<AVFormatContext, AVFormatContextDeleter> outputFormatCtx_;
-    int outputVideoStreamIndex_ = -1;
+    int outputVideoStreamIndex_ = -1;  // First rendition
     int outputAudioStreamIndex_ = -1;
+    std::vector<int> outputVideoStreamIndices_;  // One per rendition
+    std::unique_ptr<LLHLSWriter> llhlsWriter_;   // LL-HLS playlist/parts (mpegts output), survives resetOutput()
+    std::unique_ptr<HttpOrigin> httpOrigin_;     // Declared after the store/writers: stops serving before they go away
 
     enum class ProcessingMode {
         REMUX,
@@ -65,6 +83,7 @@ private:
         PROGRAMMATIC
     };
     ProcessingMode processingMode_ = ProcessingMode::REMUX;
+    bool chunkedVod_ = false;  // TRANSCODE of a file as parallel chunks (ChunkedTranscoder, no hls muxer)
 
     int width_ = 0;
     int height_ = 0;
@@ -74,13 +93,30 @@ private:
     const AppConfig config_;  // Immutable configuration
     int reload_count_ = 0;
     std::string input_uri_;
+    std::chrono::steady_clock::time_point openStart_;  // openInput() began (time to first segment)
 
     std::function<bool()> interruptCallback_;
 
+    bool analyzeInput();
     bool openInputCodec();
+    void closeOutput();
+    void resetPipelines();
+    bool configureOutputStreams(const std::vector<AVStream*>& outVideoStreams, AVStream* outAudioStream);
+    bool resumeOutput();
+    bool sameStreams(StreamInput& next) const;
+    bool inputLost() const;
+    bool recoverInput();
+    void startStandby(const std::string& uri);
     bool detectAndDecideProcessingMode();
+    std::vector<RenditionConfig> getRenditions() const;
+    ThreadBudget::Plan getThreadPlan() const;
+    int getChunkWorkers() const;
+    bool useChunkedTranscode() const;
+    VideoPipeline* getRenditionPipeline(size_t index);
+    bool startHttpOrigin();
     bool processVideoRemux();
     bool processVideoTranscode();
+    bool processVideoChunked();
     bool processVideoProgrammatic();
 };
 
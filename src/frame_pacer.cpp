@@ -0,0 +1,62 @@
+#include "frame_pacer.h"
+
+#include <algorithm>
+
+void FramePacer::start(int fps) {
+    fps_ = fps > 0 ? fps : 30;
+    start_ = Clock::now();
+    started_ = true;
+    stats_ = Stats();
+    jitterSumMs_ = 0.0;
+}
+
+FramePacer::Clock::time_point FramePacer::deadline(int64_t frameIndex) const {
+    if (!started_) {
+        return Clock::time_point::max();
+    }
+    // Exact rational position (no accumulated rounding): N * 1e9 / fps nanoseconds
+    auto offset = std::chrono::nanoseconds(frameIndex * 1000000000LL / fps_);
+    return start_ + std::chrono::duration_cast<Clock::duration>(offset);
+}
+
+int64_t FramePacer::framesDue() const {
+    if (!started_) {
+        return 0;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_).count();
+    return elapsed * fps_ / 1000000000LL + 1;
+}
+
+void FramePacer::waitUntil(Clock::time_point until) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait_until(lock, until, [this]() { return woken_; });
+    woken_ = false;
+}
+
+void FramePacer::wake() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        woken_ = true;
+    }
+    cond_.notify_one();
+}
+
+void FramePacer::recordFrame(int64_t frameIndex) {
+    if (!started_) {
+        return;
+    }
+    double lateMs = std::chrono::duration<double, std::milli>(Clock::now() - deadline(frameIndex)).count();
+    lateMs = std::max(lateMs, 0.0);
+
+    stats_.frames++;
+    jitterSumMs_ += lateMs;
+    stats_.maxJitterMs = std::max(stats_.maxJitterMs, lateMs);
+}
+
+FramePacer::Stats FramePacer::takeStats() {
+    Stats stats = stats_;
+    stats.averageJitterMs = stats.frames > 0 ? jitterSumMs_ / stats.frames : 0.0;
+    stats_ = Stats();
+    jitterSumMs_ = 0.0;
+    return stats;
+}
@@ -0,0 +1,103 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * FramePacer - Monotonic frame clock for generated (browser) video
+ *
+ * Frame N is due at start + N / fps on std::chrono::steady_clock, so wall
+ * clock jumps (NTP, DST, manual changes) never stall or burst the output and
+ * rounding never accumulates. The encode thread sleeps on a condition variable
+ * until the next deadline, or until another thread calls wake() because it has
+ * work for it (a painted frame, audio, browser events).
+ *
+ * Pacing jitter is how late each frame was actually produced relative to its
+ * deadline; takeStats() reports it per logging interval.
+ *
+ * Usage:
+ *   pacer.start(fps);                          // at the first frame
+ *   if (pacer.framesDue() > frameCount) { encode; pacer.recordFrame(frameCount++); }
+ *   else pacer.waitUntil(pacer.deadline(frameCount));
+ *
+ * Thread-safety: wake() from any thread; everything else on the encode thread
+ */
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        int64_t frames = 0;
+        double averageJitterMs = 0.0;  // Mean lateness against the frame deadline
+        double maxJitterMs = 0.0;
+    };
+
+    /**
+     * Start the clock: frame 0 is due now
+     * @param fps Frame rate
+     */
+    void start(int fps);
+
+    /**
+     * Stop the clock (start() again begins a new timeline at frame 0)
+     */
+    void stop() { started_ = false; }
+
+    bool isStarted() const { return started_; }
+
+    /**
+     * Time of frame 0 (media time 0 of the current timeline)
+     */
+    Clock::time_point origin() const { return start_; }
+
+    /**
+     * Deadline of a frame (time_point::max() if not started)
+     * @param frameIndex Frame number since start()
+     */
+    Clock::time_point deadline(int64_t frameIndex) const;
+
+    /**
+     * Number of frames whose deadline has passed (including frame 0), 0 if not started
+     */
+    int64_t framesDue() const;
+
+    /**
+     * Block until a time point or until wake() is called
+     * A wake() since the last wait returns immediately
+     * @param until Latest time to return
+     */
+    void waitUntil(Clock::time_point until);
+
+    /**
+     * Interrupt waitUntil() (e.g. new frame or audio available)
+     */
+    void wake();
+
+    /**
+     * Record that a frame was produced now (for the jitter statistics)
+     * @param frameIndex Frame number since start()
+     */
+    void recordFrame(int64_t frameIndex);
+
+    /**
+     * Statistics since the last call (resets them)
+     */
+    Stats takeStats();
+
+private:
+    bool started_ = false;
+    int fps_ = 30;
+    Clock::time_point start_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool woken_ = false;
+
+    Stats stats_;
+    double jitterSumMs_ = 0.0;
+};
+
+#endif // FRAME_PACER_H
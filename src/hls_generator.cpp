@@ -20,7 +20,7 @@ bool HLSGenerator::initialize(const std::string& ffmpegLibPath) {
         return false;
     }
 
-    // STEP 2: Open input on main thread (CEF requires main thread)
+    // STEP 2: Open input (browser sources attach to the shared CEF runtime)
     if (!ffmpegWrapper_->openInput(config_.hls.inputFile)) {
         Logger::error("Failed to open input file");
         return false;
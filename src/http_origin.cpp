@@ -0,0 +1,568 @@
+#include "http_origin.h"
+#include "segment_store.h"
+#include "llhls_writer.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+
+#ifndef PLATFORM_WINDOWS
+#include <arpa/inet.h>
+#include <csignal>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+#endif
+
+namespace {
+    constexpr int POLL_INTERVAL_MS = 250;             // Re-check running_ while waiting for input
+    constexpr int KEEP_ALIVE_TIMEOUT_MS = 30000;      // Close idle connections
+    constexpr size_t MAX_HEADER_BYTES = 16 * 1024;
+    constexpr int SEND_TIMEOUT_SEC = 10;              // Give up on clients that stop reading
+    constexpr int LISTEN_BACKLOG = 64;
+    constexpr size_t FILE_CHUNK_BYTES = 64 * 1024;    // read()/send() fallback without sendfile
+
+#ifdef MSG_NOSIGNAL
+    constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+    constexpr int SEND_FLAGS = 0;
+#endif
+
+    bool endsWith(const std::string& value, const std::string& suffix) {
+        return value.size() >= suffix.size() &&
+               value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    std::string contentTypeFor(const std::string& name) {
+        if (endsWith(name, ".m3u8")) return "application/vnd.apple.mpegurl";
+        if (endsWith(name, ".ts")) return "video/mp2t";
+        if (endsWith(name, ".m4s")) return "video/iso.segment";
+        if (endsWith(name, ".mp4")) return "video/mp4";
+        return "application/octet-stream";
+    }
+
+    // Resolve a single "bytes=" range against the file size
+    bool resolveRange(const std::string& header, int64_t size, int64_t& first, int64_t& last) {
+        const std::string prefix = "bytes=";
+        if (header.compare(0, prefix.size(), prefix) != 0 || header.find(',') != std::string::npos) {
+            return false;
+        }
+
+        std::string spec = header.substr(prefix.size());
+        size_t dash = spec.find('-');
+        if (dash == std::string::npos) {
+            return false;
+        }
+
+        std::string from = spec.substr(0, dash);
+        std::string to = spec.substr(dash + 1);
+        if (from.empty()) {
+            // Suffix range: last N bytes
+            int64_t count = std::atoll(to.c_str());
+            if (count <= 0) {
+                return false;
+            }
+            first = std::max<int64_t>(0, size - count);
+            last = size - 1;
+        } else {
+            first = std::atoll(from.c_str());
+            last = to.empty() ? size - 1 : std::min<int64_t>(std::atoll(to.c_str()), size - 1);
+        }
+        return first >= 0 && first <= last && first < size;
+    }
+}
+
+struct HttpOrigin::Request {
+    std::string method;
+    std::string name;                            // Requested file (path without leading '/')
+    std::map<std::string, std::string> query;
+    std::map<std::string, std::string> headers;  // Lowercase names
+    bool keepAlive = true;
+
+    bool isHead() const { return method == "HEAD"; }
+
+    std::string header(const std::string& key) const {
+        auto it = headers.find(key);
+        return it != headers.end() ? it->second : std::string();
+    }
+};
+
+HttpOrigin::HttpOrigin(const Options& options, SegmentStore* store, LLHLSWriter* llhls)
+    : options_(options), store_(store), llhls_(llhls) {
+}
+
+HttpOrigin::~HttpOrigin() {
+    stop();
+}
+
+#ifdef PLATFORM_WINDOWS
+
+bool HttpOrigin::start() {
+    Logger::error("The embedded HTTP origin is not available on Windows");
+    return false;
+}
+
+void HttpOrigin::stop() {}
+void HttpOrigin::acceptLoop() {}
+void HttpOrigin::handleConnection(Connection*) {}
+bool HttpOrigin::readRequest(int, std::string&, Request&) { return false; }
+bool HttpOrigin::handleRequest(int, const Request&) { return false; }
+bool HttpOrigin::sendMemory(int, const Request&, const std::string&, const uint8_t*, size_t) { return false; }
+bool HttpOrigin::sendDiskFile(int, const Request&, const std::string&) { return false; }
+bool HttpOrigin::sendStatus(int, const Request&, int, const std::string&) { return false; }
+void HttpOrigin::reapConnections() {}
+size_t HttpOrigin::openConnections() { return 0; }
+
+#else
+
+namespace {
+    bool sendAll(int fd, const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t sent = ::send(fd, data, size, SEND_FLAGS);
+            if (sent <= 0) {
+                return false;
+            }
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    // Headers and body in one syscall where possible, without copying the body
+    bool sendVectored(int fd, const std::string& headers, const uint8_t* body, size_t bodySize) {
+        size_t headerSent = 0;
+        size_t bodySent = 0;
+
+        while (headerSent < headers.size() || bodySent < bodySize) {
+            iovec iov[2];
+            int count = 0;
+            if (headerSent < headers.size()) {
+                iov[count].iov_base = const_cast<char*>(headers.data() + headerSent);
+                iov[count].iov_len = headers.size() - headerSent;
+                count++;
+            }
+            if (bodySent < bodySize) {
+                iov[count].iov_base = const_cast<uint8_t*>(body + bodySent);
+                iov[count].iov_len = bodySize - bodySent;
+                count++;
+            }
+
+            msghdr message{};
+            message.msg_iov = iov;
+            message.msg_iovlen = count;
+            ssize_t sent = ::sendmsg(fd, &message, SEND_FLAGS);
+            if (sent <= 0) {
+                return false;
+            }
+
+            size_t remaining = static_cast<size_t>(sent);
+            size_t headerPart = std::min(remaining, headers.size() - headerSent);
+            headerSent += headerPart;
+            bodySent += remaining - headerPart;
+        }
+        return true;
+    }
+
+    std::string buildHeaders(int status, const std::string& reason, const std::string& contentType,
+                             int64_t contentLength, int64_t rangeFirst, int64_t rangeLast, int64_t totalSize,
+                             bool keepAlive) {
+        std::ostringstream out;
+        out << "HTTP/1.1 " << status << " " << reason << "\r\n";
+        out << "Content-Type: " << contentType << "\r\n";
+        out << "Content-Length: " << contentLength << "\r\n";
+        if (status == 206) {
+            out << "Content-Range: bytes " << rangeFirst << "-" << rangeLast << "/" << totalSize << "\r\n";
+        }
+        out << "Accept-Ranges: bytes\r\n";
+        // Playlists change every part/segment; media files never change once listed
+        out << "Cache-Control: " << (endsWith(contentType, "mpegurl") ? "no-cache" : "max-age=60") << "\r\n";
+        out << "Access-Control-Allow-Origin: *\r\n";
+        out << "Connection: " << (keepAlive ? "keep-alive" : "close") << "\r\n";
+        out << "\r\n";
+        return out.str();
+    }
+}
+
+bool HttpOrigin::start() {
+    if (running_) {
+        return true;
+    }
+
+    // A client closing its connection mid-response must not kill the process
+    std::signal(SIGPIPE, SIG_IGN);
+
+    listenFd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd_ < 0) {
+        Logger::error("HTTP origin: failed to create socket");
+        return false;
+    }
+
+    int reuse = 1;
+    ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(options_.port));
+    if (::inet_pton(AF_INET, options_.bindAddress.c_str(), &address.sin_addr) != 1) {
+        Logger::error("HTTP origin: invalid bind address " + options_.bindAddress);
+        ::close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+
+    if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        ::listen(listenFd_, LISTEN_BACKLOG) < 0) {
+        Logger::error("HTTP origin: cannot listen on " + options_.bindAddress + ":" + std::to_string(options_.port));
+        ::close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+
+    running_ = true;
+    acceptThread_ = std::thread(&HttpOrigin::acceptLoop, this);
+
+    Logger::info("HTTP origin listening on http://" + options_.bindAddress + ":" + std::to_string(options_.port) + "/");
+    return true;
+}
+
+void HttpOrigin::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    ::shutdown(listenFd_, SHUT_RDWR);
+    if (acceptThread_.joinable()) {
+        acceptThread_.join();
+    }
+    ::close(listenFd_);
+    listenFd_ = -1;
+
+    // Wake up connections blocked on an LL-HLS part or in recv()/send()
+    if (llhls_) {
+        llhls_->cancelWaits();
+    }
+
+    // The accept thread is gone, so nothing adds connections any more; join them without the lock
+    std::list<Connection> connections;
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        connections.splice(connections.end(), connections_);
+    }
+    for (Connection& connection : connections) {
+        ::shutdown(connection.fd, SHUT_RDWR);
+    }
+    for (Connection& connection : connections) {
+        if (connection.thread.joinable()) {
+            connection.thread.join();
+        }
+        ::close(connection.fd);
+    }
+
+    Logger::info("HTTP origin stopped");
+}
+
+void HttpOrigin::acceptLoop() {
+    while (running_) {
+        pollfd pfd{listenFd_, POLLIN, 0};
+        if (::poll(&pfd, 1, POLL_INTERVAL_MS) <= 0) {
+            reapConnections();
+            continue;
+        }
+
+        int fd = ::accept(listenFd_, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+
+        timeval sendTimeout{SEND_TIMEOUT_SEC, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+
+        // Every connection holds a thread (blocking LL-HLS requests park it): refuse past the limit
+        if (openConnections() >= options_.maxConnections) {
+            static const std::string refused = buildHeaders(503, "Service Unavailable", "text/plain",
+                                                            0, 0, 0, 0, false);
+            sendAll(fd, refused.data(), refused.size());
+            ::close(fd);
+            if (!refusing_) {
+                Logger::warn("HTTP origin: " + std::to_string(options_.maxConnections) +
+                             " connections open, refusing new ones");
+                refusing_ = true;
+            }
+            continue;
+        }
+        refusing_ = false;
+
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        connections_.emplace_back();
+        Connection* connection = &connections_.back();
+        connection->fd = fd;
+        connection->thread = std::thread(&HttpOrigin::handleConnection, this, connection);
+    }
+}
+
+void HttpOrigin::reapConnections() {
+    std::lock_guard<std::mutex> lock(connectionsMutex_);
+    for (auto it = connections_.begin(); it != connections_.end();) {
+        if (it->done) {
+            it->thread.join();
+            ::close(it->fd);
+            it = connections_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+size_t HttpOrigin::openConnections() {
+    reapConnections();
+    std::lock_guard<std::mutex> lock(connectionsMutex_);
+    return connections_.size();
+}
+
+void HttpOrigin::handleConnection(Connection* connection) {
+    std::string buffer;
+    Request request;
+
+    while (running_ && readRequest(connection->fd, buffer, request)) {
+        if (!handleRequest(connection->fd, request) || !request.keepAlive) {
+            break;
+        }
+        request = Request();
+    }
+
+    // The fd is closed by the thread that joins this one
+    connection->done = true;
+}
+
+bool HttpOrigin::readRequest(int fd, std::string& buffer, Request& request) {
+    size_t headerEnd;
+    int idleMs = 0;
+
+    while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+        if (!running_ || buffer.size() > MAX_HEADER_BYTES || idleMs >= KEEP_ALIVE_TIMEOUT_MS) {
+            return false;
+        }
+
+        pollfd pfd{fd, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, POLL_INTERVAL_MS);
+        if (ready == 0) {
+            idleMs += POLL_INTERVAL_MS;
+            continue;
+        }
+        if (ready < 0) {
+            return false;
+        }
+
+        char chunk[4096];
+        ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            return false;
+        }
+        buffer.append(chunk, static_cast<size_t>(received));
+    }
+
+    std::istringstream lines(buffer.substr(0, headerEnd));
+    buffer.erase(0, headerEnd + 4);  // GET/HEAD carry no body
+
+    // Request line: METHOD TARGET VERSION
+    std::string line;
+    std::getline(lines, line);
+    std::istringstream requestLine(line);
+    std::string target;
+    std::string version;
+    requestLine >> request.method >> target >> version;
+    if (request.method.empty() || target.empty() || target[0] != '/') {
+        return false;
+    }
+
+    size_t queryStart = target.find('?');
+    request.name = target.substr(1, queryStart == std::string::npos ? std::string::npos : queryStart - 1);
+    if (queryStart != std::string::npos) {
+        std::istringstream query(target.substr(queryStart + 1));
+        std::string pair;
+        while (std::getline(query, pair, '&')) {
+            size_t equals = pair.find('=');
+            request.query[pair.substr(0, equals)] = equals == std::string::npos ? "" : pair.substr(equals + 1);
+        }
+    }
+
+    while (std::getline(lines, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, colon);
+        std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return std::tolower(c); });
+        size_t valueStart = line.find_first_not_of(' ', colon + 1);
+        request.headers[key] = valueStart == std::string::npos ? "" : line.substr(valueStart);
+    }
+
+    std::string connectionHeader = request.header("connection");
+    std::transform(connectionHeader.begin(), connectionHeader.end(), connectionHeader.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    request.keepAlive = version == "HTTP/1.1" ? connectionHeader != "close" : connectionHeader == "keep-alive";
+    return true;
+}
+
+bool HttpOrigin::handleRequest(int fd, const Request& request) {
+    if (request.method != "GET" && !request.isHead()) {
+        return sendStatus(fd, request, 405, "Method Not Allowed");
+    }
+
+    // Flat namespace: only file names of the output directory
+    if (request.name.empty() || request.name.find('/') != std::string::npos ||
+        request.name.find('\\') != std::string::npos || request.name.find("..") != std::string::npos) {
+        return sendStatus(fd, request, 404, "Not Found");
+    }
+
+    const bool playlist = endsWith(request.name, ".m3u8");
+
+    // LL-HLS playlist: blocking reload until the requested part is published
+    if (playlist && llhls_) {
+        auto msn = request.query.find("_HLS_msn");
+        if (msn != request.query.end()) {
+            auto part = request.query.find("_HLS_part");
+            int partIndex = part != request.query.end() ? std::atoi(part->second.c_str()) : -1;
+            if (!llhls_->waitForPart(std::atoll(msn->second.c_str()), partIndex, options_.blockTimeoutMs)) {
+                return sendStatus(fd, request, 503, "Service Unavailable");
+            }
+        }
+
+        std::string text = llhls_->getPlaylist();
+        if (!text.empty()) {
+            return sendMemory(fd, request, contentTypeFor(request.name),
+                              reinterpret_cast<const uint8_t*>(text.data()), text.size());
+        }
+    }
+
+    if (store_) {
+        SegmentStore::Data data = store_->get(request.name);
+        if (data) {
+            // data keeps the buffer alive for the whole response, even if the store drops it meanwhile
+            return sendMemory(fd, request, contentTypeFor(request.name), data->data(), data->size());
+        }
+    }
+
+    return sendDiskFile(fd, request, request.name);
+}
+
+bool HttpOrigin::sendMemory(int fd, const Request& request, const std::string& contentType,
+                            const uint8_t* data, size_t size) {
+    int64_t first = 0;
+    int64_t last = static_cast<int64_t>(size) - 1;
+    int status = 200;
+
+    std::string range = request.header("range");
+    if (!range.empty()) {
+        if (!resolveRange(range, static_cast<int64_t>(size), first, last)) {
+            return sendStatus(fd, request, 416, "Range Not Satisfiable");
+        }
+        status = 206;
+    }
+
+    int64_t length = size > 0 ? last - first + 1 : 0;
+    std::string headers = buildHeaders(status, status == 206 ? "Partial Content" : "OK", contentType,
+                                       length, first, last, static_cast<int64_t>(size), request.keepAlive);
+    if (request.isHead()) {
+        return sendAll(fd, headers.data(), headers.size());
+    }
+    return sendVectored(fd, headers, data + first, static_cast<size_t>(length));
+}
+
+bool HttpOrigin::sendDiskFile(int fd, const Request& request, const std::string& name) {
+    std::string range = request.header("range");
+    int64_t availableEnd = -1;
+
+    // LL-HLS preload hint: the client asks for bytes of the open segment that are not cut yet
+    if (llhls_ && !range.empty()) {
+        int64_t first = 0;
+        int64_t last = 0;
+        if (resolveRange(range, INT64_MAX, first, last)) {
+            availableEnd = llhls_->waitForBytes(name, first, options_.blockTimeoutMs);
+            if (availableEnd >= 0 && availableEnd <= first) {
+                return sendStatus(fd, request, 503, "Service Unavailable");
+            }
+        }
+    }
+
+    std::string path = options_.outputDir + "/" + name;
+    int fileFd = ::open(path.c_str(), O_RDONLY);
+    if (fileFd < 0) {
+        return sendStatus(fd, request, 404, "Not Found");
+    }
+
+    struct stat info;
+    if (::fstat(fileFd, &info) != 0) {
+        ::close(fileFd);
+        return sendStatus(fd, request, 404, "Not Found");
+    }
+
+    // Only published bytes of a segment that is still being written
+    int64_t size = static_cast<int64_t>(info.st_size);
+    if (availableEnd >= 0) {
+        size = std::min(size, availableEnd);
+    }
+
+    int64_t first = 0;
+    int64_t last = size - 1;
+    int status = 200;
+    if (!range.empty()) {
+        if (!resolveRange(range, size, first, last)) {
+            ::close(fileFd);
+            return sendStatus(fd, request, 416, "Range Not Satisfiable");
+        }
+        status = 206;
+    }
+
+    int64_t length = size > 0 ? last - first + 1 : 0;
+    std::string headers = buildHeaders(status, status == 206 ? "Partial Content" : "OK", contentTypeFor(name),
+                                       length, first, last, size, request.keepAlive);
+    bool ok = sendAll(fd, headers.data(), headers.size());
+
+    off_t offset = static_cast<off_t>(first);
+    int64_t remaining = request.isHead() ? 0 : length;
+    while (ok && remaining > 0) {
+#ifdef __linux__
+        // Zero-copy: page cache straight to the socket
+        ssize_t sent = ::sendfile(fd, fileFd, &offset, static_cast<size_t>(remaining));
+#else
+        char chunk[FILE_CHUNK_BYTES];
+        ssize_t readBytes = ::pread(fileFd, chunk, std::min<int64_t>(remaining, sizeof(chunk)), offset);
+        ssize_t sent = readBytes > 0 && sendAll(fd, chunk, static_cast<size_t>(readBytes)) ? readBytes : -1;
+        offset += sent > 0 ? sent : 0;
+#endif
+        if (sent <= 0) {
+            ok = false;
+            break;
+        }
+        remaining -= sent;
+    }
+
+    ::close(fileFd);
+    return ok;
+}
+
+bool HttpOrigin::sendStatus(int fd, const Request& request, int status, const std::string& reason) {
+    std::string body = std::to_string(status) + " " + reason + "\n";
+    std::string headers = buildHeaders(status, reason, "text/plain", static_cast<int64_t>(body.size()),
+                                       0, 0, 0, request.keepAlive);
+    if (!request.isHead()) {
+        headers += body;
+    }
+    return sendAll(fd, headers.data(), headers.size());
+}
+
+#endif // PLATFORM_WINDOWS
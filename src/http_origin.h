@@ -0,0 +1,101 @@
+#ifndef HTTP_ORIGIN_H
+#define HTTP_ORIGIN_H
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class SegmentStore;
+class LLHLSWriter;
+
+/**
+ * HttpOrigin - Embedded HTTP/1.1 origin for the generated HLS stream
+ *
+ * Serves playlists and segments without a separate web server reading them
+ * back from disk:
+ *   - Files published to the SegmentStore are sent straight from memory
+ *     (one writev of headers + shared buffer, no copy).
+ *   - Anything else (LL-HLS segments, older VOD segments) is sent from the
+ *     output directory with sendfile().
+ *   - LL-HLS: playlist requests with _HLS_msn/_HLS_part block until that part is
+ *     published (LLHLSWriter::waitForPart) and open-ended byte ranges on the open
+ *     segment (#EXT-X-PRELOAD-HINT) block until the next part is there.
+ *
+ * GET/HEAD only, keep-alive, single byte ranges. One thread per connection,
+ * which suits a handful of CDN/edge clients holding blocking requests; past
+ * Options::maxConnections new connections get a 503 and are closed, so a burst
+ * of clients cannot create threads without bound in the encoder process.
+ *
+ * Not available on Windows (start() fails).
+ *
+ * Thread-safety: start/stop from the owning thread
+ */
+class HttpOrigin {
+public:
+    struct Options {
+        std::string bindAddress = "127.0.0.1";
+        int port = 8080;
+        std::string outputDir;       // Fallback for files not in the store
+        int blockTimeoutMs = 6000;   // Max hold time of blocking requests (3x target duration)
+        size_t maxConnections = 64;  // Open connections (= threads) before new ones are refused
+    };
+
+    /**
+     * @param options Listen address and paths
+     * @param store In-memory files (may be nullptr)
+     * @param llhls LL-HLS writer for blocking requests (may be nullptr)
+     */
+    HttpOrigin(const Options& options, SegmentStore* store, LLHLSWriter* llhls);
+    ~HttpOrigin();
+
+    // No copy, no move (threads reference this)
+    HttpOrigin(const HttpOrigin&) = delete;
+    HttpOrigin& operator=(const HttpOrigin&) = delete;
+
+    /**
+     * Bind the listening socket and start accepting connections
+     * @return true on success
+     */
+    bool start();
+
+    /**
+     * Close all connections and join all threads
+     */
+    void stop();
+
+private:
+    struct Request;
+    struct Connection {
+        int fd = -1;
+        std::thread thread;
+        std::atomic<bool> done{false};
+    };
+
+    void acceptLoop();
+    void handleConnection(Connection* connection);
+    bool readRequest(int fd, std::string& buffer, Request& request);
+    bool handleRequest(int fd, const Request& request);
+    bool sendMemory(int fd, const Request& request, const std::string& contentType,
+                    const uint8_t* data, size_t size);
+    bool sendDiskFile(int fd, const Request& request, const std::string& name);
+    bool sendStatus(int fd, const Request& request, int status, const std::string& reason);
+    void reapConnections();
+    size_t openConnections();
+
+    Options options_;
+    SegmentStore* store_;
+    LLHLSWriter* llhls_;
+
+    int listenFd_ = -1;
+    std::atomic<bool> running_{false};
+    std::thread acceptThread_;
+    bool refusing_ = false;  // At maxConnections (accept thread only, logged once per episode)
+
+    std::mutex connectionsMutex_;
+    std::list<Connection> connections_;
+};
+
+#endif // HTTP_ORIGIN_H
@@ -0,0 +1,141 @@
+#include "input_standby.h"
+#include "ffmpeg_context.h"
+#include "ffmpeg_deleters.h"
+#include "stream_input.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <chrono>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace {
+    constexpr int STANDBY_INITIAL_BACKOFF_MS = 250;   // First retry after a failed open
+    constexpr int STANDBY_MAX_BACKOFF_MS = 10000;     // Retry interval doubles up to this
+    constexpr int STANDBY_HANDOVER_TIMEOUT_MS = 2000; // Longest wait for the standby thread's current read
+}
+
+InputStandby::InputStandby(const std::string& uri, const AppConfig& config, std::shared_ptr<FFmpegContext> ffmpegCtx)
+    : uri_(uri), config_(config), ffmpeg_(ffmpegCtx) {
+    Logger::info("Opening standby input: " + uri_);
+    thread_ = std::thread(&InputStandby::run, this);
+}
+
+InputStandby::~InputStandby() {
+    {
+        // Under the mutex: a waiter between its predicate check and its wait would miss the notify
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cond_.notify_all();
+    // The interrupt callback aborts a blocked open/read
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool InputStandby::isReady() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ready_;
+}
+
+std::unique_ptr<StreamInput> InputStandby::take() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!ready_) {
+        return nullptr;
+    }
+
+    // The thread hands the input over between two reads
+    handoverRequested_ = true;
+    cond_.wait_for(lock, std::chrono::milliseconds(STANDBY_HANDOVER_TIMEOUT_MS),
+                   [this]() { return handedOver_ != nullptr || !ready_; });
+    if (!handedOver_) {
+        if (ready_) {
+            // Stuck in a read: abort it, the standby reconnects
+            Logger::warn("Standby input stalled, reconnecting: " + uri_);
+            abortRead_ = true;
+        }
+        handoverRequested_ = false;
+        return nullptr;
+    }
+
+    std::unique_ptr<StreamInput> input = std::move(handedOver_);
+    lock.unlock();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    return input;
+}
+
+void InputStandby::run() {
+    std::unique_ptr<AVPacket, AVPacketDeleter> packet(ffmpeg_->av_packet_alloc(), AVPacketDeleter(ffmpeg_));
+    if (!packet) {
+        Logger::error("Standby input: failed to allocate packet");
+        return;
+    }
+
+    int backoffMs = STANDBY_INITIAL_BACKOFF_MS;
+    while (!stopping_) {
+        abortRead_ = false;
+        std::unique_ptr<StreamInput> input = StreamInputFactory::create(uri_, config_, ffmpeg_);
+        if (input) {
+            input->setInterruptCallback([this]() { return interrupted(); });
+        }
+        if (input && input->open(uri_)) {
+            Logger::info("Standby input ready: " + uri_);
+            backoffMs = STANDBY_INITIAL_BACKOFF_MS;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ready_ = true;
+            }
+
+            // Keep the connection warm (and at the live edge) until a failover takes it
+            bool failed = false;
+            while (!stopping_) {
+                if (handoverRequested_) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (handoverRequested_) {
+                        input->setInterruptCallback(nullptr);  // The new owner outlives this standby
+                        handedOver_ = std::move(input);
+                        ready_ = false;
+                        cond_.notify_all();
+                        return;
+                    }
+                }
+                if (!input->readPacket(packet.get())) {
+                    failed = true;
+                    break;
+                }
+                ffmpeg_->av_packet_unref(packet.get());
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ready_ = false;
+            }
+            cond_.notify_all();
+            if (!failed) {
+                break;  // Stopping
+            }
+            Logger::warn("Standby input lost: " + uri_);
+        }
+
+        Logger::info("Standby input unavailable, retrying in " + std::to_string(backoffMs) + " ms: " + uri_);
+        if (!waitBackoff(backoffMs)) {
+            break;
+        }
+        backoffMs = std::min(backoffMs * 2, STANDBY_MAX_BACKOFF_MS);
+    }
+}
+
+bool InputStandby::interrupted() const {
+    // A pending handover alone must not abort the read: an interrupted demuxer cannot be handed over
+    return stopping_ || abortRead_;
+}
+
+bool InputStandby::waitBackoff(int delayMs) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return !cond_.wait_for(lock, std::chrono::milliseconds(delayMs), [this]() { return stopping_.load(); });
+}
@@ -0,0 +1,79 @@
+#ifndef INPUT_STANDBY_H
+#define INPUT_STANDBY_H
+
+#include "config.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class FFmpegContext;
+class StreamInput;
+
+/**
+ * InputStandby - Hot standby for a live input
+ *
+ * A background thread opens and probes the standby URI and then keeps the
+ * connection warm by reading and discarding its packets, so a failover only
+ * swaps the demuxer instead of paying for connect + probe. If the standby
+ * drops, the thread reconnects with exponential backoff.
+ *
+ * take() hands the open input over to the processing thread (the standby
+ * thread ends); a new InputStandby is created for the next failover.
+ *
+ * Blocking opens and reads are interrupted (AVIOInterruptCB) when the standby
+ * is destroyed, and when a handover times out because the standby source
+ * stalled; a stalled standby then reconnects.
+ *
+ * Thread-safety: take()/isReady() from any thread
+ */
+class InputStandby {
+public:
+    /**
+     * Start opening the standby input in the background
+     * @param uri Standby input URI
+     * @param config Channel configuration (passed to the input factory)
+     * @param ffmpegCtx Loaded FFmpeg libraries
+     */
+    InputStandby(const std::string& uri, const AppConfig& config, std::shared_ptr<FFmpegContext> ffmpegCtx);
+    ~InputStandby();
+
+    InputStandby(const InputStandby&) = delete;
+    InputStandby& operator=(const InputStandby&) = delete;
+
+    /**
+     * Whether the standby is open and receiving packets
+     */
+    bool isReady() const;
+
+    /**
+     * Take over the standby input
+     * @return The open input (positioned at its live edge), or nullptr if it is not ready
+     */
+    std::unique_ptr<StreamInput> take();
+
+    const std::string& getUri() const { return uri_; }
+
+private:
+    void run();
+    bool interrupted() const;  // Interrupt callback of the standby input
+    bool waitBackoff(int delayMs);  // false if stopping
+
+    const std::string uri_;
+    const AppConfig config_;
+    std::shared_ptr<FFmpegContext> ffmpeg_;
+
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> handoverRequested_{false};
+    std::atomic<bool> abortRead_{false};         // Handover timed out: the current read is stalled
+    bool ready_ = false;                         // Guarded by mutex_
+    std::unique_ptr<StreamInput> handedOver_;    // Guarded by mutex_: set once by the thread
+};
+
+#endif // INPUT_STANDBY_H
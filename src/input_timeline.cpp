@@ -0,0 +1,73 @@
+#include "input_timeline.h"
+#include "ffmpeg_context.h"
+#include "logger.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+}
+
+#include <algorithm>
+
+namespace {
+    // The new input resumes slightly after the old one ended: its first audio packets
+    // (AAC priming, audio muxed ahead of video) must not step back behind the last output
+    constexpr int64_t REBASE_GAP_US = 100000;
+    constexpr AVRational MICROSECONDS = {1, AV_TIME_BASE};  // AV_TIME_BASE_Q is a C compound literal
+}
+
+InputTimeline::InputTimeline(std::shared_ptr<FFmpegContext> ctx)
+    : ffmpeg_(std::move(ctx)) {
+}
+
+void InputTimeline::rebase() {
+    rebasePending_ = endUs_ != INT64_MIN;
+    waitKeyframe_ = true;
+    droppedPackets_ = 0;
+}
+
+bool InputTimeline::onPacket(AVPacket* packet, AVRational timeBase, bool video) {
+    if (waitKeyframe_) {
+        // Audio ahead of the keyframe is dropped too: the new input starts in sync
+        if (!video || !(packet->flags & AV_PKT_FLAG_KEY)) {
+            droppedPackets_++;
+            return false;
+        }
+        waitKeyframe_ = false;
+        if (droppedPackets_ > 0) {
+            Logger::info("Dropped " + std::to_string(droppedPackets_) + " packets before the first keyframe of the new input");
+        }
+    }
+
+    int64_t ts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+    if (ts == AV_NOPTS_VALUE || timeBase.den == 0) {
+        return true;
+    }
+
+    if (rebasePending_) {
+        rebasePending_ = false;
+        int64_t firstUs = ffmpeg_->av_rescale_q(ts, timeBase, MICROSECONDS);
+        offsetUs_ = endUs_ + REBASE_GAP_US - firstUs;
+        Logger::info("Input timestamps shifted by " + std::to_string(offsetUs_ / 1000) +
+                     " ms to continue the output timeline");
+    }
+
+    if (offsetUs_ != 0) {
+        int64_t shift = ffmpeg_->av_rescale_q(offsetUs_, MICROSECONDS, timeBase);
+        if (packet->pts != AV_NOPTS_VALUE) {
+            packet->pts += shift;
+        }
+        if (packet->dts != AV_NOPTS_VALUE) {
+            packet->dts += shift;
+        }
+    }
+
+    // Latest of pts/dts (B-frames present later than they decode) plus the packet's own duration
+    int64_t last = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+    if (packet->pts != AV_NOPTS_VALUE) {
+        last = std::max(last, packet->pts);
+    }
+    last += std::max<int64_t>(packet->duration, 0);
+    endUs_ = std::max(endUs_, ffmpeg_->av_rescale_q(last, timeBase, MICROSECONDS));
+    return true;
+}
@@ -0,0 +1,58 @@
+#ifndef INPUT_TIMELINE_H
+#define INPUT_TIMELINE_H
+
+#include <cstdint>
+#include <memory>
+
+class FFmpegContext;
+struct AVPacket;
+struct AVRational;
+
+/**
+ * InputTimeline - Keeps input timestamps continuous across input failovers
+ *
+ * A reconnected or standby input starts its own timestamps, usually far from
+ * where the lost input stopped. When the output muxer keeps running, those
+ * would step back (or jump) in the middle of a segment. After rebase(), the
+ * first packet of the new input sets an offset that places it just after the
+ * end of the last packet seen; every later packet gets the same offset, so
+ * audio and video keep their sync within the new input.
+ *
+ * A new input usually joins mid-GOP: after rebase() packets are dropped until
+ * its first video keyframe, so decoders (and copied output) start cleanly.
+ * Before the first rebase() packets pass through unchanged.
+ *
+ * Usage:
+ *   if (!timeline.onPacket(packet, inputStream->time_base, isVideo)) drop;  // every demuxed packet
+ *   timeline.rebase();                                                       // input replaced
+ *
+ * Thread-safety: demux thread only (rebase() while no packets are processed)
+ */
+class InputTimeline {
+public:
+    explicit InputTimeline(std::shared_ptr<FFmpegContext> ctx);
+
+    /**
+     * Shift a packet onto the output timeline and record where it ends
+     * @param packet Demuxed packet (pts/dts are changed in place)
+     * @param timeBase Time base of the packet's input stream
+     * @param video Packet of the video stream
+     * @return false if the packet precedes the new input's first keyframe (drop it)
+     */
+    bool onPacket(AVPacket* packet, AVRational timeBase, bool video);
+
+    /**
+     * The next packet comes from a new input: continue after the last one
+     */
+    void rebase();
+
+private:
+    std::shared_ptr<FFmpegContext> ffmpeg_;
+    int64_t offsetUs_ = 0;       // Added to every packet (AV_TIME_BASE units)
+    int64_t endUs_ = INT64_MIN;  // End of the latest packet on the output timeline
+    bool rebasePending_ = false;
+    bool waitKeyframe_ = false;  // New input: drop packets until its first video keyframe
+    int64_t droppedPackets_ = 0;
+};
+
+#endif // INPUT_TIMELINE_H
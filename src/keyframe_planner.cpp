@@ -0,0 +1,28 @@
+#include "keyframe_planner.h"
+
+void KeyframePlanner::configure(int timeBaseNum, int timeBaseDen, int segmentDurationSec) {
+    timeBaseNum_ = timeBaseNum > 0 ? timeBaseNum : 1;
+    timeBaseDen_ = timeBaseDen > 0 ? timeBaseDen : 1;
+    segmentDurationSec_ = segmentDurationSec > 0 ? segmentDurationSec : 1;
+    lastSegmentIndex_ = -1;
+}
+
+bool KeyframePlanner::shouldForceKeyframe(int64_t pts) {
+    if (pts < 0) {
+        return false;
+    }
+
+    // Segment index = floor(pts * time_base / segment_duration), exact integer math
+    int64_t segmentIndex = (pts * timeBaseNum_) / (timeBaseDen_ * segmentDurationSec_);
+    if (segmentIndex <= lastSegmentIndex_) {
+        return false;
+    }
+
+    lastSegmentIndex_ = segmentIndex;
+    return true;
+}
+
+int KeyframePlanner::framesPerSegment(int fps, int segmentDurationSec) {
+    int frames = fps * segmentDurationSec;
+    return frames > 0 ? frames : 1;
+}
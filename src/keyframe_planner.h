@@ -0,0 +1,56 @@
+#ifndef KEYFRAME_PLANNER_H
+#define KEYFRAME_PLANNER_H
+
+#include <cstdint>
+
+/**
+ * KeyframePlanner - Decides which frames must be IDR so HLS segments are exact
+ *
+ * The HLS muxer can only cut a segment on a keyframe. Instead of relying on a
+ * fixed GOP that may drift from the segment grid, the planner flags the first
+ * frame at or after every multiple of the segment duration; the encoder then
+ * forces an IDR there (pict_type = I with x264 "forced-idr"). Every segment
+ * starts exactly on the grid and renditions fed the same PTS stay aligned.
+ *
+ * Usage:
+ *   planner.configure(codecCtx->time_base.num, codecCtx->time_base.den, segmentDuration);
+ *   frame->pict_type = planner.shouldForceKeyframe(frame->pts) ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+ */
+class KeyframePlanner {
+public:
+    /**
+     * Set the encoder time base and HLS segment duration (also resets state)
+     * @param timeBaseNum Encoder time base numerator
+     * @param timeBaseDen Encoder time base denominator
+     * @param segmentDurationSec Target segment duration in seconds
+     */
+    void configure(int timeBaseNum, int timeBaseDen, int segmentDurationSec);
+
+    /**
+     * Check whether the frame with this PTS opens a new segment
+     * Call once per frame, in PTS order
+     * @param pts Frame PTS in the encoder time base
+     * @return true if the frame must be encoded as IDR
+     */
+    bool shouldForceKeyframe(int64_t pts);
+
+    /**
+     * Forget the last segment (next frame is forced to IDR)
+     */
+    void reset() { lastSegmentIndex_ = -1; }
+
+    /**
+     * GOP size matching one segment, used as the encoder's maximum keyframe interval
+     * @param fps Frame rate
+     * @param segmentDurationSec Segment duration in seconds
+     */
+    static int framesPerSegment(int fps, int segmentDurationSec);
+
+private:
+    int64_t timeBaseNum_ = 1;
+    int64_t timeBaseDen_ = 1;
+    int64_t segmentDurationSec_ = 1;
+    int64_t lastSegmentIndex_ = -1;
+};
+
+#endif // KEYFRAME_PLANNER_H
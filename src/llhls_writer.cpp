@@ -0,0 +1,455 @@
+#include "llhls_writer.h"
+#include "ffmpeg_context.h"
+#include "logger.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavformat/avio.h>
+#include <libavutil/opt.h>
+}
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+    constexpr int IO_BUFFER_SIZE = 64 * 1024;         // AVIO buffer (flushed at every part boundary)
+    constexpr double TIME_EPSILON_SEC = 0.001;        // Tolerance for boundary comparisons
+    constexpr int PART_WINDOW_TARGET_DURATIONS = 3;   // Parts listed for the last N target durations
+    constexpr double PART_HOLD_BACK_PARTS = 3.0;      // Recommended PART-HOLD-BACK (>= 2 required)
+    constexpr size_t RETIRED_SEGMENTS_KEPT = 1;       // Grace period for players still loading old segments
+}
+
+LLHLSWriter::LLHLSWriter(std::shared_ptr<FFmpegContext> ctx, const Options& options)
+    : ffmpeg_(std::move(ctx)), options_(options) {
+    if (options_.partDurationMs <= 0) {
+        options_.partDurationMs = 200;
+    }
+    if (options_.segmentDurationSec <= 0) {
+        options_.segmentDurationSec = 2;
+    }
+
+    // Parts hold whole frames, so the target is rounded up to the frame grid
+    partTarget_ = options_.partDurationMs / 1000.0;
+    if (options_.fps > 0) {
+        double frames = std::ceil(partTarget_ * options_.fps - TIME_EPSILON_SEC);
+        partTarget_ = std::max(1.0, frames) / options_.fps;
+    }
+    targetDuration_ = options_.segmentDurationSec;
+    current_.uri = segmentUri(0);
+}
+
+LLHLSWriter::~LLHLSWriter() {
+    if (segmentFile_) {
+        std::fclose(segmentFile_);
+        segmentFile_ = nullptr;
+    }
+    releaseIO();
+}
+
+bool LLHLSWriter::attach(AVFormatContext* outputFormatCtx) {
+    if (!outputFormatCtx || outputFormatCtx->pb) {
+        Logger::error("LL-HLS: output context must not have an open AVIO");
+        return false;
+    }
+
+    unsigned char* buffer = static_cast<unsigned char*>(ffmpeg_->av_malloc(IO_BUFFER_SIZE));
+    if (!buffer) {
+        Logger::error("LL-HLS: failed to allocate AVIO buffer");
+        return false;
+    }
+
+    ioCtx_ = ffmpeg_->avio_alloc_context(buffer, IO_BUFFER_SIZE, 1, this, nullptr, &LLHLSWriter::writePacket, nullptr);
+    if (!ioCtx_) {
+        ffmpeg_->av_free(buffer);
+        Logger::error("LL-HLS: failed to allocate AVIO context");
+        return false;
+    }
+
+    outputFormatCtx->pb = ioCtx_;
+    outputFormatCtx->flags |= AVFMT_FLAG_CUSTOM_IO;
+    outputFormatCtx_ = outputFormatCtx;
+    haveTime_ = false;
+
+    Logger::info("LL-HLS: " + std::to_string(static_cast<int>(std::lround(partTarget_ * 1000.0))) + "ms parts, " +
+                 std::to_string(options_.segmentDurationSec) + "s segments" +
+                 (options_.canBlockReload ? ", blocking playlist reload" : ""));
+    return true;
+}
+
+void LLHLSWriter::onVideoPacket(const AVPacket* packet, AVRational timeBase) {
+    if (!outputFormatCtx_ || !packet || timeBase.den == 0) {
+        return;
+    }
+
+    // DTS is monotonic even with B-frames; parts are cut in decode order
+    int64_t ts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+    if (ts == AV_NOPTS_VALUE) {
+        return;
+    }
+
+    double t = static_cast<double>(ts) * timeBase.num / timeBase.den;
+    bool keyframe = (packet->flags & AV_PKT_FLAG_KEY) != 0;
+
+    if (!haveTime_) {
+        segmentStart_ = t;
+        partStart_ = t;
+        lastTime_ = t;
+        partIndependent_ = keyframe;
+        haveTime_ = true;
+        return;
+    }
+
+    if (t > lastTime_) {
+        frameInterval_ = t - lastTime_;
+    }
+
+    if ((keyframe && t - segmentStart_ >= options_.segmentDurationSec - TIME_EPSILON_SEC) ||
+        (t > segmentStart_ && t - segmentStart_ + frameInterval_ > targetDuration_ + TIME_EPSILON_SEC)) {
+        // Keyframe past the segment duration, or this frame would take the segment past TARGETDURATION
+        // (EXTINF must never exceed it): a long copied GOP continues in the next segment
+        closeSegment(t);
+        segmentStart_ = t;
+        partStart_ = t;
+        partIndependent_ = keyframe;
+    } else if (t > partStart_ && t - partStart_ + frameInterval_ > partTarget_ + TIME_EPSILON_SEC) {
+        // Adding this frame would overshoot the part target: cut in front of it
+        closePart(t);
+        writePlaylist();
+        partStart_ = t;
+        partIndependent_ = keyframe;
+    }
+
+    lastTime_ = std::max(lastTime_, t);
+}
+
+void LLHLSWriter::detach() {
+    if (!outputFormatCtx_) {
+        return;
+    }
+
+    if (haveTime_) {
+        closeSegment(lastTime_ + frameInterval_);
+    }
+
+    {
+        // Timestamps and codec state restart with the next output context
+        std::lock_guard<std::mutex> lock(mutex_);
+        current_.discontinuity = !segments_.empty();
+    }
+
+    releaseIO();
+    outputFormatCtx_ = nullptr;
+    haveTime_ = false;
+}
+
+void LLHLSWriter::finish() {
+    if (!outputFormatCtx_) {
+        return;
+    }
+
+    // The trailer is already in the segment file; publish it as the last part
+    closeSegment(lastTime_ + frameInterval_);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_ = true;
+    }
+    writePlaylist();
+
+    releaseIO();
+    outputFormatCtx_ = nullptr;
+    haveTime_ = false;
+
+    Logger::info("LL-HLS playlist finalized");
+}
+
+bool LLHLSWriter::waitForPart(int64_t msn, int part, int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto available = [&]() {
+        if (finished_ || msn < current_.msn) {
+            return true;
+        }
+        return msn == current_.msn && part >= 0 && part < static_cast<int>(current_.parts.size());
+    };
+    partCond_.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&]() { return waitsCancelled_ || available(); });
+    return available();
+}
+
+int64_t LLHLSWriter::waitForBytes(const std::string& uri, int64_t offset, int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto publishedEnd = [this]() -> int64_t {
+        return current_.parts.empty() ? 0 : current_.parts.back().offset + current_.parts.back().length;
+    };
+
+    partCond_.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&]() {
+        return waitsCancelled_ || finished_ || current_.uri != uri || publishedEnd() > offset;
+    });
+
+    if (finished_ || current_.uri != uri) {
+        return -1;
+    }
+    return publishedEnd();
+}
+
+void LLHLSWriter::cancelWaits() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        waitsCancelled_ = true;
+    }
+    partCond_.notify_all();
+}
+
+std::string LLHLSWriter::getPlaylist() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return playlist_;
+}
+
+// ===== Segment / part bookkeeping =====
+
+int LLHLSWriter::writePacket(void* opaque, const uint8_t* buf, int size) {
+    LLHLSWriter* self = static_cast<LLHLSWriter*>(opaque);
+
+    if (!self->segmentFile_ && !self->openSegment()) {
+        return AVERROR(EIO);
+    }
+
+    if (std::fwrite(buf, 1, size, self->segmentFile_) != static_cast<size_t>(size)) {
+        Logger::error("LL-HLS: failed to write segment data");
+        return AVERROR(EIO);
+    }
+
+    self->segmentBytes_ += size;
+    return size;
+}
+
+bool LLHLSWriter::openSegment() {
+    std::string uri;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uri = current_.uri;
+    }
+
+    std::string path = options_.outputDir + "/" + uri;
+    segmentFile_ = std::fopen(path.c_str(), "wb");
+    if (!segmentFile_) {
+        Logger::error("LL-HLS: failed to open segment file: " + path);
+        return false;
+    }
+
+    segmentBytes_ = 0;
+    partStartOffset_ = 0;
+    return true;
+}
+
+void LLHLSWriter::flushMuxer() {
+    if (!outputFormatCtx_) {
+        return;
+    }
+
+    // Drain the interleaving queue, then the muxer's own PES buffers, then the AVIO buffer
+    ffmpeg_->av_interleaved_write_frame(outputFormatCtx_, nullptr);
+    ffmpeg_->av_write_frame(outputFormatCtx_, nullptr);
+    if (ioCtx_) {
+        ffmpeg_->avio_flush(ioCtx_);
+    }
+    if (segmentFile_) {
+        std::fflush(segmentFile_);
+    }
+}
+
+void LLHLSWriter::closePart(double endTime) {
+    flushMuxer();
+
+    int64_t length = segmentBytes_ - partStartOffset_;
+    if (length <= 0) {
+        return;
+    }
+
+    Part part;
+    part.duration = std::max(endTime - partStart_, 0.0);
+    part.offset = partStartOffset_;
+    part.length = length;
+    part.independent = partIndependent_;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        current_.parts.push_back(part);
+        current_.duration += part.duration;
+    }
+
+    partStartOffset_ = segmentBytes_;
+}
+
+void LLHLSWriter::closeSegment(double endTime) {
+    closePart(endTime);
+
+    if (segmentFile_) {
+        std::fclose(segmentFile_);
+        segmentFile_ = nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!current_.parts.empty()) {
+            int64_t nextMsn = current_.msn + 1;
+            segments_.push_back(std::move(current_));
+
+            while (segments_.size() > static_cast<size_t>(std::max(options_.playlistSize, 1))) {
+                if (segments_.front().discontinuity) {
+                    discontinuitySequence_++;
+                }
+                retiredFiles_.push_back(segments_.front().uri);
+                segments_.pop_front();
+            }
+
+            current_ = Segment();
+            current_.msn = nextMsn;
+            current_.uri = segmentUri(nextMsn);
+        }
+    }
+
+    while (retiredFiles_.size() > RETIRED_SEGMENTS_KEPT) {
+        std::error_code ec;
+        std::filesystem::remove(options_.outputDir + "/" + retiredFiles_.front(), ec);
+        retiredFiles_.pop_front();
+    }
+
+    // Next segment starts with PAT/PMT so it can be decoded on its own
+    if (outputFormatCtx_ && outputFormatCtx_->priv_data) {
+        ffmpeg_->av_opt_set(outputFormatCtx_->priv_data, "mpegts_flags", "resend_headers", 0);
+    }
+
+    writePlaylist();
+}
+
+void LLHLSWriter::writePlaylist() {
+    std::string text;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        playlist_ = buildPlaylist();
+        text = playlist_;
+    }
+    partCond_.notify_all();
+
+    // Players must never see a half-written playlist: write a temp file and rename it over
+    std::string path = options_.outputDir + "/" + options_.playlistName;
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            Logger::warn("LL-HLS: could not write playlist: " + tmpPath);
+            return;
+        }
+        out << text;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        Logger::warn("LL-HLS: could not publish playlist: " + ec.message());
+    }
+}
+
+std::string LLHLSWriter::buildPlaylist() const {
+    // Caller holds mutex_
+    // Parts are only listed close to the live edge
+    std::vector<bool> listParts(segments_.size(), false);
+    double fromEdge = current_.duration;
+    for (size_t i = segments_.size(); i-- > 0;) {
+        if (fromEdge >= PART_WINDOW_TARGET_DURATIONS * targetDuration_) {
+            break;
+        }
+        listParts[i] = true;
+        fromEdge += segments_[i].duration;
+    }
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+
+    auto writeParts = [&out](const Segment& segment) {
+        for (const Part& part : segment.parts) {
+            out << "#EXT-X-PART:DURATION=" << part.duration
+                << ",URI=\"" << segment.uri << "\""
+                << ",BYTERANGE=\"" << part.length << "@" << part.offset << "\"";
+            if (part.independent) {
+                out << ",INDEPENDENT=YES";
+            }
+            out << "\n";
+        }
+    };
+
+    out << "#EXTM3U\n";
+    out << "#EXT-X-VERSION:9\n";
+    out << "#EXT-X-TARGETDURATION:" << targetDuration_ << "\n";
+    out << "#EXT-X-SERVER-CONTROL:";
+    if (options_.canBlockReload) {
+        out << "CAN-BLOCK-RELOAD=YES,";
+    }
+    out << "PART-HOLD-BACK=" << PART_HOLD_BACK_PARTS * partTarget_ << "\n";
+    out << "#EXT-X-PART-INF:PART-TARGET=" << partTarget_ << "\n";
+    out << "#EXT-X-MEDIA-SEQUENCE:" << (segments_.empty() ? current_.msn : segments_.front().msn) << "\n";
+    if (discontinuitySequence_ > 0) {
+        out << "#EXT-X-DISCONTINUITY-SEQUENCE:" << discontinuitySequence_ << "\n";
+    }
+    if (options_.keyframesForced) {
+        out << "#EXT-X-INDEPENDENT-SEGMENTS\n";
+    }
+
+    for (size_t i = 0; i < segments_.size(); i++) {
+        const Segment& segment = segments_[i];
+        if (segment.discontinuity) {
+            out << "#EXT-X-DISCONTINUITY\n";
+        }
+        if (listParts[i]) {
+            writeParts(segment);
+        }
+        out << "#EXTINF:" << segment.duration << ",\n";
+        out << segment.uri << "\n";
+    }
+
+    if (finished_) {
+        out << "#EXT-X-ENDLIST\n";
+        return out.str();
+    }
+
+    if (current_.discontinuity && !current_.parts.empty()) {
+        out << "#EXT-X-DISCONTINUITY\n";
+    }
+    writeParts(current_);
+
+    // Next part starts where the published bytes of the open segment end
+    int64_t nextOffset = 0;
+    if (!current_.parts.empty()) {
+        nextOffset = current_.parts.back().offset + current_.parts.back().length;
+    }
+    out << "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"" << current_.uri << "\"";
+    if (nextOffset > 0) {
+        out << ",BYTERANGE-START=" << nextOffset;
+    }
+    out << "\n";
+
+    return out.str();
+}
+
+std::string LLHLSWriter::segmentUri(int64_t msn) const {
+    return "segment" + std::to_string(msn) + ".ts";
+}
+
+void LLHLSWriter::releaseIO() {
+    if (!ioCtx_) {
+        return;
+    }
+
+    ffmpeg_->av_free(ioCtx_->buffer);
+    ioCtx_->buffer = nullptr;
+    ffmpeg_->avio_context_free(&ioCtx_);
+
+    if (outputFormatCtx_) {
+        outputFormatCtx_->pb = nullptr;
+    }
+}
@@ -0,0 +1,188 @@
+#ifndef LLHLS_WRITER_H
+#define LLHLS_WRITER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class FFmpegContext;
+struct AVFormatContext;
+struct AVIOContext;
+struct AVPacket;
+struct AVRational;
+
+/**
+ * LLHLSWriter - Low-Latency HLS output (partial segments + blocking playlist reload)
+ *
+ * The hls muxer only publishes whole segments, so the writer drives a plain
+ * mpegts muxer instead and does the HLS side itself:
+ *   - The muxer writes through a custom AVIO into the current segment file
+ *     (segment<MSN>.ts); the writer counts bytes as they arrive.
+ *   - onVideoPacket() is called before every video packet is muxed. It closes a
+ *     part (never longer than PART-TARGET) or, on a keyframe past
+ *     segmentDuration, the whole segment, by flushing the muxer so the part's
+ *     bytes are on disk. A segment that would grow past TARGETDURATION is cut
+ *     without a keyframe (copied input with a GOP longer than the segment); its
+ *     first part is then not INDEPENDENT, and EXT-X-INDEPENDENT-SEGMENTS is only
+ *     declared when Options::keyframesForced promises keyframes on the grid.
+ *   - PART-TARGET, PART-HOLD-BACK and TARGETDURATION are fixed when the writer
+ *     is created (the spec forbids changing them mid-stream): PART-TARGET is
+ *     partDurationMs rounded up to whole frames, TARGETDURATION is
+ *     segmentDuration.
+ *   - Each part is published as a byte range of its segment (#EXT-X-PART with
+ *     BYTERANGE), so there are no extra part files. The next part is announced
+ *     with #EXT-X-PRELOAD-HINT and the playlist is rewritten atomically
+ *     (temp file + rename) every time a part completes.
+ *
+ * Blocking reload (_HLS_msn/_HLS_part) is served by an HTTP front end through
+ * waitForPart()/getPlaylist(); CAN-BLOCK-RELOAD is only advertised when
+ * Options::canBlockReload says such a front end is attached.
+ *
+ * Usage:
+ *   writer.attach(outputFormatCtx);              // before avformat_write_header()
+ *   writer.onVideoPacket(packet, inputTimeBase); // before muxing each video packet
+ *   writer.finish();                             // after av_write_trailer()
+ *
+ * Thread-safety: attach/onVideoPacket/detach/finish on the muxing thread;
+ *                waitForPart/waitForBytes/cancelWaits/getPlaylist from any thread
+ */
+class LLHLSWriter {
+public:
+    struct Options {
+        std::string outputDir;
+        std::string playlistName = "playlist.m3u8";
+        int segmentDurationSec = 2;
+        int partDurationMs = 200;
+        int fps = 0;                   // Encoder frame rate (PART-TARGET is rounded up to whole frames; 0 = unknown)
+        int playlistSize = 3;          // Full segments kept in the playlist window
+        bool canBlockReload = false;   // An HTTP server answers _HLS_msn/_HLS_part requests
+        bool keyframesForced = false;  // The encoder puts a keyframe at every segmentDuration
+    };
+
+    LLHLSWriter(std::shared_ptr<FFmpegContext> ctx, const Options& options);
+    ~LLHLSWriter();
+
+    // No copy, no move (the AVIO callback holds a pointer to this)
+    LLHLSWriter(const LLHLSWriter&) = delete;
+    LLHLSWriter& operator=(const LLHLSWriter&) = delete;
+
+    /**
+     * Route an mpegts output context through the writer
+     * Must be called before avformat_write_header(). Attaching again after
+     * detach() continues the same playlist with a discontinuity.
+     * @param outputFormatCtx mpegts output context (pb must be unset)
+     * @return true on success
+     */
+    bool attach(AVFormatContext* outputFormatCtx);
+
+    /**
+     * Cut parts/segments ahead of a video packet
+     * @param packet Video packet about to be muxed
+     * @param timeBase Time base of packet timestamps
+     */
+    void onVideoPacket(const AVPacket* packet, AVRational timeBase);
+
+    /**
+     * Close the current segment and release the AVIO of the attached context
+     * Call before the output context is freed (e.g. when the muxer is recreated)
+     */
+    void detach();
+
+    /**
+     * Close the last segment and end the playlist (#EXT-X-ENDLIST)
+     * Call after av_write_trailer()
+     */
+    void finish();
+
+    /**
+     * Block until a part (or a whole segment) is in the playlist
+     * @param msn Media sequence number of the segment
+     * @param part Part index within the segment, or -1 for the whole segment
+     * @param timeoutMs Maximum wait in milliseconds
+     * @return true if available, false on timeout or cancelWaits()
+     */
+    bool waitForPart(int64_t msn, int part, int timeoutMs);
+
+    /**
+     * Block until a segment has published bytes past an offset (preload hint requests)
+     * @param uri Segment file name
+     * @param offset First byte the client asked for
+     * @param timeoutMs Maximum wait in milliseconds
+     * @return End of the published bytes if uri is the open segment, or -1 if the segment is complete
+     */
+    int64_t waitForBytes(const std::string& uri, int64_t offset, int timeoutMs);
+
+    /**
+     * Release every blocked waitForPart()/waitForBytes() and make later calls return at once
+     * Called by the HTTP front end when it shuts down
+     */
+    void cancelWaits();
+
+    /**
+     * Current playlist text (same content as the file on disk)
+     */
+    std::string getPlaylist() const;
+
+private:
+    struct Part {
+        double duration = 0.0;
+        int64_t offset = 0;
+        int64_t length = 0;
+        bool independent = false;
+    };
+
+    struct Segment {
+        int64_t msn = 0;
+        std::string uri;
+        double duration = 0.0;
+        bool discontinuity = false;
+        std::vector<Part> parts;
+    };
+
+    static int writePacket(void* opaque, const uint8_t* buf, int size);
+
+    bool openSegment();
+    void closePart(double endTime);
+    void closeSegment(double endTime);
+    void flushMuxer();
+    void writePlaylist();
+    std::string buildPlaylist() const;
+    std::string segmentUri(int64_t msn) const;
+    void releaseIO();
+
+    std::shared_ptr<FFmpegContext> ffmpeg_;
+    Options options_;
+    double partTarget_ = 0.0;       // PART-TARGET in seconds (parts never exceed it)
+    int targetDuration_ = 0;        // EXT-X-TARGETDURATION in seconds
+
+    // ===== Muxing thread state =====
+    AVFormatContext* outputFormatCtx_ = nullptr;
+    AVIOContext* ioCtx_ = nullptr;
+    std::FILE* segmentFile_ = nullptr;
+    int64_t segmentBytes_ = 0;
+    int64_t partStartOffset_ = 0;
+    bool haveTime_ = false;         // Segment/part start times are valid
+    double segmentStart_ = 0.0;
+    double partStart_ = 0.0;
+    double lastTime_ = 0.0;
+    double frameInterval_ = 0.0;
+    bool partIndependent_ = false;  // Current part starts with a keyframe
+    std::deque<std::string> retiredFiles_;  // Left the window, deleted one segment later
+
+    // ===== Published state (guarded by mutex_) =====
+    mutable std::mutex mutex_;
+    std::condition_variable partCond_;
+    std::deque<Segment> segments_;  // Window of complete segments
+    Segment current_;               // Open segment (its parts are already published)
+    int64_t discontinuitySequence_ = 0;
+    bool finished_ = false;
+    bool waitsCancelled_ = false;   // Front end shutting down: blocking requests return immediately
+    std::string playlist_;
+};
+
+#endif // LLHLS_WRITER_H
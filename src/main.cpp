@@ -4,6 +4,13 @@
 #include <csignal>
 #include <atomic>
 #include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <memory>
+#include <cstdio>
 #include <sys/stat.h>
 #ifdef _WIN32
     #include <process.h>  // For _getpid()
@@ -16,6 +23,7 @@
 #include "hls_generator.h"
 #include "stream_input.h"
 #include "config.h"
+#include "thread_budget.h"
 
 // Note: CEF subprocess handling is done by OBS's obs-browser-page
 // We don't need CEF includes or subprocess handling in main.cpp
@@ -31,14 +39,29 @@ void signalHandler(int) {
 }
 
 void printUsage(const char* progName) {
-    std::cout << "Usage: " << progName << " [OPTIONS] <input_source> <output_directory>" << std::endl;
+    std::cout << "Usage: " << progName << " [OPTIONS] <input_source> <output_directory> [<input_source> <output_directory> ...]" << std::endl;
     std::cout << std::endl;
     std::cout << "Options:" << std::endl;
     std::cout << "  --no-js           Disable JavaScript injection (no cookie auto-accept)" << std::endl;
+    std::cout << "  --fps <n>         Output frame rate (browser sources render at this rate, default 30)" << std::endl;
+    std::cout << "  --begin-frame     Browser sources: render exactly one frame per output frame" << std::endl;
+    std::cout << "  --ladder <list>   Adaptive-bitrate ladder (TRANSCODE), comma-separated renditions:" << std::endl;
+    std::cout << "                    presets 1080p, 720p, 480p, 360p or WIDTHxHEIGHT@KBPS" << std::endl;
+    std::cout << "  --ll-hls          Low-Latency HLS: ~200ms partial segments and preload hints" << std::endl;
+    std::cout << "  --fmp4            fMP4/CMAF segments (init.mp4 + .m4s) instead of MPEG-TS" << std::endl;
+    std::cout << "  --sync-writes     Write segments from the muxing thread (no write-behind I/O thread)" << std::endl;
+    std::cout << "  --serve [HOST:]PORT  Serve the stream over HTTP (default host 127.0.0.1)" << std::endl;
+    std::cout << "  --no-disk         With --serve: keep live segments in memory only (not with --ll-hls/--sync-writes)" << std::endl;
+    std::cout << "  --backup <uri>    Live inputs: hot standby source for failover (repeat: one per channel, in order)" << std::endl;
+    std::cout << "  --cpu-budget <n>  Cores for the whole process, split between channels and their" << std::endl;
+    std::cout << "                    decode/scale/encode threads (default: all hardware threads)" << std::endl;
+    std::cout << "  --sequential-vod  Transcode files front to back instead of in parallel segment-aligned chunks" << std::endl;
     std::cout << std::endl;
     std::cout << "Arguments:" << std::endl;
     std::cout << "  input_source      Video file path or stream URI" << std::endl;
     std::cout << "  output_directory  Directory where HLS files will be generated" << std::endl;
+    std::cout << "  Several input/output pairs run as independent channels in one process" << std::endl;
+    std::cout << "  (browser sources share one CEF instance; --serve uses PORT, PORT+1, ...)" << std::endl;
     std::cout << std::endl;
     std::cout << "Supported input sources:" << std::endl;
     std::cout << "  Files:      video.mp4, video.mkv, video.webm, etc." << std::endl;
@@ -54,6 +77,128 @@ void printUsage(const char* progName) {
     std::cout << "  " << progName << " rtmp://live.twitch.tv/app/stream_key /path/to/output" << std::endl;
     std::cout << "  " << progName << " https://example.com /path/to/output" << std::endl;
     std::cout << "  " << progName << " --no-js https://example.com /path/to/output" << std::endl;
+    std::cout << "  " << progName << " --fps 60 --begin-frame https://example.com /path/to/output" << std::endl;
+    std::cout << "  " << progName << " https://example.com/a /path/to/a https://example.com/b /path/to/b" << std::endl;
+    std::cout << "  " << progName << " --ladder 1080p,720p,480p,360p video.mkv /path/to/output" << std::endl;
+    std::cout << "  " << progName << " --ll-hls srt://192.168.1.100:9000 /path/to/output" << std::endl;
+    std::cout << "  " << progName << " --serve 0.0.0.0:8080 --no-disk srt://192.168.1.100:9000 /path/to/output" << std::endl;
+    std::cout << "  " << progName << " --backup srt://192.168.1.101:9000 srt://192.168.1.100:9000 /path/to/output" << std::endl;
+    std::cout << "  " << progName << " --cpu-budget 8 --ladder 720p,480p a.mkv /out/a b.mkv /out/b" << std::endl;
+}
+
+// Built-in ladder rungs for --ladder
+namespace {
+    struct LadderPreset {
+        const char* name;
+        int width;
+        int height;
+        int bitrate;
+    };
+
+    const LadderPreset LADDER_PRESETS[] = {
+        {"1080p", 1920, 1080, 5000000},
+        {"720p",  1280,  720, 2800000},
+        {"480p",   854,  480, 1400000},
+        {"360p",   640,  360,  800000},
+    };
+}
+
+// Parse --ladder value: "1080p,720p" presets and/or "WIDTHxHEIGHT@KBPS" entries
+bool parseLadder(const std::string& spec, std::vector<RenditionConfig>& renditions) {
+    std::stringstream stream(spec);
+    std::string item;
+
+    while (std::getline(stream, item, ',')) {
+        RenditionConfig rendition;
+        bool found = false;
+
+        for (const LadderPreset& preset : LADDER_PRESETS) {
+            if (item == preset.name) {
+                rendition.name = preset.name;
+                rendition.width = preset.width;
+                rendition.height = preset.height;
+                rendition.bitrate = preset.bitrate;
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) {
+            int width = 0;
+            int height = 0;
+            int kbps = 0;
+            char trailing = 0;
+            if (std::sscanf(item.c_str(), "%dx%d@%d%c", &width, &height, &kbps, &trailing) != 3 ||
+                width <= 0 || height <= 0 || kbps <= 0) {
+                Logger::error("Invalid ladder rendition: '" + item + "' (expected preset or WIDTHxHEIGHT@KBPS)");
+                return false;
+            }
+            if (width % 2 != 0 || height % 2 != 0) {
+                Logger::error("Ladder rendition size must be even: " + item);
+                return false;
+            }
+            rendition.name = std::to_string(height) + "p" + std::to_string(kbps);
+            rendition.width = width;
+            rendition.height = height;
+            rendition.bitrate = kbps * 1000;
+        }
+
+        for (const RenditionConfig& existing : renditions) {
+            if (existing.name == rendition.name) {
+                Logger::error("Duplicate ladder rendition: " + item);
+                return false;
+            }
+        }
+        renditions.push_back(rendition);
+    }
+
+    if (renditions.empty()) {
+        Logger::error("Empty ladder specification");
+        return false;
+    }
+    return true;
+}
+
+// Parse --serve value: "PORT" or "HOST:PORT" (IPv4 host)
+bool parseServe(const std::string& spec, HLSConfig& hls) {
+    size_t colon = spec.rfind(':');
+    std::string host = colon == std::string::npos ? hls.httpBindAddress : spec.substr(0, colon);
+    std::string port = colon == std::string::npos ? spec : spec.substr(colon + 1);
+
+    int value = 0;
+    char trailing = 0;
+    if (host.empty() || std::sscanf(port.c_str(), "%d%c", &value, &trailing) != 1 || value <= 0 || value > 65535) {
+        Logger::error("Invalid --serve address: '" + spec + "' (expected PORT or HOST:PORT)");
+        return false;
+    }
+
+    hls.httpBindAddress = host;
+    hls.httpPort = value;
+    return true;
+}
+
+// Parse --fps: frames per second, 1-120
+bool parseFps(const std::string& spec, int& fps) {
+    int value = 0;
+    char trailing = 0;
+    if (std::sscanf(spec.c_str(), "%d%c", &value, &trailing) != 1 || value < 1 || value > 120) {
+        Logger::error("Invalid --fps value: '" + spec + "' (expected 1-120)");
+        return false;
+    }
+    fps = value;
+    return true;
+}
+
+// Parse --cpu-budget: cores for the whole process, 1-1024
+bool parseCpuBudget(const std::string& spec, int& cores) {
+    int value = 0;
+    char trailing = 0;
+    if (std::sscanf(spec.c_str(), "%d%c", &value, &trailing) != 1 || value < 1 || value > 1024) {
+        Logger::error("Invalid --cpu-budget value: '" + spec + "' (expected 1-1024 cores)");
+        return false;
+    }
+    cores = value;
+    return true;
 }
 
 // Helper function to check if string is a URL
@@ -110,43 +255,204 @@ bool validateOutputDir(const std::string& outputDir) {
     return true;
 }
 
+// Run every channel to completion. Channels are opened one after the other (browser
+// channels share one CEF instance), then each runs on its own thread: browser channels
+// sleep on their frame clock between frames, so idle channels cost almost nothing
+bool runChannels(const std::vector<AppConfig>& channels, const std::string& ffmpegLibDir) {
+    std::vector<std::unique_ptr<HLSGenerator>> generators;
+    for (const AppConfig& channel : channels) {
+        auto generator = std::make_unique<HLSGenerator>(channel);
+        if (!generator->initialize(ffmpegLibDir)) {
+            Logger::error("Failed to initialize HLS generator for " + channel.hls.inputFile);
+            return false;
+        }
+        generator->setInterruptCallback([]() -> bool {
+            return g_interrupted.load();
+        });
+        generators.push_back(std::move(generator));
+    }
+
+    std::atomic<int> failed(0);
+    auto run = [&failed](HLSGenerator& generator, const AppConfig& channel) {
+        if (!generator.generate()) {
+            if (g_interrupted.load()) {
+                Logger::info("Stream interrupted by user");
+            } else {
+                Logger::error("Failed to generate HLS stream for " + channel.hls.inputFile);
+                failed++;
+            }
+        }
+    };
+
+    if (generators.size() == 1) {
+        run(*generators[0], channels[0]);
+        return failed == 0;
+    }
+
+    // Channels are independent: one ending (or failing) does not stop the others
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < generators.size(); i++) {
+        threads.emplace_back(run, std::ref(*generators[i]), std::cref(channels[i]));
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return failed == 0;
+}
+
 int main(int argc, char* argv[]) {
     // Parse command line arguments
-    bool enable_js_injection = true;  // Enabled by default
-    int arg_index = 1;
+    AppConfig config;
+    std::vector<std::string> positional;
+    std::vector<std::string> backups;
 
-    // Check for --no-js flag
-    if (argc > 1 && strcmp(argv[1], "--no-js") == 0) {
-        enable_js_injection = false;
-        arg_index = 2;  // Skip the flag
-    }
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
 
-    // Validate we have exactly 2 remaining arguments: <input> <output>
-    int required_args = 2;
-    int remaining_args = argc - arg_index;
+        if (arg == "--no-js") {
+            config.browser.enableJsInjection = false;
+        } else if (arg == "--fps") {
+            if (i + 1 >= argc || !parseFps(argv[++i], config.video.fps)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--cpu-budget") {
+            if (i + 1 >= argc || !parseCpuBudget(argv[++i], config.threading.cpuBudget)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--begin-frame") {
+            config.browser.externalBeginFrame = true;
+        } else if (arg == "--ll-hls") {
+            config.hls.lowLatency = true;
+        } else if (arg == "--fmp4") {
+            config.hls.segmentFormat = SegmentFormat::FMP4;
+        } else if (arg == "--sync-writes") {
+            config.hls.asyncWrites = false;
+        } else if (arg == "--sequential-vod") {
+            config.hls.parallelVod = false;
+        } else if (arg == "--serve") {
+            if (i + 1 >= argc || !parseServe(argv[++i], config.hls)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--no-disk") {
+            config.hls.writeToDisk = false;
+        } else if (arg == "--backup") {
+            if (i + 1 >= argc) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            backups.push_back(argv[++i]);
+        } else if (arg == "--ladder") {
+            if (i + 1 >= argc || !parseLadder(argv[++i], config.video.renditions)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+            Logger::error("Unknown option: " + arg);
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            positional.push_back(arg);
+        }
+    }
 
-    if (remaining_args != required_args) {
+    // Validate positional arguments: one or more <input> <output> pairs
+    if (positional.empty() || positional.size() % 2 != 0) {
         printUsage(argv[0]);
         return 1;
     }
 
-    AppConfig config;
-    config.hls.inputFile = argv[arg_index];
-    config.hls.outputDir = argv[arg_index + 1];
-    config.browser.enableJsInjection = enable_js_injection;
+    if (!config.hls.writeToDisk && config.hls.httpPort == 0) {
+        Logger::error("--no-disk requires --serve (segments would not be available anywhere)");
+        return 1;
+    }
 
-    // Validate input and output before proceeding (fail-fast)
-    if (!validateInput(config.hls.inputFile)) {
+    // LL-HLS parts and inline writes go straight to the output directory; only write-behind output fills the store
+    if (!config.hls.writeToDisk && (config.hls.lowLatency || !config.hls.asyncWrites)) {
+        Logger::error("--no-disk cannot be combined with --ll-hls or --sync-writes (their output is written to disk)");
         return 1;
     }
 
-    if (!validateOutputDir(config.hls.outputDir)) {
+    if (backups.size() > positional.size() / 2) {
+        Logger::error("More --backup inputs than channels");
         return 1;
     }
 
+    // One channel per pair, same options; each channel serves on its own port
+    std::vector<AppConfig> channels;
+    const int channelCores = ThreadBudget::coresPerChannel(config.threading.cpuBudget, positional.size() / 2);
+    for (size_t i = 0; i < positional.size(); i += 2) {
+        AppConfig channel = config;
+        channel.threading.channelCores = channelCores;
+        channel.hls.inputFile = positional[i];
+        channel.hls.outputDir = positional[i + 1];
+        if (channels.size() < backups.size()) {
+            channel.hls.backupInput = backups[channels.size()];
+        }
+        if (config.hls.httpPort > 0) {
+            channel.hls.httpPort = config.hls.httpPort + static_cast<int>(channels.size());
+        }
+        for (const AppConfig& other : channels) {
+            if (other.hls.outputDir == channel.hls.outputDir) {
+                Logger::error("Output directory used by more than one channel: " + channel.hls.outputDir);
+                return 1;
+            }
+        }
+        channels.push_back(channel);
+    }
+
+    // Validate input and output before proceeding (fail-fast)
+    for (const AppConfig& channel : channels) {
+        if (!validateInput(channel.hls.inputFile)) {
+            return 1;
+        }
+        if (!channel.hls.backupInput.empty() && !validateInput(channel.hls.backupInput)) {
+            return 1;
+        }
+
+        if (!validateOutputDir(channel.hls.outputDir)) {
+            return 1;
+        }
+    }
+
     Logger::info("=== HLS Generator ===");
-    Logger::info("Input: " + config.hls.inputFile);
-    Logger::info("Output: " + config.hls.outputDir);
+    for (const AppConfig& channel : channels) {
+        Logger::info("Input: " + channel.hls.inputFile);
+        if (!channel.hls.backupInput.empty()) {
+            Logger::info("Backup: " + channel.hls.backupInput);
+        }
+        Logger::info("Output: " + channel.hls.outputDir);
+    }
+    if (channels.size() > 1) {
+        Logger::info("Channels: " + std::to_string(channels.size()));
+    }
+    if (!config.video.renditions.empty()) {
+        std::string ladder;
+        for (const RenditionConfig& rendition : config.video.renditions) {
+            ladder += (ladder.empty() ? "" : ", ") + rendition.name;
+        }
+        Logger::info("Ladder: " + ladder);
+    }
+    if (config.threading.cpuBudget > 0) {
+        Logger::info("CPU budget: " + std::to_string(config.threading.cpuBudget) + " cores (" +
+                     std::to_string(channelCores) + " per channel)");
+    }
+    if (config.hls.segmentFormat == SegmentFormat::FMP4) {
+        Logger::info("Segments: fMP4 (CMAF)");
+    }
+    if (config.hls.lowLatency) {
+        Logger::info("Low-Latency HLS: " + std::to_string(config.hls.partDurationMs) + "ms parts");
+    }
+    if (config.hls.httpPort > 0) {
+        std::string ports = std::to_string(config.hls.httpPort);
+        if (channels.size() > 1) {
+            ports += "-" + std::to_string(config.hls.httpPort + static_cast<int>(channels.size()) - 1);
+        }
+        Logger::info("HTTP origin: " + config.hls.httpBindAddress + ":" + ports +
+                     (config.hls.writeToDisk ? "" : " (memory only)"));
+    }
     Logger::info("");
 
     std::signal(SIGINT, signalHandler);
@@ -163,26 +469,10 @@ int main(int argc, char* argv[]) {
     Logger::info("FFmpeg libraries detected from: " + obsPaths.source);
     Logger::info("");
 
-    HLSGenerator generator(config);
-
-    if (!generator.initialize(obsPaths.ffmpegLibDir)) {
-        Logger::error("Failed to initialize HLS generator");
+    if (!runChannels(channels, obsPaths.ffmpegLibDir)) {
         return 1;
     }
 
-    generator.setInterruptCallback([]() -> bool {
-        return g_interrupted.load();
-    });
-
-    if (!generator.generate()) {
-        if (g_interrupted.load()) {
-            Logger::info("Stream interrupted by user");
-        } else {
-            Logger::error("Failed to generate HLS stream");
-            return 1;
-        }
-    }
-
     Logger::info("");
     Logger::info("Process completed successfully");
 
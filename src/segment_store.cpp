@@ -0,0 +1,88 @@
+#include "segment_store.h"
+
+#include <algorithm>
+
+SegmentStore::SegmentStore(size_t maxMediaFiles)
+    : maxMediaFiles_(maxMediaFiles > 0 ? maxMediaFiles : 1) {
+}
+
+void SegmentStore::put(const std::string& name, Data data) {
+    if (!data) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = files_.find(name);
+    if (it != files_.end()) {
+        totalBytes_ -= it->second->size();
+        it->second = data;
+    } else {
+        files_.emplace(name, data);
+        if (!isPlaylist(name) && pinned_.count(name) == 0) {
+            mediaOrder_.push_back(name);
+        }
+    }
+    totalBytes_ += data->size();
+
+    if (isPlaylist(name)) {
+        pinMapUris(*data);
+    }
+
+    while (mediaOrder_.size() > maxMediaFiles_) {
+        auto oldest = files_.find(mediaOrder_.front());
+        if (oldest != files_.end()) {
+            totalBytes_ -= oldest->second->size();
+            files_.erase(oldest);
+        }
+        mediaOrder_.pop_front();
+    }
+}
+
+SegmentStore::Data SegmentStore::get(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = files_.find(name);
+    return it != files_.end() ? it->second : nullptr;
+}
+
+void SegmentStore::remove(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = files_.find(name);
+    if (it == files_.end()) {
+        return;
+    }
+
+    totalBytes_ -= it->second->size();
+    files_.erase(it);
+    pinned_.erase(name);
+    mediaOrder_.erase(std::remove(mediaOrder_.begin(), mediaOrder_.end(), name), mediaOrder_.end());
+}
+
+size_t SegmentStore::getTotalBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return totalBytes_;
+}
+
+void SegmentStore::pinMapUris(const std::vector<uint8_t>& playlist) {
+    // Caller holds mutex_. The init segment is put before the first playlist that maps it,
+    // so it is still in the ring here and moves out of it
+    const std::string tag = "#EXT-X-MAP:URI=\"";
+    const std::string text(playlist.begin(), playlist.end());
+    for (size_t pos = text.find(tag); pos != std::string::npos; pos = text.find(tag, pos)) {
+        pos += tag.size();
+        size_t end = text.find('"', pos);
+        if (end == std::string::npos) {
+            break;
+        }
+        std::string uri = text.substr(pos, end - pos);
+        if (pinned_.insert(uri).second) {
+            mediaOrder_.erase(std::remove(mediaOrder_.begin(), mediaOrder_.end(), uri), mediaOrder_.end());
+        }
+    }
+}
+
+bool SegmentStore::isPlaylist(const std::string& name) {
+    const std::string suffix = ".m3u8";
+    return name.size() >= suffix.size() &&
+           name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
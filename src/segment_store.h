@@ -0,0 +1,74 @@
+#ifndef SEGMENT_STORE_H
+#define SEGMENT_STORE_H
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * SegmentStore - In-memory copy of the published HLS files for the HTTP origin
+ *
+ * SegmentWriter's I/O thread puts every completed file here (in publish order,
+ * so a playlist never lists a segment the store does not have yet) and removes
+ * segments once they left the live window. Media segments live in a ring of
+ * maxMediaFiles entries (the playlist window of every variant plus a grace
+ * segment); the oldest is dropped when the ring is full. Playlists are always
+ * kept (they are replaced on every update), and so are init segments: an fMP4
+ * init segment is written once per variant, so every file a stored playlist
+ * references with #EXT-X-MAP is pinned outside the ring.
+ *
+ * Files are shared immutable buffers: readers keep a reference while sending,
+ * so removal never invalidates a response in flight.
+ *
+ * Thread-safety: All methods are thread-safe
+ */
+class SegmentStore {
+public:
+    using Data = std::shared_ptr<const std::vector<uint8_t>>;
+
+    /**
+     * @param maxMediaFiles Maximum number of media segments kept (init segments are not counted)
+     */
+    explicit SegmentStore(size_t maxMediaFiles);
+
+    /**
+     * Add or replace a file
+     * @param name File name (as listed in playlists)
+     * @param data File content
+     */
+    void put(const std::string& name, Data data);
+
+    /**
+     * Look up a file
+     * @return File content, or nullptr if not in the store
+     */
+    Data get(const std::string& name) const;
+
+    /**
+     * Drop a file (no-op if absent)
+     */
+    void remove(const std::string& name);
+
+    /**
+     * Total size of all stored files in bytes
+     */
+    size_t getTotalBytes() const;
+
+private:
+    static bool isPlaylist(const std::string& name);
+    void pinMapUris(const std::vector<uint8_t>& playlist);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Data> files_;
+    std::deque<std::string> mediaOrder_;  // Media segments, oldest first
+    std::unordered_set<std::string> pinned_;  // Init segments (#EXT-X-MAP), never evicted
+    size_t maxMediaFiles_;
+    size_t totalBytes_ = 0;
+};
+
+#endif // SEGMENT_STORE_H
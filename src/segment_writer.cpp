@@ -0,0 +1,371 @@
+#include "segment_writer.h"
+#include "segment_store.h"
+#include "ffmpeg_context.h"
+#include "logger.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavformat/avio.h>
+}
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+
+namespace {
+    constexpr double SLOW_WRITE_WARN_MS = 1000.0;          // Log writes slower than this
+    constexpr size_t RETIRED_SEGMENTS_PER_PLAYLIST = 1;    // Grace period for players still loading old segments
+    constexpr double BYTES_PER_MB = 1024.0 * 1024.0;
+
+    bool endsWith(const std::string& value, const std::string& suffix) {
+        return value.size() >= suffix.size() &&
+               value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    std::string formatMB(size_t bytes) {
+        std::ostringstream out;
+        out.precision(1);
+        out << std::fixed << bytes / BYTES_PER_MB << " MB";
+        return out.str();
+    }
+}
+
+SegmentWriter::SegmentWriter(std::shared_ptr<FFmpegContext> ctx, const Options& options)
+    : ffmpeg_(std::move(ctx)), options_(options) {
+    // One staging directory per output directory, outside of it (never served to players)
+    std::error_code ec;
+    std::filesystem::path outputPath = std::filesystem::absolute(options_.outputDir, ec);
+    size_t hash = std::hash<std::string>{}(outputPath.string());
+    stagingDir_ = (std::filesystem::temp_directory_path(ec) / ("hls-generator-" + std::to_string(hash))).string();
+}
+
+SegmentWriter::~SegmentWriter() {
+    stop();
+    detach();
+
+    std::error_code ec;
+    std::filesystem::remove_all(stagingDir_, ec);
+}
+
+bool SegmentWriter::start() {
+    if (ioThread_.joinable()) {
+        return true;
+    }
+
+    // Start from an empty staging directory: the muxer appends to playlists it finds there
+    std::error_code ec;
+    std::filesystem::remove_all(stagingDir_, ec);
+    if (!std::filesystem::create_directories(stagingDir_, ec) && ec) {
+        Logger::error("Failed to create staging directory " + stagingDir_ + ": " + ec.message());
+        return false;
+    }
+
+    stopping_ = false;
+    ioThread_ = std::thread(&SegmentWriter::ioThreadLoop, this);
+
+    Logger::info("Segment writer started (write-behind, " + formatMB(options_.memoryLimitBytes) + " buffer limit)");
+    return true;
+}
+
+std::string SegmentWriter::stagingPath(const std::string& playlistName) const {
+    return stagingDir_ + "/" + playlistName;
+}
+
+void SegmentWriter::attach(AVFormatContext* outputFormatCtx) {
+    // Reads (e.g. append_list re-reading a playlist) still go to the default handler
+    defaultIoOpen_ = outputFormatCtx->io_open;
+    defaultIoClose_ = outputFormatCtx->io_close2;
+
+    outputFormatCtx->opaque = this;
+    outputFormatCtx->io_open = &SegmentWriter::ioOpen;
+    outputFormatCtx->io_close2 = &SegmentWriter::ioClose;
+}
+
+void SegmentWriter::detach() {
+    if (openFiles_.empty()) {
+        return;
+    }
+
+    Logger::warn("Discarding " + std::to_string(openFiles_.size()) + " unfinished output file(s)");
+    for (auto& entry : openFiles_) {
+        uint8_t* buffer = nullptr;
+        ffmpeg_->avio_close_dyn_buf(entry.first, &buffer);
+        ffmpeg_->av_free(buffer);
+    }
+    openFiles_.clear();
+}
+
+void SegmentWriter::stop() {
+    if (!ioThread_.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    jobCond_.notify_all();
+    ioThread_.join();
+
+    Stats stats = getStats();
+    Logger::info("Segment writer: " + std::to_string(stats.filesWritten) + " files, " +
+                 formatMB(stats.bytesWritten) + " written, peak queue " + formatMB(stats.peakQueuedBytes) +
+                 ", slowest write " + std::to_string(static_cast<int>(stats.maxWriteMs)) + " ms, " +
+                 std::to_string(stats.stalls) + " stall(s)");
+}
+
+SegmentWriter::Stats SegmentWriter::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.queuedFiles = jobs_.size() + (writing_ ? 1 : 0);
+    return stats;
+}
+
+void SegmentWriter::logStats() {
+    Stats stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats = stats_;
+        stats.queuedFiles = jobs_.size() + (writing_ ? 1 : 0);
+        stats_.recentMaxWriteMs = 0.0;
+    }
+
+    Logger::info("Segment writer: queue " + std::to_string(stats.queuedFiles) + " file(s) / " +
+                 formatMB(stats.queuedBytes) + ", slowest write " +
+                 std::to_string(static_cast<int>(stats.recentMaxWriteMs)) + " ms (" +
+                 std::to_string(static_cast<int>(stats.maxWriteMs)) + " ms overall), " +
+                 std::to_string(stats.stalls) + " stall(s)");
+}
+
+// ===== AVIO callbacks (muxing thread) =====
+
+int SegmentWriter::ioOpen(AVFormatContext* s, AVIOContext** pb, const char* url, int flags, AVDictionary** options) {
+    SegmentWriter* self = static_cast<SegmentWriter*>(s->opaque);
+    if (!self) {
+        return AVERROR(EINVAL);
+    }
+
+    if (!(flags & AVIO_FLAG_WRITE)) {
+        return self->defaultIoOpen_ ? self->defaultIoOpen_(s, pb, url, flags, options) : AVERROR(ENOSYS);
+    }
+
+    int ret = self->ffmpeg_->avio_open_dyn_buf(pb);
+    if (ret < 0) {
+        Logger::error(std::string("Failed to allocate memory output for ") + url);
+        return ret;
+    }
+
+    self->openFiles_[*pb] = url;
+    return 0;
+}
+
+int SegmentWriter::ioClose(AVFormatContext* s, AVIOContext* pb) {
+    SegmentWriter* self = static_cast<SegmentWriter*>(s->opaque);
+    if (!self || !pb) {
+        return 0;
+    }
+
+    auto it = self->openFiles_.find(pb);
+    if (it == self->openFiles_.end()) {
+        return self->defaultIoClose_ ? self->defaultIoClose_(s, pb) : 0;
+    }
+    std::string url = it->second;
+    self->openFiles_.erase(it);
+
+    uint8_t* buffer = nullptr;
+    int size = self->ffmpeg_->avio_close_dyn_buf(pb, &buffer);
+    auto data = std::make_shared<std::vector<uint8_t>>(buffer, buffer + (size > 0 ? size : 0));
+    self->ffmpeg_->av_free(buffer);
+
+    Job job;
+    job.name = std::filesystem::path(url).filename().string();
+    job.data = data;
+    job.playlist = endsWith(job.name, ".m3u8") || endsWith(job.name, ".m3u8.tmp");
+
+    if (job.playlist) {
+        // The muxer renames its temp playlist and re-reads it later: keep the staging copy current
+        std::ofstream staging(url, std::ios::binary | std::ios::trunc);
+        staging.write(reinterpret_cast<const char*>(data->data()), static_cast<std::streamsize>(data->size()));
+
+        if (endsWith(job.name, ".tmp")) {
+            job.name.resize(job.name.size() - 4);
+        }
+    }
+
+    self->enqueue(std::move(job));
+    return 0;
+}
+
+// ===== Queue =====
+
+void SegmentWriter::enqueue(Job job) {
+    if (!ioThread_.joinable()) {
+        publish(job);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    stats_.queuedBytes += job.data->size();
+    stats_.peakQueuedBytes = std::max(stats_.peakQueuedBytes, stats_.queuedBytes);
+    jobs_.push_back(std::move(job));
+    jobCond_.notify_one();
+
+    // Backpressure: storage is too far behind, hold the muxer until memory is back under the limit
+    if (stats_.queuedBytes > options_.memoryLimitBytes) {
+        stats_.stalls++;
+        Logger::warn("Storage is falling behind: " + formatMB(stats_.queuedBytes) + " queued, waiting for the writer");
+        spaceCond_.wait(lock, [this]() {
+            return stopping_ || stats_.queuedBytes <= options_.memoryLimitBytes || jobs_.empty();
+        });
+    }
+}
+
+void SegmentWriter::ioThreadLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            jobCond_.wait(lock, [this]() { return stopping_ || !jobs_.empty(); });
+            if (jobs_.empty()) {
+                break;  // Stopping and drained
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+            writing_ = true;
+        }
+
+        auto writeStart = std::chrono::steady_clock::now();
+        bool written = publish(job);
+        double writeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - writeStart).count();
+
+        if (written && job.playlist && !firstSegmentPublished_) {
+            checkFirstSegment(job);
+        }
+        if (written && job.playlist && options_.deleteOldSegments) {
+            retireUnreferenced(job);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            writing_ = false;
+            stats_.queuedBytes -= job.data->size();
+            stats_.maxWriteMs = std::max(stats_.maxWriteMs, writeMs);
+            stats_.recentMaxWriteMs = std::max(stats_.recentMaxWriteMs, writeMs);
+            if (written) {
+                stats_.filesWritten++;
+                stats_.bytesWritten += job.data->size();
+            }
+        }
+        spaceCond_.notify_all();
+
+        if (writeMs > SLOW_WRITE_WARN_MS) {
+            Logger::warn("Slow storage: writing " + job.name + " took " + std::to_string(static_cast<int>(writeMs)) + " ms");
+        }
+    }
+}
+
+bool SegmentWriter::publish(const Job& job) {
+    if (options_.store) {
+        options_.store->put(job.name, job.data);
+    }
+    return options_.writeToDisk ? writeFile(job) : true;
+}
+
+bool SegmentWriter::writeFile(const Job& job) {
+    // Temp file + rename: players never see a partially written segment or playlist
+    std::string path = options_.outputDir + "/" + job.name;
+    std::string tmpPath = path + ".tmp";
+
+    std::FILE* file = std::fopen(tmpPath.c_str(), "wb");
+    if (!file) {
+        Logger::error("Failed to open output file: " + tmpPath);
+        return false;
+    }
+
+    size_t written = std::fwrite(job.data->data(), 1, job.data->size(), file);
+    bool ok = (std::fclose(file) == 0) && written == job.data->size();
+    if (!ok) {
+        Logger::error("Failed to write output file: " + tmpPath);
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        Logger::error("Failed to publish " + path + ": " + ec.message());
+        return false;
+    }
+    return true;
+}
+
+void SegmentWriter::checkFirstSegment(const Job& playlistJob) {
+    // The first media playlist with an entry is the moment players can start
+    std::string text(playlistJob.data->begin(), playlistJob.data->end());
+    if (text.find("#EXTINF") == std::string::npos) {
+        return;
+    }
+    firstSegmentPublished_ = true;
+    if (options_.startTime == std::chrono::steady_clock::time_point{}) {
+        return;
+    }
+
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - options_.startTime).count();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.timeToFirstSegmentMs = elapsedMs;
+    }
+    Logger::info("Time to first segment: " + std::to_string(static_cast<int>(elapsedMs)) + " ms (" + playlistJob.name + ")");
+}
+
+void SegmentWriter::retireUnreferenced(const Job& playlistJob) {
+    std::string text(playlistJob.data->begin(), playlistJob.data->end());
+    if (text.find("#EXT-X-STREAM-INF") != std::string::npos) {
+        return;  // Master playlist lists playlists, not segments
+    }
+
+    // Media playlist: URI lines plus the init segment of #EXT-X-MAP
+    std::set<std::string> refs;
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+        if (line[0] != '#') {
+            refs.insert(line);
+        } else if (line.compare(0, 11, "#EXT-X-MAP:") == 0) {
+            size_t start = line.find("URI=\"");
+            size_t end = start == std::string::npos ? start : line.find('"', start + 5);
+            if (end != std::string::npos) {
+                refs.insert(line.substr(start + 5, end - start - 5));
+            }
+        }
+    }
+
+    std::set<std::string>& previous = playlistRefs_[playlistJob.name];
+    for (const std::string& uri : previous) {
+        if (!refs.count(uri)) {
+            retiredFiles_.push_back(uri);
+        }
+    }
+    previous = std::move(refs);
+
+    while (retiredFiles_.size() > playlistRefs_.size() * RETIRED_SEGMENTS_PER_PLAYLIST) {
+        if (options_.writeToDisk) {
+            std::error_code ec;
+            std::filesystem::remove(options_.outputDir + "/" + retiredFiles_.front(), ec);
+        }
+        if (options_.store) {
+            options_.store->remove(retiredFiles_.front());
+        }
+        retiredFiles_.pop_front();
+    }
+}
@@ -0,0 +1,158 @@
+#ifndef SEGMENT_WRITER_H
+#define SEGMENT_WRITER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+class FFmpegContext;
+class SegmentStore;
+struct AVFormatContext;
+struct AVIOContext;
+struct AVDictionary;
+
+/**
+ * SegmentWriter - Write-behind file output for the hls muxer
+ *
+ * Storage latency (slow disk, NFS, fsync stalls) used to block the muxing
+ * thread, and with it decoding/encoding. The writer installs io_open/io_close2
+ * callbacks on the output context, so the muxer writes every file (segments,
+ * init segments, playlists) into an in-memory AVIO buffer. When the muxer
+ * closes a file, the complete buffer is queued and a dedicated I/O thread
+ * writes it to the output directory (temp file + rename, so readers never see
+ * partial files). Jobs run in order, so a playlist is only published after the
+ * segments it lists are on disk. With a SegmentStore, the same buffers are
+ * also published in memory for the HTTP origin (disk writes become optional).
+ *
+ * The muxer keeps its playlists in a local staging directory (stagingPath()):
+ * it re-reads them (append_list) and renames its own temp files there, while
+ * the I/O thread publishes a copy to the output directory.
+ *
+ * Memory is bounded: if more than memoryLimitBytes are queued, the muxer waits
+ * for the I/O thread (counted as a stall in Stats).
+ *
+ * Thread-safety: attach/detach and the AVIO callbacks on the muxing thread;
+ *                getStats/logStats from any thread
+ */
+class SegmentWriter {
+public:
+    struct Options {
+        std::string outputDir;
+        size_t memoryLimitBytes = 64 * 1024 * 1024;
+        bool deleteOldSegments = false;  // Delete segments that left every media playlist (live window)
+        bool writeToDisk = true;         // false: only publish to the store (HTTP origin without disk)
+        SegmentStore* store = nullptr;   // Optional in-memory copy for the HTTP origin
+        std::chrono::steady_clock::time_point startTime{};  // Input open; time to first segment is logged from it
+    };
+
+    struct Stats {
+        size_t queuedFiles = 0;       // Files waiting for the I/O thread
+        size_t queuedBytes = 0;
+        size_t peakQueuedBytes = 0;
+        uint64_t filesWritten = 0;
+        uint64_t bytesWritten = 0;
+        double maxWriteMs = 0.0;      // Slowest single file write
+        double recentMaxWriteMs = 0.0;  // Slowest write since the last logStats()
+        uint64_t stalls = 0;          // Times the muxer waited for the memory limit
+        double timeToFirstSegmentMs = -1.0;  // startTime → first playlist listing a segment (-1: not yet)
+    };
+
+    SegmentWriter(std::shared_ptr<FFmpegContext> ctx, const Options& options);
+    ~SegmentWriter();
+
+    // No copy, no move (output contexts hold a pointer to this)
+    SegmentWriter(const SegmentWriter&) = delete;
+    SegmentWriter& operator=(const SegmentWriter&) = delete;
+
+    /**
+     * Create the staging directory and start the I/O thread
+     * @return true on success
+     */
+    bool start();
+
+    /**
+     * Path of a playlist in the staging directory (use as the hls muxer URL)
+     * @param playlistName Playlist file name, e.g. "playlist.m3u8"
+     */
+    std::string stagingPath(const std::string& playlistName) const;
+
+    /**
+     * Route all file I/O of an output context through the writer
+     * Must be called before avformat_write_header()
+     * @param outputFormatCtx hls output context
+     */
+    void attach(AVFormatContext* outputFormatCtx);
+
+    /**
+     * Drop buffers of files the muxer never closed
+     * Call after the attached output context was freed
+     */
+    void detach();
+
+    /**
+     * Drain the queue and stop the I/O thread (logs a summary)
+     */
+    void stop();
+
+    /**
+     * Snapshot of queue depth and write metrics
+     */
+    Stats getStats() const;
+
+    /**
+     * Log queue depth and write latency (called with the periodic runtime stats)
+     * Resets recentMaxWriteMs
+     */
+    void logStats();
+
+private:
+    struct Job {
+        std::string name;  // File name in the output directory
+        std::shared_ptr<const std::vector<uint8_t>> data;
+        bool playlist = false;
+    };
+
+    static int ioOpen(AVFormatContext* s, AVIOContext** pb, const char* url, int flags, AVDictionary** options);
+    static int ioClose(AVFormatContext* s, AVIOContext* pb);
+
+    void enqueue(Job job);
+    void ioThreadLoop();
+    bool publish(const Job& job);
+    bool writeFile(const Job& job);
+    void retireUnreferenced(const Job& playlistJob);
+    void checkFirstSegment(const Job& playlistJob);
+
+    std::shared_ptr<FFmpegContext> ffmpeg_;
+    Options options_;
+    std::string stagingDir_;
+
+    // ===== Muxing thread state =====
+    int (*defaultIoOpen_)(AVFormatContext*, AVIOContext**, const char*, int, AVDictionary**) = nullptr;
+    int (*defaultIoClose_)(AVFormatContext*, AVIOContext*) = nullptr;
+    std::map<AVIOContext*, std::string> openFiles_;  // Memory AVIO -> URL given by the muxer
+
+    // ===== I/O thread state =====
+    std::thread ioThread_;
+    std::map<std::string, std::set<std::string>> playlistRefs_;  // Media playlist -> listed files
+    std::deque<std::string> retiredFiles_;                        // Unlisted, deleted after a grace period
+    bool firstSegmentPublished_ = false;
+
+    // ===== Shared state (guarded by mutex_) =====
+    mutable std::mutex mutex_;
+    std::condition_variable jobCond_;    // I/O thread: new job or stop
+    std::condition_variable spaceCond_;  // Muxer/flush: job finished
+    std::deque<Job> jobs_;
+    bool writing_ = false;               // I/O thread is writing a dequeued job
+    bool stopping_ = false;
+    Stats stats_;
+};
+
+#endif // SEGMENT_WRITER_H
@@ -0,0 +1,379 @@
+#include "staged_transcoder.h"
+#include "ffmpeg_context.h"
+#include "video_pipeline.h"
+#include "audio_pipeline.h"
+#include "input_timeline.h"
+#include "logger.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+#include <thread>
+
+// Queue depths between stages (packets are small, raw frames are not)
+namespace {
+    constexpr size_t DECODE_QUEUE_CAPACITY = 64;    // Compressed video packets
+    constexpr size_t SCALE_QUEUE_CAPACITY = 8;      // Decoded frames per rendition (~3 MB each at 1080p)
+    constexpr size_t ENCODE_QUEUE_CAPACITY = 8;     // Scaled frames per rendition
+    constexpr size_t MUX_QUEUE_CAPACITY = 256;      // Encoded video + input audio packets
+    constexpr int FRAME_LOG_INTERVAL = 100;         // Log every N frames
+    constexpr size_t SCALED_FRAMES_IN_STAGES = 2;   // Scaled frames outside the encode queue (being scaled / encoded)
+    constexpr int64_t POOL_WARMUP_FRAMES = 500;     // Every queue has filled by then: later pool growth is per-frame allocation
+}
+
+StagedTranscoder::Lane::Lane(const Rendition& r)
+    : rendition(r)
+    , scaleQueue(SCALE_QUEUE_CAPACITY)
+    , encodeQueue(ENCODE_QUEUE_CAPACITY) {
+}
+
+StagedTranscoder::StagedTranscoder(std::shared_ptr<FFmpegContext> ctx,
+                                   VideoPipeline& decoderPipeline,
+                                   const std::vector<Rendition>& renditions,
+                                   AudioPipeline& audioPipeline)
+    : ffmpeg_(ctx)
+    , pool_(ctx)
+    , decoder_(decoderPipeline)
+    , audio_(audioPipeline)
+    , decodeQueue_(DECODE_QUEUE_CAPACITY)
+    , muxQueue_(MUX_QUEUE_CAPACITY) {
+    for (const Rendition& rendition : renditions) {
+        lanes_.push_back(std::make_unique<Lane>(rendition));
+    }
+}
+
+StagedTranscoder::~StagedTranscoder() = default;
+
+bool StagedTranscoder::run(const Streams& streams, const std::function<bool()>& interruptCallback) {
+    streams_ = streams;
+
+    if (!decoder_.getInputCodecContext() || lanes_.empty()) {
+        Logger::error("Video decoder/encoder not initialized");
+        return false;
+    }
+    for (const auto& lane : lanes_) {
+        if (!lane->rendition.pipeline || !lane->rendition.pipeline->getOutputCodecContext()) {
+            Logger::error("Video decoder/encoder not initialized");
+            return false;
+        }
+    }
+
+    Logger::info("Starting staged transcode pipeline (demux → decode → scale → encode → mux), " +
+                 std::to_string(lanes_.size()) + " rendition(s)");
+
+    // Scaled-frame ring: every slot of the encode queue plus the frames held by the scaler and encoder
+    for (const auto& lane : lanes_) {
+        if (!lane->rendition.pipeline->reserveScaledFrames(ENCODE_QUEUE_CAPACITY + SCALED_FRAMES_IN_STAGES)) {
+            Logger::warn("Failed to preallocate scaled frames (they are allocated on demand)");
+        }
+    }
+
+    std::thread decodeThread(&StagedTranscoder::decodeStage, this);
+    std::vector<std::thread> laneThreads;
+    for (size_t i = 0; i < lanes_.size(); i++) {
+        laneThreads.emplace_back(&StagedTranscoder::scaleStage, this, std::ref(*lanes_[i]));
+        laneThreads.emplace_back(&StagedTranscoder::encodeStage, this, std::ref(*lanes_[i]), i);
+    }
+    std::thread muxThread(&StagedTranscoder::muxStage, this);
+
+    // Demux stage runs on the calling thread
+    int64_t videoPacketCount = 0;
+    int64_t audioPacketCount = 0;
+    PacketPtr packet = allocPacket();
+
+    while (packet && !failed_ &&
+           ffmpeg_->av_read_frame(streams_.inputFormatCtx, packet.get()) >= 0) {
+        if (interruptCallback && interruptCallback()) {
+            Logger::info("Processing interrupted by user (Ctrl+C)");
+            break;
+        }
+
+        const bool video = packet->stream_index == streams_.videoStreamIndex;
+        const bool audio = packet->stream_index == streams_.audioStreamIndex && streams_.outputAudioStreamIndex >= 0;
+        if (streams_.timeline && (video || audio) &&
+            !streams_.timeline->onPacket(packet.get(),
+                                         streams_.inputFormatCtx->streams[packet->stream_index]->time_base, video)) {
+            ffmpeg_->av_packet_unref(packet.get());
+            continue;
+        }
+
+        if (video) {
+            videoPacketCount++;
+            if (!decodeQueue_.push(std::move(packet))) {
+                break;
+            }
+            packet = allocPacket();
+        } else if (audio) {
+            audioPacketCount++;
+            MuxItem item;
+            item.packet = std::move(packet);
+            item.isAudio = true;
+            if (!muxQueue_.push(std::move(item))) {
+                break;
+            }
+            packet = allocPacket();
+        } else {
+            ffmpeg_->av_packet_unref(packet.get());
+        }
+    }
+    packet.reset();
+
+    // End of input: each stage drains and closes the queue it feeds
+    decodeQueue_.close();
+    decodeThread.join();
+    for (std::thread& thread : laneThreads) {
+        thread.join();
+    }
+
+    // Mux queue has several producers (encoders + demux), close it once all are done
+    muxQueue_.close();
+    muxThread.join();
+
+    if (failed_) {
+        Logger::error("Staged transcode pipeline failed");
+        return false;
+    }
+
+    // Flush audio decoder and encoder via AudioPipeline (mux thread is gone)
+    if (streams_.outputAudioStreamIndex >= 0) {
+        audio_.flush(streams_.outputFormatCtx, streams_.outputAudioStreamIndex);
+    }
+
+    Logger::info("Demuxed " + std::to_string(videoPacketCount) + " video packets, " +
+                 std::to_string(audioPacketCount) + " audio packets");
+
+    // Growth after warm-up means a stage allocates per frame
+    AVObjectPool::Stats poolStats = pool_.getStats();
+    uint64_t scaledAllocated = 0;
+    uint64_t scaledReused = 0;
+    for (const auto& lane : lanes_) {
+        AVObjectPool::Stats laneStats = lane->rendition.pipeline->getScaledFrameStats();
+        scaledAllocated += laneStats.framesAllocated;
+        scaledReused += laneStats.reused;
+    }
+    Logger::info("Object pools: " + std::to_string(poolStats.packetsAllocated) + " packets + " +
+                 std::to_string(poolStats.framesAllocated) + " frames allocated, " +
+                 std::to_string(poolStats.reused) + " reused; scaled frames: " +
+                 std::to_string(scaledAllocated) + " allocated, " + std::to_string(scaledReused) + " reused");
+    if (warmedUp_) {
+        // Bounded by the queue depths: a count that grows with the stream length is a per-frame allocation
+        Logger::info("Object pools: " + std::to_string(countAllocations() - warmupAllocations_) +
+                     " packets/frames allocated after the first " + std::to_string(POOL_WARMUP_FRAMES) + " frames");
+    }
+    return true;
+}
+
+uint64_t StagedTranscoder::countAllocations() const {
+    AVObjectPool::Stats stats = pool_.getStats();
+    uint64_t count = stats.packetsAllocated + stats.framesAllocated;
+    for (const auto& lane : lanes_) {
+        count += lane->rendition.pipeline->getScaledFrameStats().framesAllocated;
+    }
+    return count;
+}
+
+void StagedTranscoder::decodeStage() {
+    AVCodecContext* decoderCtx = decoder_.getInputCodecContext();
+    PacketPtr packet;
+    int64_t nextPts = streams_.firstVideoPts;
+
+    while (decodeQueue_.pop(packet)) {
+        if (ffmpeg_->avcodec_send_packet(decoderCtx, packet.get()) < 0) {
+            Logger::error("Error sending packet to decoder");
+            continue;
+        }
+        packet.reset();
+
+        if (!drainDecoder(nextPts)) {
+            break;
+        }
+    }
+
+    // Drain decoder (flush remaining frames)
+    if (!failed_) {
+        ffmpeg_->avcodec_send_packet(decoderCtx, nullptr);
+        drainDecoder(nextPts);
+    }
+
+    for (const auto& lane : lanes_) {
+        lane->scaleQueue.close();
+    }
+}
+
+bool StagedTranscoder::drainDecoder(int64_t& nextPts) {
+    AVCodecContext* decoderCtx = decoder_.getInputCodecContext();
+
+    while (true) {
+        FramePtr frame = allocFrame();
+        if (!frame) {
+            return false;
+        }
+
+        if (ffmpeg_->avcodec_receive_frame(decoderCtx, frame.get()) != 0) {
+            return true;  // EAGAIN / EOF: decoder needs more input
+        }
+
+        int64_t count = ++frameCount_;
+        if (count == POOL_WARMUP_FRAMES) {
+            warmupAllocations_ = countAllocations();
+            warmedUp_ = true;
+        }
+        if (count % FRAME_LOG_INTERVAL == 0) {
+            Logger::info("Transcoded " + std::to_string(count) + " frames");
+            if (progressCallback_) {
+                progressCallback_();
+            }
+        }
+
+        // Same PTS for every rendition keeps variant segments aligned
+        frame->pts = nextPts++;
+
+        if (!fanOut(std::move(frame))) {
+            return false;
+        }
+    }
+}
+
+bool StagedTranscoder::fanOut(FramePtr frame) {
+    // Every lane but the last gets a new reference to the same decoded buffers
+    for (size_t i = 0; i + 1 < lanes_.size(); i++) {
+        FramePtr ref = allocFrame();
+        if (!ref) {
+            return false;
+        }
+        if (ffmpeg_->av_frame_ref(ref.get(), frame.get()) < 0) {
+            fail("Failed to reference decoded frame");
+            return false;
+        }
+        if (!lanes_[i]->scaleQueue.push(std::move(ref))) {
+            return false;
+        }
+    }
+    return lanes_.back()->scaleQueue.push(std::move(frame));
+}
+
+void StagedTranscoder::scaleStage(Lane& lane) {
+    VideoPipeline& video = *lane.rendition.pipeline;
+    FramePtr frame;
+
+    while (lane.scaleQueue.pop(frame)) {
+        FramePtr scaled = video.acquireScaledFrame();
+        if (!scaled) {
+            fail("Failed to allocate scaled frame");
+            break;
+        }
+
+        if (!video.scaleFrame(frame.get(), scaled)) {
+            continue;
+        }
+        frame.reset();
+
+        if (!lane.encodeQueue.push(std::move(scaled))) {
+            break;
+        }
+    }
+
+    lane.encodeQueue.close();
+}
+
+void StagedTranscoder::encodeStage(Lane& lane, size_t laneIndex) {
+    VideoPipeline& video = *lane.rendition.pipeline;
+    FramePtr frame;
+
+    while (lane.encodeQueue.pop(frame)) {
+        bool sent = video.encodeFrame(frame.get());
+        frame.reset();
+        if (!sent) {
+            continue;
+        }
+
+        if (!drainEncoder(lane, laneIndex)) {
+            return;
+        }
+    }
+
+    // Flush encoder into the mux queue
+    if (!failed_) {
+        Logger::info("Flushing video encoder (rendition " + std::to_string(laneIndex) + ")");
+        video.encodeFrame(nullptr);
+        drainEncoder(lane, laneIndex);
+    }
+}
+
+bool StagedTranscoder::drainEncoder(Lane& lane, size_t laneIndex) {
+    while (true) {
+        PacketPtr packet = allocPacket();
+        if (!packet) {
+            return false;
+        }
+
+        bool packetAvailable = false;
+        if (!lane.rendition.pipeline->receiveEncodedPacket(packet.get(), packetAvailable)) {
+            fail("Video encoder error");
+            return false;
+        }
+        if (!packetAvailable) {
+            return true;
+        }
+
+        MuxItem item;
+        item.packet = std::move(packet);
+        item.lane = laneIndex;
+        if (!muxQueue_.push(std::move(item))) {
+            return false;
+        }
+    }
+}
+
+void StagedTranscoder::muxStage() {
+    AVFormatContext* outputFormatCtx = streams_.outputFormatCtx;
+    MuxItem item;
+
+    while (muxQueue_.pop(item)) {
+        if (item.isAudio) {
+            // Process audio packets via AudioPipeline
+            audio_.processPacket(item.packet.get(), streams_.inputFormatCtx, outputFormatCtx,
+                                 streams_.audioStreamIndex, streams_.outputAudioStreamIndex);
+        } else {
+            // Process encoded packet via the rendition's bitstream filter
+            const Rendition& rendition = lanes_[item.lane]->rendition;
+            rendition.pipeline->processBitstreamFilter(
+                item.packet.get(),
+                outputFormatCtx,
+                rendition.outputStreamIndex,
+                rendition.pipeline->getOutputCodecContext()->time_base,
+                outputFormatCtx->streams[rendition.outputStreamIndex]->time_base);
+        }
+        item.packet.reset();
+    }
+}
+
+void StagedTranscoder::fail(const std::string& reason) {
+    if (!failed_.exchange(true)) {
+        Logger::error(reason + " - aborting transcode pipeline");
+    }
+    decodeQueue_.abort();
+    for (const auto& lane : lanes_) {
+        lane->scaleQueue.abort();
+        lane->encodeQueue.abort();
+    }
+    muxQueue_.abort();
+}
+
+StagedTranscoder::PacketPtr StagedTranscoder::allocPacket() {
+    PacketPtr packet = pool_.acquirePacket();
+    if (!packet) {
+        fail("Failed to allocate packet");
+    }
+    return packet;
+}
+
+StagedTranscoder::FramePtr StagedTranscoder::allocFrame() {
+    FramePtr frame = pool_.acquireFrame();
+    if (!frame) {
+        fail("Failed to allocate frame");
+    }
+    return frame;
+}
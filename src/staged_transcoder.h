@@ -0,0 +1,146 @@
+#ifndef STAGED_TRANSCODER_H
+#define STAGED_TRANSCODER_H
+
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "bounded_queue.h"
+#include "av_object_pool.h"
+
+class FFmpegContext;
+class VideoPipeline;
+class AudioPipeline;
+class InputTimeline;
+struct AVFormatContext;
+struct AVPacket;
+struct AVFrame;
+
+/**
+ * StagedTranscoder - Runs TRANSCODE mode as a multi-threaded stage pipeline
+ *
+ * Stages (one thread each, connected by BoundedQueues):
+ *   demux (caller thread) → decode ─┬→ scale → encode ─┬→ mux
+ *                                   └→ scale → encode ─┘   (one lane per rendition)
+ *
+ * The input is decoded once; every decoded frame is shared by reference with
+ * each rendition lane, which owns its own scaler, encoder and bitstream filter
+ * (one VideoPipeline per rung). The mux stage is the only thread that touches
+ * the output AVFormatContext: it writes encoded video through each lane's
+ * VideoPipeline::processBitstreamFilter() and feeds audio packets (forwarded
+ * directly by demux) to AudioPipeline.
+ * Full queues block the upstream stage, so memory stays bounded and the
+ * slowest stage sets the pace while the others keep their own core busy.
+ * Packets and frames are recycled through AVObjectPool (scaled frames through
+ * each lane's pool, preallocated to the encode queue depth), so once the
+ * queues have filled no packets, frames or scaled pictures are allocated per
+ * frame. Sharing a decoded frame (fan-out, pass-through without scaling)
+ * still allocates an AVBufferRef per plane in av_frame_ref().
+ *
+ * Lifecycle:
+ *   1. Constructor: Receives shared FFmpegContext, the decoding pipeline and
+ *      one configured encoding pipeline per rendition
+ *   2. run(): Blocks until input EOF, interrupt or error; flushes every stage
+ *   The caller writes the trailer afterwards.
+ */
+class StagedTranscoder {
+public:
+    struct Streams {
+        AVFormatContext* inputFormatCtx = nullptr;
+        AVFormatContext* outputFormatCtx = nullptr;
+        int videoStreamIndex = -1;
+        int audioStreamIndex = -1;
+        int outputAudioStreamIndex = -1;
+        InputTimeline* timeline = nullptr;  // Shifts/gates demuxed packets after a failover (optional)
+        int64_t firstVideoPts = 0;          // PTS of the first decoded frame (continues the previous run)
+    };
+
+    struct Rendition {
+        VideoPipeline* pipeline = nullptr;  // Scaler + encoder + bitstream filter for this rung
+        int outputStreamIndex = -1;
+    };
+
+    StagedTranscoder(std::shared_ptr<FFmpegContext> ctx,
+                     VideoPipeline& decoderPipeline,
+                     const std::vector<Rendition>& renditions,
+                     AudioPipeline& audioPipeline);
+    ~StagedTranscoder();
+
+    // No copy, no move (worker threads reference this object)
+    StagedTranscoder(const StagedTranscoder&) = delete;
+    StagedTranscoder& operator=(const StagedTranscoder&) = delete;
+
+    /**
+     * Transcode the whole input
+     * @param streams Input/output contexts and stream indices
+     * @param interruptCallback Returns true to stop reading (stages still drain)
+     * @return true on success
+     */
+    bool run(const Streams& streams, const std::function<bool()>& interruptCallback);
+
+    /**
+     * Called from the decode thread with every frame-count log line (e.g. to report output stats)
+     * Set before run()
+     */
+    void setProgressCallback(std::function<void()> callback) { progressCallback_ = std::move(callback); }
+
+    /**
+     * Number of decoded video frames that went through the pipeline
+     */
+    int64_t getFrameCount() const { return frameCount_.load(); }
+
+private:
+    using PacketPtr = AVObjectPool::PacketPtr;
+    using FramePtr = AVObjectPool::FramePtr;
+
+    struct MuxItem {
+        PacketPtr packet;
+        bool isAudio = false;  // Audio: input packet for AudioPipeline; video: encoded packet
+        size_t lane = 0;       // Rendition that produced the video packet
+    };
+
+    // Per-rendition scale/encode path
+    struct Lane {
+        explicit Lane(const Rendition& r);
+
+        Rendition rendition;
+        BoundedQueue<FramePtr> scaleQueue;
+        BoundedQueue<FramePtr> encodeQueue;
+    };
+
+    std::shared_ptr<FFmpegContext> ffmpeg_;
+    AVObjectPool pool_;  // Packets and decoded-frame references in flight between stages
+    VideoPipeline& decoder_;
+    AudioPipeline& audio_;
+    Streams streams_;
+    std::vector<std::unique_ptr<Lane>> lanes_;
+
+    // Inter-stage queues shared by all lanes
+    BoundedQueue<PacketPtr> decodeQueue_;
+    BoundedQueue<MuxItem> muxQueue_;
+
+    std::atomic<bool> failed_{false};
+    std::atomic<int64_t> frameCount_{0};
+    uint64_t warmupAllocations_ = 0;  // Pool allocations once the queues had filled (decode thread)
+    bool warmedUp_ = false;
+    std::function<void()> progressCallback_;
+
+    // Stage bodies (each runs on its own thread)
+    void decodeStage();
+    void scaleStage(Lane& lane);
+    void encodeStage(Lane& lane, size_t laneIndex);
+    void muxStage();
+
+    // Helpers
+    bool drainDecoder(int64_t& nextPts);
+    bool fanOut(FramePtr frame);
+    bool drainEncoder(Lane& lane, size_t laneIndex);
+    void fail(const std::string& reason);
+    uint64_t countAllocations() const;
+    PacketPtr allocPacket();
+    FramePtr allocFrame();
+};
+
+#endif // STAGED_TRANSCODER_H
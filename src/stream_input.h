@@ -3,6 +3,7 @@
 
 #include <string>
 #include <memory>
+#include <functional>
 #include "config.h"
 
 // Forward declarations
@@ -29,6 +30,13 @@ public:
     virtual bool isLiveStream() const = 0;
     virtual std::string getTypeName() const = 0;
     virtual bool isProgrammatic() const { return false; }
+
+    /**
+     * Abort blocking open/read calls when the callback returns true
+     * Set before open(); FFmpeg inputs poll it from inside avformat (AVIOInterruptCB)
+     * @param callback Polled from the thread calling open()/readPacket() (nullptr to remove)
+     */
+    virtual void setInterruptCallback(std::function<bool()> callback) { (void)callback; }
 };
 
 class StreamInputFactory {
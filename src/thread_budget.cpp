@@ -0,0 +1,67 @@
+#include "thread_budget.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+    constexpr int DECODE_SHARE_DIVISOR = 4;  // Decode gets 1/4 of the cores left after scaling
+
+    int hardwareThreads() {
+        unsigned int count = std::thread::hardware_concurrency();
+        return count > 0 ? static_cast<int>(count) : 1;
+    }
+}
+
+int ThreadBudget::coresPerChannel(int cpuBudget, size_t channelCount) {
+    int cores = cpuBudget > 0 ? cpuBudget : hardwareThreads();
+    if (channelCount > 1) {
+        cores /= static_cast<int>(channelCount);
+    }
+    return std::max(1, cores);
+}
+
+ThreadBudget::Plan ThreadBudget::plan(int cores, const std::vector<RenditionConfig>& renditions, bool live) {
+    Plan plan;
+    plan.sliceThreading = live;
+
+    if (cores <= 0) {
+        cores = hardwareThreads();
+    }
+    const int renditionCount = std::max<int>(1, static_cast<int>(renditions.size()));
+
+    plan.scaleThreads = renditionCount;
+    int remaining = cores - renditionCount;
+    plan.decodeThreads = std::max(1, remaining / DECODE_SHARE_DIVISOR);
+    int encodeCores = remaining - plan.decodeThreads;
+    plan.oversubscribed = encodeCores < renditionCount;
+
+    // Larger renditions need proportionally more encoder threads
+    int64_t totalPixels = 0;
+    for (const RenditionConfig& rendition : renditions) {
+        totalPixels += static_cast<int64_t>(rendition.width) * rendition.height;
+    }
+
+    plan.encodeThreads.assign(renditionCount, 1);
+    if (!plan.oversubscribed) {
+        for (size_t i = 0; i < renditions.size(); i++) {
+            int64_t pixels = static_cast<int64_t>(renditions[i].width) * renditions[i].height;
+            int share = totalPixels > 0
+                ? static_cast<int>(encodeCores * pixels / totalPixels)
+                : encodeCores / renditionCount;
+            plan.encodeThreads[i] = std::max(1, share);
+        }
+        if (renditions.empty()) {
+            plan.encodeThreads[0] = encodeCores;
+        }
+    }
+    return plan;
+}
+
+std::string ThreadBudget::describe(const Plan& plan) {
+    std::string encode;
+    for (int threads : plan.encodeThreads) {
+        encode += (encode.empty() ? "" : "+") + std::to_string(threads);
+    }
+    return "decode " + std::to_string(plan.decodeThreads) + (plan.sliceThreading ? " (slice)" : " (frame)") +
+           ", scale " + std::to_string(plan.scaleThreads) + ", encode " + encode;
+}
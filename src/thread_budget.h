@@ -0,0 +1,61 @@
+#ifndef THREAD_BUDGET_H
+#define THREAD_BUDGET_H
+
+#include "config.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * ThreadBudget - Splits a channel's cores between decode, scale and encode
+ *
+ * Left alone, every FFmpeg decoder and x264 encoder sizes its thread pool to
+ * all hardware threads, so a process running several channels (or one
+ * channel with a rendition ladder) starts many times more threads than
+ * there are cores. The budget is split instead:
+ *
+ *   - scale: one core per rendition lane (swscale runs on the lane's own thread)
+ *   - decode: a quarter of what remains (decoding once feeds every rendition)
+ *   - encode: the rest, shared between renditions by pixel count
+ *
+ * Every step gets at least one thread; a budget too small for that is
+ * reported as oversubscribed.
+ *
+ * Decode threading follows latency: frame threading (highest throughput,
+ * one frame of delay per thread) for files, slice threading (no added delay)
+ * for live inputs.
+ */
+class ThreadBudget {
+public:
+    struct Plan {
+        int decodeThreads = 1;
+        bool sliceThreading = false;     // Live: FF_THREAD_SLICE, otherwise FF_THREAD_FRAME
+        int scaleThreads = 1;            // One per rendition (informational, fixed by the pipeline)
+        std::vector<int> encodeThreads;  // Per rendition, same order as the ladder
+        bool oversubscribed = false;     // Budget smaller than one thread per step
+    };
+
+    /**
+     * Cores available to one of several channels
+     * @param cpuBudget Cores for the whole process (0 = all hardware threads)
+     * @param channelCount Channels running in the process
+     * @return Cores per channel (at least 1)
+     */
+    static int coresPerChannel(int cpuBudget, size_t channelCount);
+
+    /**
+     * Split a channel's cores for a TRANSCODE pipeline
+     * @param cores Cores for this channel (0 = all hardware threads)
+     * @param renditions Encoded renditions (sizes weight the encoder split)
+     * @param live Live input (slice-threaded decode)
+     * @return Thread counts per step
+     */
+    static Plan plan(int cores, const std::vector<RenditionConfig>& renditions, bool live);
+
+    /**
+     * One-line summary for the log
+     */
+    static std::string describe(const Plan& plan);
+};
+
+#endif // THREAD_BUDGET_H
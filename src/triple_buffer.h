@@ -0,0 +1,87 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * TripleBuffer - Lock-free single-producer/single-consumer "latest value" exchange
+ *
+ * Three slots rotate between the producer (back), the consumer (front) and a
+ * shared middle slot. The producer fills back() in place and publish()es it,
+ * swapping it with the middle slot; the consumer acquire()s the newest published
+ * slot by swapping it with its front slot. Neither side ever waits and each slot
+ * is owned by exactly one side at a time, so the producer writes a frame once
+ * and the consumer reads it in place until its next acquire(). Unread frames are
+ * overwritten (the consumer always sees the most recent one).
+ *
+ * Slots are reused, so T keeps its allocations (e.g. a std::vector buffer is
+ * only resized when the frame size grows).
+ *
+ * Thread-safety: One producer thread and one consumer thread
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+
+    // No copy, no move (slots are referenced in place by both threads)
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // ===== Producer side =====
+
+    /**
+     * Slot owned by the producer, to be filled before publish()
+     */
+    T& back() { return slots_[back_]; }
+
+    /**
+     * Hand the back slot to the consumer and take the middle slot as new back slot
+     * @return true if the middle slot held a value the consumer never acquired (it is
+     *         the new back slot, so the producer can still carry its content forward)
+     */
+    bool publish() {
+        uint8_t previous = middle_.exchange(static_cast<uint8_t>(back_ | NEW_DATA), std::memory_order_acq_rel);
+        back_ = previous & INDEX_MASK;
+        return (previous & NEW_DATA) != 0;
+    }
+
+    // ===== Consumer side =====
+
+    /**
+     * Check whether a slot was published since the last acquire()
+     */
+    bool hasNewData() const {
+        return (middle_.load(std::memory_order_acquire) & NEW_DATA) != 0;
+    }
+
+    /**
+     * Take the most recently published slot as front slot
+     * @return false if nothing new was published (front() is unchanged)
+     */
+    bool acquire() {
+        if (!hasNewData()) {
+            return false;
+        }
+        uint8_t previous = middle_.exchange(front_, std::memory_order_acq_rel);
+        front_ = previous & INDEX_MASK;
+        return true;
+    }
+
+    /**
+     * Slot owned by the consumer (valid until the next acquire())
+     */
+    T& front() { return slots_[front_]; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t NEW_DATA = 0x4;
+
+    T slots_[3];
+    uint8_t back_ = 0;                   // Producer-owned
+    uint8_t front_ = 1;                  // Consumer-owned
+    std::atomic<uint8_t> middle_{2};     // Shared: slot index | NEW_DATA
+};
+
+#endif // TRIPLE_BUFFER_H
@@ -1,6 +1,7 @@
 #include "video_pipeline.h"
 #include "ffmpeg_context.h"
 #include "logger.h"
+#include "codec_compat.h"
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -10,13 +11,16 @@ extern "C" {
 #include <libswscale/swscale.h>
 }
 
+#include <vector>
+
 VideoPipeline::VideoPipeline(std::shared_ptr<FFmpegContext> ctx)
-    : ffmpeg_(std::move(ctx)) {
+    : ffmpeg_(ctx)
+    , scaledFrames_(ctx) {
 }
 
 VideoPipeline::~VideoPipeline() = default;
 
-VideoPipeline::Mode VideoPipeline::detectMode(AVStream* inStream) {
+VideoPipeline::Mode VideoPipeline::detectMode(AVStream* inStream, SegmentFormat format) {
     inputCodecId_ = inStream->codecpar->codec_id;
 
     const AVCodec* decoder = ffmpeg_->avcodec_find_decoder(inputCodecId_);
@@ -28,20 +32,24 @@ VideoPipeline::Mode VideoPipeline::detectMode(AVStream* inStream) {
 
     Logger::info("Input video codec: " + inputCodecName_ + " (ID: " + std::to_string(inputCodecId_) + ")");
 
-    // Check if codec is HLS-compatible (H.264)
-    if (inputCodecId_ == AV_CODEC_ID_H264) {
-        Logger::info("Input is H.264 - will use REMUX mode (fast, no quality loss)");
+    // Check if codec can be copied into the selected segment container
+    if (CodecCompat::canCopyVideo(inputCodecId_, format)) {
+        Logger::info("Input is " + inputCodecName_ + " - will use REMUX mode (fast, no quality loss)");
         mode_ = Mode::REMUX;
         return mode_;
     }
 
-    Logger::warn("Input codec '" + inputCodecName_ + "' is not HLS-compatible");
+    Logger::warn("Input codec '" + inputCodecName_ + "' is not HLS-compatible in " +
+                 (format == SegmentFormat::FMP4 ? "fMP4" : "MPEG-TS") + " segments");
+    if (format != SegmentFormat::FMP4 && CodecCompat::canCopyVideo(inputCodecId_, SegmentFormat::FMP4)) {
+        Logger::warn("Use --fmp4 to remux it without transcoding");
+    }
     Logger::warn("Will TRANSCODE to H.264 (this may take longer)");
     mode_ = Mode::TRANSCODE;
     return mode_;
 }
 
-bool VideoPipeline::setupDecoder(AVStream* inStream) {
+bool VideoPipeline::setupDecoder(AVStream* inStream, int threadCount, bool sliceThreading, bool lowDelay) {
     const AVCodec* decoder = ffmpeg_->avcodec_find_decoder(inStream->codecpar->codec_id);
     if (!decoder) {
         Logger::error("Failed to find decoder");
@@ -62,11 +70,23 @@ bool VideoPipeline::setupDecoder(AVStream* inStream) {
         return false;
     }
 
+    // Frame threading delays output by one frame per thread, which only files can afford
+    inputCodecCtx_->thread_count = threadCount;
+    inputCodecCtx_->thread_type = sliceThreading ? FF_THREAD_SLICE : FF_THREAD_FRAME;
+    if (lowDelay) {
+        inputCodecCtx_->flags |= AV_CODEC_FLAG_LOW_DELAY;
+    }
+
     if (ffmpeg_->avcodec_open2(inputCodecCtx_.get(), decoder, nullptr) < 0) {
         Logger::error("Failed to open decoder");
         return false;
     }
 
+    Logger::info("Decoder threads: " + std::to_string(inputCodecCtx_->thread_count) + " (" +
+                 (inputCodecCtx_->active_thread_type == FF_THREAD_FRAME ? "frame" :
+                  inputCodecCtx_->active_thread_type == FF_THREAD_SLICE ? "slice" : "none") + ")" +
+                 (lowDelay ? ", low delay" : ""));
+
     return true;
 }
 
@@ -99,11 +119,21 @@ bool VideoPipeline::setupEncoder(AVStream* outStream, const AppConfig& config) {
     outputCodecCtx_->framerate = AVRational{config_.video.fps, 1};
     outputCodecCtx_->pix_fmt = AV_PIX_FMT_YUV420P;
     outputCodecCtx_->bit_rate = config_.video.bitrate;
-    outputCodecCtx_->gop_size = config_.video.gop_size;
+    outputCodecCtx_->gop_size = config_.video.gop_size > 0
+        ? config_.video.gop_size
+        : KeyframePlanner::framesPerSegment(config_.video.fps, config_.hls.segmentDuration);
     outputCodecCtx_->max_b_frames = 0;  // No B-frames for HLS streaming
+    outputCodecCtx_->thread_count = config_.video.encoderThreads;  // Share of the channel's CPU budget
 
     ffmpeg_->av_opt_set(outputCodecCtx_->priv_data, "preset", "ultrafast", 0);
     ffmpeg_->av_opt_set(outputCodecCtx_->priv_data, "tune", "zerolatency", 0);
+    // Forced I-frames (segment boundaries) become IDR, so every segment is independently decodable
+    ffmpeg_->av_opt_set(outputCodecCtx_->priv_data, "forced-idr", "1", 0);
+
+    // fMP4 needs SPS/PPS in extradata (avcC in init.mp4) rather than in-band
+    if (config_.hls.usesFmp4()) {
+        outputCodecCtx_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
 
     if (ffmpeg_->avcodec_open2(outputCodecCtx_.get(), encoder, nullptr) < 0) {
         Logger::error("Failed to open encoder");
@@ -118,6 +148,11 @@ bool VideoPipeline::setupEncoder(AVStream* outStream, const AppConfig& config) {
 
     outStream->time_base = outputCodecCtx_->time_base;
 
+    keyframePlanner_.configure(outputCodecCtx_->time_base.num, outputCodecCtx_->time_base.den,
+                               config_.hls.segmentDuration);
+    Logger::info("Keyframes: IDR every " + std::to_string(config_.hls.segmentDuration) +
+                 "s segment boundary (max GOP " + std::to_string(outputCodecCtx_->gop_size) + " frames)");
+
     return true;
 }
 
@@ -175,70 +210,146 @@ bool VideoPipeline::convertAndEncodeFrame(AVFrame* inputFrame, int64_t pts) {
     // Set PTS
     inputFrame->pts = pts;
 
+    AVObjectPool::FramePtr scaledFrame = acquireScaledFrame();
+    if (!scaledFrame) {
+        Logger::warn("Failed to allocate scaled frame");
+        return false;
+    }
+
+    if (!scaleFrame(inputFrame, scaledFrame)) {
+        return false;
+    }
+
+    // scaledFrame goes back to the pool (with its buffers) when going out of scope
+    return encodeFrame(scaledFrame.get());
+}
+
+bool VideoPipeline::scaleFrame(AVFrame* inputFrame, AVObjectPool::FramePtr& scaledFrame) {
+    AVFrame* outputFrame = scaledFrame.get();
+    if (!inputFrame || !outputFrame || !outputCodecCtx_) {
+        return false;
+    }
+
     // Check if we need resolution/format conversion
     bool needsConversion = (inputFrame->width != outputCodecCtx_->width) ||
                           (inputFrame->height != outputCodecCtx_->height) ||
                           (inputFrame->format != outputCodecCtx_->pix_fmt);
 
-    AVFrame* frameToEncode = inputFrame;
-    std::unique_ptr<AVFrame, AVFrameDeleter> scaledFrame;
-
-    if (needsConversion) {
-        // Get or recreate SwsContext if input dimensions/format changed
-        SwsContext* newCtx = ffmpeg_->sws_getCachedContext(
-            swsCtx_.get(),
-            inputFrame->width, inputFrame->height, (AVPixelFormat)inputFrame->format,
-            outputCodecCtx_->width, outputCodecCtx_->height, outputCodecCtx_->pix_fmt,
-            SWS_BILINEAR, nullptr, nullptr, nullptr);
-
-        if (!newCtx) {
-            Logger::error("Failed to get/create video scaler context");
+    if (!needsConversion) {
+        // Encoder accepts the decoded frame as-is: share its buffers
+        ffmpeg_->av_frame_unref(outputFrame);
+        if (ffmpeg_->av_frame_ref(outputFrame, inputFrame) < 0) {
+            Logger::warn("Failed to reference input frame");
             return false;
         }
+        // The decoder's buffers must not stay referenced by the scaled-frame ring
+        scaledFrame.get_deleter().unrefOnReturn();
+        return true;
+    }
 
-        if (newCtx != swsCtx_.get()) {
-            Logger::info("Video scaler " + std::string(swsCtx_ ? "recreated" : "initialized") + ": " +
-                       std::to_string(inputFrame->width) + "x" + std::to_string(inputFrame->height) + " " +
-                       "fmt=" + std::to_string(inputFrame->format) + " -> " +
-                       std::to_string(outputCodecCtx_->width) + "x" + std::to_string(outputCodecCtx_->height) + " " +
-                       "fmt=" + std::to_string(outputCodecCtx_->pix_fmt));
-            swsCtx_ = std::unique_ptr<SwsContext, SwsContextDeleter>(newCtx, SwsContextDeleter(ffmpeg_));
-        }
+    // Get or recreate SwsContext if input dimensions/format changed
+    SwsContext* newCtx = ffmpeg_->sws_getCachedContext(
+        swsCtx_.get(),
+        inputFrame->width, inputFrame->height, (AVPixelFormat)inputFrame->format,
+        outputCodecCtx_->width, outputCodecCtx_->height, outputCodecCtx_->pix_fmt,
+        SWS_BILINEAR, nullptr, nullptr, nullptr);
+
+    if (!newCtx) {
+        Logger::error("Failed to get/create video scaler context");
+        return false;
+    }
+
+    if (newCtx != swsCtx_.get()) {
+        Logger::info("Video scaler " + std::string(swsCtx_ ? "recreated" : "initialized") + ": " +
+                   std::to_string(inputFrame->width) + "x" + std::to_string(inputFrame->height) + " " +
+                   "fmt=" + std::to_string(inputFrame->format) + " -> " +
+                   std::to_string(outputCodecCtx_->width) + "x" + std::to_string(outputCodecCtx_->height) + " " +
+                   "fmt=" + std::to_string(outputCodecCtx_->pix_fmt));
+        // sws_getCachedContext already freed the old context
+        (void)swsCtx_.release();
+        swsCtx_ = std::unique_ptr<SwsContext, SwsContextDeleter>(newCtx, SwsContextDeleter(ffmpeg_));
+    }
 
-        // Allocate scaled frame
-        scaledFrame = std::unique_ptr<AVFrame, AVFrameDeleter>(
-            ffmpeg_->av_frame_alloc(), AVFrameDeleter(ffmpeg_));
-        if (!scaledFrame) {
-            Logger::warn("Failed to allocate scaled frame");
+    if (!prepareScaledFrame(outputFrame)) {
+        return false;
+    }
+
+    // Perform scaling/conversion
+    ffmpeg_->sws_scale(swsCtx_.get(),
+             inputFrame->data, inputFrame->linesize,
+             0, inputFrame->height,
+             outputFrame->data, outputFrame->linesize);
+
+    outputFrame->pts = inputFrame->pts;
+    return true;
+}
+
+AVObjectPool::FramePtr VideoPipeline::acquireScaledFrame() {
+    return scaledFrames_.acquireBufferedFrame();
+}
+
+bool VideoPipeline::reserveScaledFrames(size_t count) {
+    if (!outputCodecCtx_) {
+        return false;
+    }
+
+    // Hold all frames at once so the pool grows to count, then return them with their buffers
+    std::vector<AVObjectPool::FramePtr> frames;
+    frames.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        AVObjectPool::FramePtr frame = acquireScaledFrame();
+        if (!frame || !prepareScaledFrame(frame.get())) {
             return false;
         }
+        frames.push_back(std::move(frame));
+    }
+    return true;
+}
 
-        scaledFrame->format = outputCodecCtx_->pix_fmt;
-        scaledFrame->width = outputCodecCtx_->width;
-        scaledFrame->height = outputCodecCtx_->height;
+bool VideoPipeline::prepareScaledFrame(AVFrame* frame) {
+    bool reusable = frame->buf[0] &&
+                    frame->format == outputCodecCtx_->pix_fmt &&
+                    frame->width == outputCodecCtx_->width &&
+                    frame->height == outputCodecCtx_->height;
 
-        if (ffmpeg_->av_frame_get_buffer(scaledFrame.get(), 0) < 0) {
-            Logger::warn("Failed to allocate scaled frame buffer");
+    if (reusable) {
+        // Copies only if the encoder still holds a reference to these buffers
+        if (ffmpeg_->av_frame_make_writable(frame) < 0) {
+            Logger::warn("Failed to make scaled frame writable");
             return false;
         }
+        return true;
+    }
+
+    // New frame, or the previous use was a pass-through reference / other size
+    ffmpeg_->av_frame_unref(frame);
+    frame->format = outputCodecCtx_->pix_fmt;
+    frame->width = outputCodecCtx_->width;
+    frame->height = outputCodecCtx_->height;
+
+    if (ffmpeg_->av_frame_get_buffer(frame, 0) < 0) {
+        Logger::warn("Failed to allocate scaled frame buffer");
+        return false;
+    }
+    return true;
+}
 
-        // Perform scaling/conversion
-        ffmpeg_->sws_scale(swsCtx_.get(),
-                 inputFrame->data, inputFrame->linesize,
-                 0, inputFrame->height,
-                 scaledFrame->data, scaledFrame->linesize);
+bool VideoPipeline::encodeFrame(AVFrame* frame) {
+    if (!outputCodecCtx_) {
+        return false;
+    }
 
-        scaledFrame->pts = inputFrame->pts;
-        frameToEncode = scaledFrame.get();
+    if (frame) {
+        // Only the planner decides keyframes (decoded frames still carry the source pict_type)
+        frame->pict_type = keyframePlanner_.shouldForceKeyframe(frame->pts)
+            ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
     }
 
-    // Send frame to encoder
-    if (ffmpeg_->avcodec_send_frame(outputCodecCtx_.get(), frameToEncode) < 0) {
+    // Send frame to encoder (nullptr enters draining mode)
+    if (ffmpeg_->avcodec_send_frame(outputCodecCtx_.get(), frame) < 0) {
         Logger::warn("Error sending frame to encoder");
         return false;
     }
-
-    // scaledFrame automatically freed by unique_ptr when going out of scope
     return true;
 }
 
@@ -393,6 +504,7 @@ void VideoPipeline::reset() {
     outputCodecCtx_.reset();
     bsfCtx_.reset();
     swsCtx_.reset();
+    keyframePlanner_.reset();
 
     mode_ = Mode::REMUX;
     inputCodecId_ = 0;
@@ -4,6 +4,8 @@
 #include <memory>
 #include <string>
 #include "ffmpeg_deleters.h"
+#include "av_object_pool.h"
+#include "keyframe_planner.h"
 #include "config.h"
 
 class FFmpegContext;
@@ -23,14 +25,19 @@ struct AVRational;
  *   - Detect processing mode based on codec compatibility
  *   - Setup video encoder (H.264) and decoder (for transcode)
  *   - Setup SwsContext for video scaling/conversion
- *   - Setup bitstream filter (h264_mp4toannexb)
+ *   - Setup bitstream filter (h264_mp4toannexb, MPEG-TS segments only)
  *   - Process video packets/frames in all modes
  *   - Flush buffered video at end-of-stream
  *
  * Processing Modes:
- *   - REMUX: Copy H.264 packets directly (fast, no quality loss)
+ *   - REMUX: Copy H.264 (or HEVC/AV1 into fMP4) packets directly (fast, no quality loss)
  *   - TRANSCODE: Decode and re-encode to H.264 (compatible but slow)
  *   - PROGRAMMATIC: Process packets from browser/CEF sources
+ *
+ * Threading (TRANSCODE via StagedTranscoder):
+ *   Decoder, scaler, encoder and bitstream filter each own separate state, so
+ *   decodePacket(), scaleFrame(), encodeFrame()/receiveEncodedPacket() and
+ *   processBitstreamFilter() may run on different threads, one thread per step.
  */
 class VideoPipeline {
 public:
@@ -50,11 +57,12 @@ public:
     VideoPipeline& operator=(VideoPipeline&&) = default;
 
     /**
-     * Detect processing mode based on input codec
+     * Detect processing mode based on input codec (see CodecCompat)
      * @param inStream Input video stream
+     * @param format Segment container the stream is written to
      * @return Detected mode
      */
-    Mode detectMode(AVStream* inStream);
+    Mode detectMode(AVStream* inStream, SegmentFormat format);
 
     /**
      * Setup video encoder for TRANSCODE mode
@@ -67,9 +75,12 @@ public:
     /**
      * Setup video decoder for TRANSCODE mode
      * @param inStream Input video stream
+     * @param threadCount Decoder threads (0 = library default)
+     * @param sliceThreading Slice threading (live, no added delay) instead of frame threading
+     * @param lowDelay Live input: AV_CODEC_FLAG_LOW_DELAY (frames are output as soon as they are decoded)
      * @return true on success
      */
-    bool setupDecoder(AVStream* inStream);
+    bool setupDecoder(AVStream* inStream, int threadCount = 0, bool sliceThreading = false, bool lowDelay = false);
 
     /**
      * Setup bitstream filter (h264_mp4toannexb) for REMUX/PROGRAMMATIC
@@ -89,6 +100,42 @@ public:
      */
     bool convertAndEncodeFrame(AVFrame* inputFrame, int64_t pts);
 
+    /**
+     * Convert a decoded frame to the encoder's resolution/pixel format (TRANSCODE mode)
+     * @param inputFrame Decoded frame
+     * @param scaledFrame Frame from acquireScaledFrame() to fill (references inputFrame if no
+     *                    conversion is needed; those references are dropped when it is returned)
+     * @return true on success
+     */
+    bool scaleFrame(AVFrame* inputFrame, AVObjectPool::FramePtr& scaledFrame);
+
+    /**
+     * Frame for scaleFrame() output, recycled with its buffers (TRANSCODE mode)
+     * A recycled frame in the encoder's format is scaled into in place.
+     * @return Frame, or nullptr if allocation failed
+     */
+    AVObjectPool::FramePtr acquireScaledFrame();
+
+    /**
+     * Preallocate scaled frames in the encoder's format (TRANSCODE mode)
+     * @param count Frames in flight between scaler and encoder
+     * @return true on success
+     */
+    bool reserveScaledFrames(size_t count);
+
+    /**
+     * Scaled-frame pool counters (allocations vs reuse)
+     */
+    AVObjectPool::Stats getScaledFrameStats() const { return scaledFrames_.getStats(); }
+
+    /**
+     * Send a frame to the encoder (TRANSCODE mode)
+     * Frames opening a new HLS segment are forced to IDR (KeyframePlanner)
+     * @param frame Frame in encoder format, or nullptr to start draining
+     * @return true on success
+     */
+    bool encodeFrame(AVFrame* frame);
+
     /**
      * Decode a packet to frames (TRANSCODE mode)
      * @param packet Input packet to decode
@@ -173,6 +220,13 @@ public:
     AVCodecContext* getOutputCodecContext() { return outputCodecCtx_.get(); }
 
 private:
+    /**
+     * Give a scaled frame buffers in the encoder's format, reusing its current ones if they match
+     * @param frame Frame from the scaled-frame pool
+     * @return true on success
+     */
+    bool prepareScaledFrame(AVFrame* frame);
+
     // Shared FFmpeg context
     std::shared_ptr<FFmpegContext> ffmpeg_;
 
@@ -186,6 +240,12 @@ private:
     // Video scaler
     std::unique_ptr<SwsContext, SwsContextDeleter> swsCtx_;
 
+    // Scaler output frames, reused with their buffers (scaler/encoder threads)
+    AVObjectPool scaledFrames_;
+
+    // Forces IDR frames on segment boundaries (encoder thread only)
+    KeyframePlanner keyframePlanner_;
+
     // State
     Mode mode_ = Mode::REMUX;
     int inputCodecId_ = 0;
@@ -0,0 +1,241 @@
+// AVObjectPool: objects are recycled, buffered frames keep their buffers unless
+// marked with unrefOnReturn(), and a staged pipeline stops allocating packets
+// and frames once its queues have filled (allocations stay within the number
+// of objects that can be in flight, however many frames pass through).
+//
+// FFmpeg is not loaded: the pool only calls the alloc/free/unref entry points,
+// which are replaced by counting fakes.
+
+#include "av_object_pool.h"
+#include "bounded_queue.h"
+#include "ffmpeg_context.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+}
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+    // Pipeline shape of StagedTranscoder (queue depths, two rendition lanes)
+    constexpr size_t DECODE_QUEUE_CAPACITY = 64;
+    constexpr size_t SCALE_QUEUE_CAPACITY = 8;
+    constexpr size_t ENCODE_QUEUE_CAPACITY = 8;
+    constexpr size_t MUX_QUEUE_CAPACITY = 256;
+    constexpr size_t LANES = 2;
+    constexpr int FRAMES = 20000;
+
+    std::atomic<uint64_t> packetAllocs{0};
+    std::atomic<uint64_t> frameAllocs{0};
+
+    AVPacket* fakePacketAlloc() {
+        packetAllocs++;
+        return new AVPacket();
+    }
+
+    void fakePacketFree(AVPacket** packet) {
+        delete *packet;
+        *packet = nullptr;
+    }
+
+    void fakePacketUnref(AVPacket* packet) {
+        packet->size = 0;
+    }
+
+    AVFrame* fakeFrameAlloc() {
+        frameAllocs++;
+        return new AVFrame();
+    }
+
+    void fakeFrameFree(AVFrame** frame) {
+        delete *frame;
+        *frame = nullptr;
+    }
+
+    // Width stands in for the frame's buffers: unref clears it
+    void fakeFrameUnref(AVFrame* frame) {
+        frame->width = 0;
+    }
+
+    std::shared_ptr<FFmpegContext> makeFakeContext() {
+        auto ctx = std::make_shared<FFmpegContext>();
+        ctx->av_packet_alloc = &fakePacketAlloc;
+        ctx->av_packet_free = &fakePacketFree;
+        ctx->av_packet_unref = &fakePacketUnref;
+        ctx->av_frame_alloc = &fakeFrameAlloc;
+        ctx->av_frame_free = &fakeFrameFree;
+        ctx->av_frame_unref = &fakeFrameUnref;
+        return ctx;
+    }
+
+    int failures = 0;
+
+    void check(bool condition, const char* what) {
+        if (!condition) {
+            std::fprintf(stderr, "FAIL: %s\n", what);
+            failures++;
+        }
+    }
+
+    void testRecycling(const std::shared_ptr<FFmpegContext>& ctx) {
+        AVObjectPool pool(ctx);
+
+        AVFrame* first = nullptr;
+        {
+            AVObjectPool::FramePtr frame = pool.acquireFrame();
+            first = frame.get();
+            frame->width = 1920;
+        }
+        AVObjectPool::FramePtr again = pool.acquireFrame();
+        check(again.get() == first, "returned frame is handed out again");
+        check(again->width == 0, "plain frames are unreferenced on return");
+
+        {
+            AVObjectPool::FramePtr buffered = pool.acquireBufferedFrame();
+            buffered->width = 1280;
+        }
+        {
+            AVObjectPool::FramePtr buffered = pool.acquireBufferedFrame();
+            check(buffered->width == 1280, "buffered frames keep their buffers");
+
+            // Pass-through: the frame references someone else's buffers
+            buffered.get_deleter().unrefOnReturn();
+        }
+        AVObjectPool::FramePtr buffered = pool.acquireBufferedFrame();
+        check(buffered->width == 0, "unrefOnReturn() frames give their buffers back");
+
+        AVObjectPool::Stats stats = pool.getStats();
+        check(stats.framesAllocated == 2, "one plain and one buffered frame allocated");
+        check(stats.reused == 3, "three frames reused");
+    }
+
+    struct Item {
+        AVObjectPool::PacketPtr packet;
+        AVObjectPool::FramePtr frame;
+    };
+
+    void testPipelineStopsAllocating(const std::shared_ptr<FFmpegContext>& ctx) {
+        packetAllocs = 0;
+        frameAllocs = 0;
+
+        AVObjectPool pool(ctx);
+        std::vector<std::unique_ptr<AVObjectPool>> scaledPools;
+        BoundedQueue<AVObjectPool::PacketPtr> decodeQueue(DECODE_QUEUE_CAPACITY);
+        BoundedQueue<AVObjectPool::PacketPtr> muxQueue(MUX_QUEUE_CAPACITY);
+        std::vector<std::unique_ptr<BoundedQueue<AVObjectPool::FramePtr>>> scaleQueues;
+        std::vector<std::unique_ptr<BoundedQueue<AVObjectPool::FramePtr>>> encodeQueues;
+        for (size_t i = 0; i < LANES; i++) {
+            scaledPools.push_back(std::make_unique<AVObjectPool>(ctx));
+            scaleQueues.push_back(std::make_unique<BoundedQueue<AVObjectPool::FramePtr>>(SCALE_QUEUE_CAPACITY));
+            encodeQueues.push_back(std::make_unique<BoundedQueue<AVObjectPool::FramePtr>>(ENCODE_QUEUE_CAPACITY));
+        }
+
+        // decode: packet in, one frame reference per lane out
+        std::thread decodeThread([&]() {
+            AVObjectPool::PacketPtr packet;
+            while (decodeQueue.pop(packet)) {
+                packet.reset();
+                for (size_t i = 0; i < LANES; i++) {
+                    scaleQueues[i]->push(pool.acquireFrame());
+                }
+            }
+            for (auto& queue : scaleQueues) {
+                queue->close();
+            }
+        });
+
+        std::vector<std::thread> laneThreads;
+        std::atomic<size_t> encodersRunning{LANES};
+        for (size_t i = 0; i < LANES; i++) {
+            // scale: every other frame passes through (references the decoded buffers)
+            laneThreads.emplace_back([&, i]() {
+                AVObjectPool::FramePtr frame;
+                bool passThrough = false;
+                while (scaleQueues[i]->pop(frame)) {
+                    AVObjectPool::FramePtr scaled = scaledPools[i]->acquireBufferedFrame();
+                    scaled->width = 640;
+                    if (passThrough) {
+                        scaled.get_deleter().unrefOnReturn();
+                    }
+                    passThrough = !passThrough;
+                    frame.reset();
+                    encodeQueues[i]->push(std::move(scaled));
+                }
+                encodeQueues[i]->close();
+            });
+            // encode: frame in, packet out
+            laneThreads.emplace_back([&, i]() {
+                AVObjectPool::FramePtr frame;
+                while (encodeQueues[i]->pop(frame)) {
+                    frame.reset();
+                    muxQueue.push(pool.acquirePacket());
+                }
+                if (--encodersRunning == 0) {
+                    muxQueue.close();
+                }
+            });
+        }
+
+        std::thread muxThread([&]() {
+            AVObjectPool::PacketPtr packet;
+            while (muxQueue.pop(packet)) {
+                packet.reset();
+            }
+        });
+
+        // demux
+        for (int i = 0; i < FRAMES; i++) {
+            decodeQueue.push(pool.acquirePacket());
+        }
+        decodeQueue.close();
+
+        decodeThread.join();
+        for (std::thread& thread : laneThreads) {
+            thread.join();
+        }
+        muxThread.join();
+
+        // Everything that can be in flight at once: queued items plus one held by each stage
+        const uint64_t packetBound = DECODE_QUEUE_CAPACITY + MUX_QUEUE_CAPACITY + 1 + 1 + 1 + LANES;
+        const uint64_t frameBound = LANES * (SCALE_QUEUE_CAPACITY + 1) + LANES;
+        const uint64_t scaledBound = LANES * (ENCODE_QUEUE_CAPACITY + 2);
+
+        AVObjectPool::Stats stats = pool.getStats();
+        uint64_t scaledAllocated = 0;
+        for (const auto& scaledPool : scaledPools) {
+            scaledAllocated += scaledPool->getStats().framesAllocated;
+        }
+
+        std::printf("%d frames x %zu lanes: %llu packets, %llu frames, %llu scaled frames allocated, %llu reused\n",
+                    FRAMES, LANES,
+                    static_cast<unsigned long long>(stats.packetsAllocated),
+                    static_cast<unsigned long long>(stats.framesAllocated),
+                    static_cast<unsigned long long>(scaledAllocated),
+                    static_cast<unsigned long long>(stats.reused));
+
+        check(packetAllocs == stats.packetsAllocated, "pool counts every av_packet_alloc");
+        check(frameAllocs == stats.framesAllocated + scaledAllocated, "pools count every av_frame_alloc");
+        check(stats.packetsAllocated <= packetBound, "packet allocations stay within the packets in flight");
+        check(stats.framesAllocated <= frameBound, "frame allocations stay within the frames in flight");
+        check(scaledAllocated <= scaledBound, "scaled frame allocations stay within the encode queues");
+    }
+}
+
+int main() {
+    std::shared_ptr<FFmpegContext> ctx = makeFakeContext();
+
+    testRecycling(ctx);
+    testPipelineStopsAllocating(ctx);
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("All AVObjectPool checks passed\n");
+    return 0;
+}